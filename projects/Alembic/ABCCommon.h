@@ -4,17 +4,35 @@
 #include "ABCTree.h"
 #include "Alembic/Abc/IObject.h"
 #include "zeno/ListObject.h"
+#include <mutex>
+#include <map>
+#include <vector>
 
 namespace zeno {
 
+// kept by a reader across frames of the same archive: objects whose schema says their
+// topology is constant are read fully once, only their animated properties after that
+struct ABCReadCache {
+    struct Object {
+        Alembic::AbcGeom::IObject obj;
+        int parent;  // index into objects, -1 for the top
+    };
+    int numStreams = 1;  // > 1 when objects may be read concurrently
+    std::vector<Object> objects;  // the hierarchy under the archive top, depth first
+    std::mutex mtx;
+    std::map<std::string, std::shared_ptr<PrimitiveObject>> prims;  // by full name of the object
+};
+
 extern void traverseABC(
     Alembic::AbcGeom::IObject &obj,
     ABCTree &tree,
     int frameid,
-    bool read_done
+    bool read_done,
+    ABCReadCache *cache = nullptr
 );
 
-extern Alembic::AbcGeom::IArchive readABC(std::string const &path);
+// numStreams: how many threads want to read at once, set to what the archive supports
+extern Alembic::AbcGeom::IArchive readABC(std::string const &path, int *numStreams = nullptr);
 
 extern std::shared_ptr<zeno::ListObject> get_xformed_prims(std::shared_ptr<zeno::ABCTree> abctree);
 
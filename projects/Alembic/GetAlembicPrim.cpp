@@ -8,6 +8,7 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/PrimitiveUtils.h>
 #include <zeno/extra/GlobalState.h>
+#include <zeno/para/thread_pool.h>
 #include "ABCCommon.h"
 #include "ABCTree.h"
 #include <queue>
@@ -288,6 +289,7 @@ ZENDEFNODE(GetAlembicCamera, {
 struct ImportAlembicPrim : INode {
     Alembic::Abc::v12::IArchive archive;
     std::string usedPath;
+    std::unique_ptr<ABCReadCache> cache;
     virtual void apply() override {
         int frameid;
         if (has_input("frameid")) {
@@ -300,13 +302,16 @@ struct ImportAlembicPrim : INode {
             auto path = get_input2<std::string>("path");
             bool read_done = archive.valid() && (path == usedPath);
             if (!read_done) {
-                archive = readABC(path);
+                int numStreams = (int)thread_pool::global().concurrency();
+                archive = readABC(path, &numStreams);
                 usedPath = path;
+                cache = std::make_unique<ABCReadCache>();
+                cache->numStreams = numStreams;
             }
             double start, _end;
             GetArchiveStartAndEndTime(archive, start, _end);
             auto obj = archive.getTop();
-            traverseABC(obj, *abctree, frameid, read_done);
+            traverseABC(obj, *abctree, frameid, read_done, cache.get());
         }
         bool use_xform = get_input2<bool>("use_xform");
         auto index = get_input2<int>("index");
@@ -13,6 +13,9 @@
 #include <Alembic/AbcCoreOgawa/All.h>
 #include <Alembic/AbcCoreHDF5/All.h>
 #include <Alembic/Abc/ErrorHandler.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/thread_pool.h>
+#include "ABCCommon.h"
 #include "ABCTree.h"
 #include <cstring>
 #include <cstdio>
@@ -31,6 +34,17 @@ static int clamp(int i, int _min, int _max) {
     }
 }
 
+template <class Schema>
+static ISampleSelector sampleOfFrame(Schema &schema, int frameid) {
+    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = schema.getTimeSampling();
+    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
+    double start = time->getStoredTimes().front();
+    int start_frame = (int)std::round(start / time_per_cycle );
+
+    int sample_index = clamp(frameid - start_frame, 0, (int)schema.getNumSamples() - 1);
+    return ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
+}
+
 static void read_velocity(std::shared_ptr<PrimitiveObject> prim, V3fArraySamplePtr marr, bool read_done) {
     if (marr == nullptr) {
         return;
@@ -47,7 +61,66 @@ static void read_velocity(std::shared_ptr<PrimitiveObject> prim, V3fArraySampleP
     }
 }
 
-static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProperty arbattrs, const ISampleSelector &iSS, bool read_done) {
+static void read_positions(std::shared_ptr<PrimitiveObject> prim, P3fArraySamplePtr marr) {
+    auto &parr = prim->verts;
+    parr.resize(marr->size());
+    for (size_t i = 0; i < marr->size(); i++) {
+        auto const &val = (*marr)[i];
+        parr[i] = {val[0], val[1], val[2]};
+    }
+}
+
+static void read_normals(std::shared_ptr<PrimitiveObject> prim, IN3fGeomParam nrm, const ISampleSelector &iSS) {
+    auto nrmsamp = nrm.getIndexedValue(iSS);
+    int value_size = (int)nrmsamp.getVals()->size();
+    if (value_size == prim->verts.size()) {
+        auto &nrms = prim->verts.add_attr<vec3f>("nrm");
+        auto marr = nrmsamp.getVals();
+        for (size_t i = 0; i < marr->size(); i++) {
+            auto const &n = (*marr)[i];
+            nrms[i] = {n[0], n[1], n[2]};
+        }
+    }
+}
+
+static void read_uvs(std::shared_ptr<PrimitiveObject> prim, IV2fGeomParam uv, const ISampleSelector &iSS, bool read_done) {
+    auto uvsamp = uv.getIndexedValue(iSS);
+    int value_size = (int)uvsamp.getVals()->size();
+    int index_size = (int)uvsamp.getIndices()->size();
+    if (!read_done) {
+        log_debug("[alembic] totally {} uv value", value_size);
+        log_debug("[alembic] totally {} uv indices", index_size);
+        if (prim->loops.size() == index_size) {
+            log_debug("[alembic] uv per face");
+        } else if (prim->verts.size() == index_size) {
+            log_debug("[alembic] uv per vertex");
+        } else {
+            log_error("[alembic] error uv indices");
+        }
+    }
+    prim->uvs.resize(value_size);
+    {
+        auto marr = uvsamp.getVals();
+        for (size_t i = 0; i < marr->size(); i++) {
+            auto const &val = (*marr)[i];
+            prim->uvs[i] = {val[0], val[1]};
+        }
+    }
+    if (prim->loops.size() == index_size) {
+        prim->loops.add_attr<int>("uvs");
+        for (auto i = 0; i < prim->loops.size(); i++) {
+            prim->loops.attr<int>("uvs")[i] = (*uvsamp.getIndices())[i];
+        }
+    }
+    else if (prim->verts.size() == index_size) {
+        prim->loops.add_attr<int>("uvs");
+        for (auto i = 0; i < prim->loops.size(); i++) {
+            prim->loops.attr<int>("uvs")[i] = prim->loops[i];
+        }
+    }
+}
+
+static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProperty arbattrs, const ISampleSelector &iSS, bool read_done, bool animatedOnly = false) {
     if (!arbattrs) {
         return;
     }
@@ -56,6 +129,8 @@ static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProp
         PropertyHeader p = arbattrs.getPropertyHeader(i);
         if (IFloatGeomParam::matches(p)) {
             IFloatGeomParam param(arbattrs, p.getName());
+            if (animatedOnly && param.isConstant())
+                continue;
 
             IFloatGeomParam::Sample samp = param.getIndexedValue(iSS);
             std::vector<float> data;
@@ -87,6 +162,8 @@ static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProp
         }
         else if (IInt32GeomParam::matches(p)) {
             IInt32GeomParam param(arbattrs, p.getName());
+            if (animatedOnly && param.isConstant())
+                continue;
 
             IInt32GeomParam::Sample samp = param.getIndexedValue(iSS);
             std::vector<int> data;
@@ -112,6 +189,8 @@ static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProp
         }
         else if (IV3fGeomParam::matches(p)) {
             IV3fGeomParam param(arbattrs, p.getName());
+            if (animatedOnly && param.isConstant())
+                continue;
             if (!read_done) {
                 log_info("[alembic] vec3f attr {}.", p.getName());
             }
@@ -129,6 +208,8 @@ static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProp
                 log_info("[alembic] IN3fGeomParam attr {}.", p.getName());
             }
             IN3fGeomParam param(arbattrs, p.getName());
+            if (animatedOnly && param.isConstant())
+                continue;
             IN3fGeomParam::Sample samp = param.getIndexedValue(iSS);
             if (prim->verts.size() == samp.getVals()->size()) {
                 auto &attr = prim->add_attr<zeno::vec3f>(p.getName());
@@ -143,6 +224,8 @@ static void read_attributes(std::shared_ptr<PrimitiveObject> prim, ICompoundProp
                 log_info("[alembic] IC3fGeomParam attr {}.", p.getName());
             }
             IC3fGeomParam param(arbattrs, p.getName());
+            if (animatedOnly && param.isConstant())
+                continue;
             IC3fGeomParam::Sample samp = param.getIndexedValue(iSS);
             if (prim->verts.size() == samp.getVals()->size()) {
                 auto &attr = prim->add_attr<zeno::vec3f>(p.getName());
@@ -220,39 +303,19 @@ static void read_user_data(std::shared_ptr<PrimitiveObject> prim, ICompoundPrope
 static std::shared_ptr<PrimitiveObject> foundABCMesh(Alembic::AbcGeom::IPolyMeshSchema &mesh, int frameid, bool read_done) {
     auto prim = std::make_shared<PrimitiveObject>();
 
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = mesh.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-
-    int sample_index = clamp(frameid - start_frame, 0, (int)mesh.getNumSamples() - 1);
-    ISampleSelector iSS = Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
+    ISampleSelector iSS = sampleOfFrame(mesh, frameid);
     Alembic::AbcGeom::IPolyMeshSchema::Sample mesamp = mesh.getValue(iSS);
 
     if (auto marr = mesamp.getPositions()) {
         if (!read_done) {
             log_debug("[alembic] totally {} positions", marr->size());
         }
-        auto &parr = prim->verts;
-        for (size_t i = 0; i < marr->size(); i++) {
-            auto const &val = (*marr)[i];
-            parr.emplace_back(val[0], val[1], val[2]);
-        }
+        read_positions(prim, marr);
     }
 
     read_velocity(prim, mesamp.getVelocities(), read_done);
     if (auto nrm = mesh.getNormalsParam()) {
-        auto nrmsamp =
-                nrm.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
-        int value_size = (int)nrmsamp.getVals()->size();
-        if (value_size == prim->verts.size()) {
-            auto &nrms = prim->verts.add_attr<vec3f>("nrm");
-            auto marr = nrmsamp.getVals();
-            for (size_t i = 0; i < marr->size(); i++) {
-                auto const &n = (*marr)[i];
-                nrms[i] = {n[0], n[1], n[2]};
-            }
-        }
+        read_normals(prim, nrm, iSS);
     }
 
     if (auto marr = mesamp.getFaceIndices()) {
@@ -280,41 +343,7 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(Alembic::AbcGeom::IPolyMesh
         }
     }
     if (auto uv = mesh.getUVsParam()) {
-        auto uvsamp =
-            uv.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
-        int value_size = (int)uvsamp.getVals()->size();
-        int index_size = (int)uvsamp.getIndices()->size();
-        if (!read_done) {
-            log_debug("[alembic] totally {} uv value", value_size);
-            log_debug("[alembic] totally {} uv indices", index_size);
-            if (prim->loops.size() == index_size) {
-                log_debug("[alembic] uv per face");
-            } else if (prim->verts.size() == index_size) {
-                log_debug("[alembic] uv per vertex");
-            } else {
-                log_error("[alembic] error uv indices");
-            }
-        }
-        prim->uvs.resize(value_size);
-        {
-            auto marr = uvsamp.getVals();
-            for (size_t i = 0; i < marr->size(); i++) {
-                auto const &val = (*marr)[i];
-                prim->uvs[i] = {val[0], val[1]};
-            }
-        }
-        if (prim->loops.size() == index_size) {
-            prim->loops.add_attr<int>("uvs");
-            for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = (*uvsamp.getIndices())[i];
-            }
-        }
-        else if (prim->verts.size() == index_size) {
-            prim->loops.add_attr<int>("uvs");
-            for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = prim->loops[i];
-            }
-        }
+        read_uvs(prim, uv, iSS, read_done);
     }
     if (!prim->loops.has_attr("uvs")) {
         if (!read_done) {
@@ -338,24 +367,14 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(Alembic::AbcGeom::IPolyMesh
 static std::shared_ptr<PrimitiveObject> foundABCSubd(Alembic::AbcGeom::ISubDSchema &subd, int frameid, bool read_done) {
     auto prim = std::make_shared<PrimitiveObject>();
 
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = subd.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-
-    int sample_index = clamp(frameid - start_frame, 0, (int)subd.getNumSamples() - 1);
-    ISampleSelector iSS = Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
+    ISampleSelector iSS = sampleOfFrame(subd, frameid);
     Alembic::AbcGeom::ISubDSchema::Sample mesamp = subd.getValue(iSS);
 
     if (auto marr = mesamp.getPositions()) {
         if (!read_done) {
             log_debug("[alembic] totally {} positions", marr->size());
         }
-        auto &parr = prim->verts;
-        for (size_t i = 0; i < marr->size(); i++) {
-            auto const &val = (*marr)[i];
-            parr.emplace_back(val[0], val[1], val[2]);
-        }
+        read_positions(prim, marr);
     }
 
     read_velocity(prim, mesamp.getVelocities(), read_done);
@@ -385,41 +404,7 @@ static std::shared_ptr<PrimitiveObject> foundABCSubd(Alembic::AbcGeom::ISubDSche
         }
     }
     if (auto uv = subd.getUVsParam()) {
-        auto uvsamp =
-            uv.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
-        int value_size = (int)uvsamp.getVals()->size();
-        int index_size = (int)uvsamp.getIndices()->size();
-        if (!read_done) {
-            log_debug("[alembic] totally {} uv value", value_size);
-            log_debug("[alembic] totally {} uv indices", index_size);
-            if (prim->loops.size() == index_size) {
-                log_debug("[alembic] uv per face");
-            } else if (prim->verts.size() == index_size) {
-                log_debug("[alembic] uv per vertex");
-            } else {
-                log_error("[alembic] error uv indices");
-            }
-        }
-        prim->uvs.resize(value_size);
-        {
-            auto marr = uvsamp.getVals();
-            for (size_t i = 0; i < marr->size(); i++) {
-                auto const &val = (*marr)[i];
-                prim->uvs[i] = {val[0], val[1]};
-            }
-        }
-        if (prim->loops.size() == index_size) {
-            prim->loops.add_attr<int>("uvs");
-            for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = (*uvsamp.getIndices())[i];
-            }
-        }
-        else if (prim->verts.size() == index_size) {
-            prim->loops.add_attr<int>("uvs");
-            for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = prim->loops[i];
-            }
-        }
+        read_uvs(prim, uv, iSS, read_done);
     }
     if (!prim->loops.has_attr("uvs")) {
         if (!read_done) {
@@ -442,13 +427,9 @@ static std::shared_ptr<PrimitiveObject> foundABCSubd(Alembic::AbcGeom::ISubDSche
 
 static std::shared_ptr<CameraInfo> foundABCCamera(Alembic::AbcGeom::ICameraSchema &cam, int frameid) {
     CameraInfo cam_info;
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = cam.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-    int sample_index = clamp(frameid - start_frame, 0, (int)cam.getNumSamples() - 1);
+    ISampleSelector iSS = sampleOfFrame(cam, frameid);
 
-    auto samp = cam.getValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
+    auto samp = cam.getValue(iSS);
     cam_info.focal_length = samp.getFocalLength();
     cam_info._near = samp.getNearClippingPlane();
     cam_info._far = samp.getFarClippingPlane();
@@ -464,36 +445,22 @@ static std::shared_ptr<CameraInfo> foundABCCamera(Alembic::AbcGeom::ICameraSchem
 }
 
 static Alembic::Abc::v12::M44d foundABCXform(Alembic::AbcGeom::IXformSchema &xfm, int frameid) {
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = xfm.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-    int sample_index = clamp(frameid - start_frame, 0, (int)xfm.getNumSamples() - 1);
+    ISampleSelector iSS = sampleOfFrame(xfm, frameid);
 
-    auto samp = xfm.getValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
+    auto samp = xfm.getValue(iSS);
     return samp.getMatrix();
 }
 
 static std::shared_ptr<PrimitiveObject> foundABCPoints(Alembic::AbcGeom::IPointsSchema &mesh, int frameid, bool read_done) {
     auto prim = std::make_shared<PrimitiveObject>();
 
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = mesh.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-
-    int sample_index = clamp(frameid - start_frame, 0, (int)mesh.getNumSamples() - 1);
-    auto iSS = Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
+    ISampleSelector iSS = sampleOfFrame(mesh, frameid);
     Alembic::AbcGeom::IPointsSchema::Sample mesamp = mesh.getValue(iSS);
     if (auto marr = mesamp.getPositions()) {
         if (!read_done) {
             log_info("[alembic] totally {} positions", marr->size());
         }
-        auto &parr = prim->verts;
-        for (size_t i = 0; i < marr->size(); i++) {
-            auto const &val = (*marr)[i];
-            parr.emplace_back(val[0], val[1], val[2]);
-        }
+        read_positions(prim, marr);
     }
     read_velocity(prim, mesamp.getVelocities(), read_done);
     ICompoundProperty arbattrs = mesh.getArbGeomParams();
@@ -506,23 +473,13 @@ static std::shared_ptr<PrimitiveObject> foundABCPoints(Alembic::AbcGeom::IPoints
 static std::shared_ptr<PrimitiveObject> foundABCCurves(Alembic::AbcGeom::ICurvesSchema &mesh, int frameid, bool read_done) {
     auto prim = std::make_shared<PrimitiveObject>();
 
-    std::shared_ptr<Alembic::AbcCoreAbstract::v12::TimeSampling> time = mesh.getTimeSampling();
-    float time_per_cycle =  time->getTimeSamplingType().getTimePerCycle();
-    double start = time->getStoredTimes().front();
-    int start_frame = (int)std::round(start / time_per_cycle );
-
-    int sample_index = clamp(frameid - start_frame, 0, (int)mesh.getNumSamples() - 1);
-    auto iSS = Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
+    ISampleSelector iSS = sampleOfFrame(mesh, frameid);
     Alembic::AbcGeom::ICurvesSchema::Sample mesamp = mesh.getValue(iSS);
     if (auto marr = mesamp.getPositions()) {
         if (!read_done) {
             log_info("[alembic] totally {} positions", marr->size());
         }
-        auto &parr = prim->verts;
-        for (size_t i = 0; i < marr->size(); i++) {
-            auto const &val = (*marr)[i];
-            parr.emplace_back(val[0], val[1], val[2]);
-        }
+        read_positions(prim, marr);
     }
     read_velocity(prim, mesamp.getVelocities(), read_done);
     {
@@ -544,68 +501,140 @@ static std::shared_ptr<PrimitiveObject> foundABCCurves(Alembic::AbcGeom::ICurves
     return prim;
 }
 
-void traverseABC(
+static bool hasStaticTopology(IPolyMeshSchema &schema) {
+    return schema.getTopologyVariance() != kHeterogeneousTopology;
+}
+
+static bool hasStaticTopology(ISubDSchema &schema) {
+    return schema.getTopologyVariance() != kHeterogeneousTopology;
+}
+
+static bool hasStaticTopology(ICurvesSchema &schema) {
+    return schema.getTopologyVariance() != kHeterogeneousTopology;
+}
+
+static bool hasStaticTopology(IPointsSchema &schema) {
+    // the point count may change with every sample
+    return schema.isConstant();
+}
+
+template <class Schema>
+static void readAnimated(std::shared_ptr<PrimitiveObject> prim, Schema &schema, int frameid) {
+    ISampleSelector iSS = sampleOfFrame(schema, frameid);
+    if (auto pos = schema.getPositionsProperty(); !pos.isConstant()) {
+        read_positions(prim, pos.getValue(iSS));
+    }
+    if (auto vel = schema.getVelocitiesProperty(); vel.valid() && !vel.isConstant()) {
+        read_velocity(prim, vel.getValue(iSS), true);
+    }
+    if constexpr (std::is_same_v<Schema, IPolyMeshSchema>) {
+        if (auto nrm = schema.getNormalsParam(); nrm.valid() && !nrm.isConstant()) {
+            read_normals(prim, nrm, iSS);
+        }
+    }
+    if constexpr (std::is_same_v<Schema, IPolyMeshSchema> || std::is_same_v<Schema, ISubDSchema>) {
+        if (auto uv = schema.getUVsParam(); uv.valid() && !uv.isConstant()) {
+            read_uvs(prim, uv, iSS, true);
+        }
+    }
+    read_attributes(prim, schema.getArbGeomParams(), iSS, true, true);
+    read_user_data(prim, schema.getUserProperties(), iSS, true);
+}
+
+template <class Schema, class Found>
+static std::shared_ptr<PrimitiveObject> readCached(ABCReadCache *cache, std::string const &key, Schema &schema, int frameid, bool read_done, Found found) {
+    if (!cache || !hasStaticTopology(schema)) {
+        return found(schema, frameid, read_done);
+    }
+    std::shared_ptr<PrimitiveObject> cached;
+    {
+        std::lock_guard lck(cache->mtx);
+        if (auto it = cache->prims.find(key); it != cache->prims.end())
+            cached = it->second;
+    }
+    if (!cached) {
+        cached = found(schema, frameid, read_done);
+        std::lock_guard lck(cache->mtx);
+        cache->prims.emplace(key, cached);
+        return std::make_shared<PrimitiveObject>(*cached);
+    }
+    // the cached prim is never handed out, so nodes downstream may modify theirs
+    auto prim = std::make_shared<PrimitiveObject>(*cached);
+    // arbitrary params may still be animated when the schema itself is constant
+    readAnimated(prim, schema, frameid);
+    return prim;
+}
+
+static void readABCObject(
     Alembic::AbcGeom::IObject &obj,
     ABCTree &tree,
     int frameid,
-    bool read_done
+    bool read_done,
+    ABCReadCache *cache
 ) {
-    {
-        auto const &md = obj.getMetaData();
+    auto const &md = obj.getMetaData();
+    if (!read_done) {
+        log_debug("[alembic] meta data: [{}]", md.serialize());
+    }
+
+    if (Alembic::AbcGeom::IPolyMesh::matches(md)) {
         if (!read_done) {
-            log_debug("[alembic] meta data: [{}]", md.serialize());
+            log_debug("[alembic] found a mesh [{}]", obj.getName());
         }
-        tree.name = obj.getName();
 
-        if (Alembic::AbcGeom::IPolyMesh::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found a mesh [{}]", obj.getName());
-            }
-
-            Alembic::AbcGeom::IPolyMesh meshy(obj);
-            auto &mesh = meshy.getSchema();
-            tree.prim = foundABCMesh(mesh, frameid, read_done);
-            tree.prim->userData().set2("_abc_name", obj.getName());
-        } else if (Alembic::AbcGeom::IXformSchema::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found a Xform [{}]", obj.getName());
-            }
-            Alembic::AbcGeom::IXform xfm(obj);
-            auto &cam_sch = xfm.getSchema();
-            tree.xform = foundABCXform(cam_sch, frameid);
-        } else if (Alembic::AbcGeom::ICameraSchema::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found a Camera [{}]", obj.getName());
-            }
-            Alembic::AbcGeom::ICamera cam(obj);
-            auto &cam_sch = cam.getSchema();
-            tree.camera_info = foundABCCamera(cam_sch, frameid);
-        } else if(Alembic::AbcGeom::IPointsSchema::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found points [{}]", obj.getName());
-            }
-            Alembic::AbcGeom::IPoints points(obj);
-            auto &points_sch = points.getSchema();
-            tree.prim = foundABCPoints(points_sch, frameid, read_done);
-            tree.prim->userData().set2("_abc_name", obj.getName());
-        } else if(Alembic::AbcGeom::ICurvesSchema::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found curves [{}]", obj.getName());
-            }
-            Alembic::AbcGeom::ICurves curves(obj);
-            auto &curves_sch = curves.getSchema();
-            tree.prim = foundABCCurves(curves_sch, frameid, read_done);
-            tree.prim->userData().set2("_abc_name", obj.getName());
-        } else if (Alembic::AbcGeom::ISubDSchema::matches(md)) {
-            if (!read_done) {
-                log_debug("[alembic] found SubD [{}]", obj.getName());
-            }
-            Alembic::AbcGeom::ISubD subd(obj);
-            auto &subd_sch = subd.getSchema();
-            tree.prim = foundABCSubd(subd_sch, frameid, read_done);
-            tree.prim->userData().set2("_abc_name", obj.getName());
+        Alembic::AbcGeom::IPolyMesh meshy(obj);
+        auto &mesh = meshy.getSchema();
+        tree.prim = readCached(cache, obj.getFullName(), mesh, frameid, read_done, foundABCMesh);
+        tree.prim->userData().set2("_abc_name", obj.getName());
+    } else if (Alembic::AbcGeom::IXformSchema::matches(md)) {
+        if (!read_done) {
+            log_debug("[alembic] found a Xform [{}]", obj.getName());
+        }
+        Alembic::AbcGeom::IXform xfm(obj);
+        auto &cam_sch = xfm.getSchema();
+        tree.xform = foundABCXform(cam_sch, frameid);
+    } else if (Alembic::AbcGeom::ICameraSchema::matches(md)) {
+        if (!read_done) {
+            log_debug("[alembic] found a Camera [{}]", obj.getName());
+        }
+        Alembic::AbcGeom::ICamera cam(obj);
+        auto &cam_sch = cam.getSchema();
+        tree.camera_info = foundABCCamera(cam_sch, frameid);
+    } else if(Alembic::AbcGeom::IPointsSchema::matches(md)) {
+        if (!read_done) {
+            log_debug("[alembic] found points [{}]", obj.getName());
+        }
+        Alembic::AbcGeom::IPoints points(obj);
+        auto &points_sch = points.getSchema();
+        tree.prim = readCached(cache, obj.getFullName(), points_sch, frameid, read_done, foundABCPoints);
+        tree.prim->userData().set2("_abc_name", obj.getName());
+    } else if(Alembic::AbcGeom::ICurvesSchema::matches(md)) {
+        if (!read_done) {
+            log_debug("[alembic] found curves [{}]", obj.getName());
+        }
+        Alembic::AbcGeom::ICurves curves(obj);
+        auto &curves_sch = curves.getSchema();
+        tree.prim = readCached(cache, obj.getFullName(), curves_sch, frameid, read_done, foundABCCurves);
+        tree.prim->userData().set2("_abc_name", obj.getName());
+    } else if (Alembic::AbcGeom::ISubDSchema::matches(md)) {
+        if (!read_done) {
+            log_debug("[alembic] found SubD [{}]", obj.getName());
         }
+        Alembic::AbcGeom::ISubD subd(obj);
+        auto &subd_sch = subd.getSchema();
+        tree.prim = readCached(cache, obj.getFullName(), subd_sch, frameid, read_done, foundABCSubd);
+        tree.prim->userData().set2("_abc_name", obj.getName());
     }
+}
+
+static void collectABC(
+    Alembic::AbcGeom::IObject &obj,
+    int parent,
+    std::vector<ABCReadCache::Object> &objects,
+    bool read_done
+) {
+    int self = (int)objects.size();
+    objects.push_back({obj, parent});
 
     size_t nch = obj.getNumChildren();
     if (!read_done) {
@@ -619,14 +648,49 @@ void traverseABC(
         }
 
         Alembic::AbcGeom::IObject child(obj, name);
+        collectABC(child, self, objects, read_done);
+    }
+}
+
+void traverseABC(
+    Alembic::AbcGeom::IObject &obj,
+    ABCTree &tree,
+    int frameid,
+    bool read_done,
+    ABCReadCache *cache
+) {
+    std::vector<ABCReadCache::Object> local;
+    auto &objects = cache ? cache->objects : local;
+    if (objects.empty()) {
+        collectABC(obj, -1, objects, read_done);
+    }
+
+    std::vector<ABCTree *> trees(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (objects[i].parent < 0) {
+            trees[i] = &tree;
+        } else {
+            auto childTree = std::make_shared<ABCTree>();
+            trees[i] = childTree.get();
+            trees[objects[i].parent]->children.push_back(std::move(childTree));
+        }
+        trees[i]->name = objects[i].obj.getName();
+    }
 
-        auto childTree = std::make_shared<ABCTree>();
-        traverseABC(child, *childTree, frameid, read_done);
-        tree.children.push_back(std::move(childTree));
+    auto read = [&] (size_t i) {
+        readABCObject(objects[i].obj, *trees[i], frameid, read_done, cache);
+    };
+    if (cache && cache->numStreams > 1) {
+        // objects are independent, one each is the finest grain worth it
+        parallel_for((size_t)0, objects.size(), read, 1);
+    } else {
+        for (size_t i = 0; i < objects.size(); i++) {
+            read(i);
+        }
     }
 }
 
-Alembic::AbcGeom::IArchive readABC(std::string const &path) {
+Alembic::AbcGeom::IArchive readABC(std::string const &path, int *numStreams) {
     std::string native_path = std::filesystem::u8path(path).string();
     std::string hdr;
     {
@@ -641,10 +705,13 @@ Alembic::AbcGeom::IArchive readABC(std::string const &path) {
     }
     if (hdr == "\x89HDF") {
         log_info("[alembic] opening as HDF5 format");
+        // HDF5 isn't safe to be read from several threads
+        if (numStreams)
+            *numStreams = 1;
         return {Alembic::AbcCoreHDF5::ReadArchive(), native_path};
     } else if (hdr == "Ogaw") {
         log_info("[alembic] opening as Ogawa format");
-        return {Alembic::AbcCoreOgawa::ReadArchive(), native_path};
+        return {Alembic::AbcCoreOgawa::ReadArchive(numStreams ? std::max(*numStreams, 1) : 1), native_path};
     } else {
         throw Exception("[alembic] unrecognized ABC header: [" + hdr + "]");
     }
@@ -654,6 +721,7 @@ struct ReadAlembic : INode {
     Alembic::Abc::v12::IArchive archive;
     std::string usedPath;
     bool read_done = false;
+    std::unique_ptr<ABCReadCache> cache;
     virtual void apply() override {
         int frameid;
         if (has_input("frameid")) {
@@ -668,14 +736,17 @@ struct ReadAlembic : INode {
                 read_done = false;
             }
             if (read_done == false) {
-                archive = readABC(path);
+                int numStreams = (int)thread_pool::global().concurrency();
+                archive = readABC(path, &numStreams);
+                cache = std::make_unique<ABCReadCache>();
+                cache->numStreams = numStreams;
             }
             double start, _end;
             GetArchiveStartAndEndTime(archive, start, _end);
             // fmt::print("GetArchiveStartAndEndTime: {}\n", start);
             // fmt::print("archive.getNumTimeSamplings: {}\n", archive.getNumTimeSamplings());
             auto obj = archive.getTop();
-            traverseABC(obj, *abctree, frameid, read_done);
+            traverseABC(obj, *abctree, frameid, read_done, cache.get());
             read_done = true;
             usedPath = path;
         }
@@ -5,12 +5,22 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/UserData.h>
 #include <zeno/extra/GlobalState.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/log.h>
 #include <Alembic/AbcGeom/All.h>
 #include <Alembic/AbcCoreAbstract/All.h>
 #include <Alembic/AbcCoreOgawa/All.h>
 #include <Alembic/Abc/ErrorHandler.h>
 #include "ABCTree.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <numeric>
+#include <utility>
+#include <thread>
+#include <deque>
+#include <mutex>
 
 using namespace Alembic::AbcGeom;
 namespace zeno {
@@ -32,150 +42,265 @@ static void write_normal(std::shared_ptr<PrimitiveObject> prim, OPolyMeshSchema:
     }
 }
 
+/* Writes the samples of one archive on its own thread, in push() order, so
+ * the simulation goes on while Ogawa serializes the previous frames. push()
+ * blocks while ZENO_ALEMBIC_QUEUE samples (default 2) are already pending.
+ * The first error of a sample is thrown again by the next push() or wait().
+ */
+struct AbcSampleWriter {
+    AbcSampleWriter()
+        : m_maxPending(std::max(1, envconfig::getInt("ALEMBIC_QUEUE", 2)))
+        , m_thread([this] { worker(); })
+    {}
+
+    ~AbcSampleWriter() {
+        {
+            std::lock_guard lck(m_mtx);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+        if (m_error) {
+            try {
+                std::rethrow_exception(m_error);
+            } catch (std::exception const &e) {
+                log_error("[alembic] failed to write sample: {}", e.what());
+            }
+        }
+    }
+
+    AbcSampleWriter(AbcSampleWriter const &) = delete;
+    AbcSampleWriter &operator=(AbcSampleWriter const &) = delete;
+
+    void push(std::function<void()> job) {
+        std::unique_lock lck(m_mtx);
+        m_cv.wait(lck, [&] { return m_npending < m_maxPending; });
+        rethrowError();
+        m_npending++;
+        m_queue.push_back(std::move(job));
+        lck.unlock();
+        m_cv.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock lck(m_mtx);
+        m_cv.wait(lck, [&] { return m_npending == 0; });
+        rethrowError();
+    }
+
+private:
+    std::size_t m_maxPending;
+    std::deque<std::function<void()>> m_queue;
+    std::size_t m_npending = 0;
+    std::exception_ptr m_error;
+    bool m_stop = false;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::thread m_thread;  // last, started once the rest is constructed
+
+    void rethrowError() {
+        if (m_error)
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+    void worker() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lck(m_mtx);
+                // pending samples are still written when stopping
+                m_cv.wait(lck, [&] { return m_stop || !m_queue.empty(); });
+                if (m_queue.empty())
+                    return;
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            std::exception_ptr error;
+            try {
+                job();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            job = nullptr;  // release the snapshot before anyone is told there is room
+            {
+                std::lock_guard lck(m_mtx);
+                if (error && !m_error)
+                    m_error = error;
+                m_npending--;
+            }
+            m_cv.notify_all();
+        }
+    }
+};
+
 struct WriteAlembic : INode {
     OArchive archive;
     OPolyMesh meshyObj;
-    virtual void apply() override {
-        bool flipFrontBack = get_param<int>("flipFrontBack");
-        int frameid;
-        if (has_input("frameid")) {
-            frameid = get_param<int>("frameid");
-        } else {
-            frameid = getGlobalState()->frameid;
-        }
-        int frame_start = get_param<int>("frame_start");
-        int frame_end = get_param<int>("frame_end");
-        if (frameid == frame_start) {
-            std::string path = get_param<std::string>("path");
-            archive = {Alembic::AbcCoreOgawa::WriteArchive(), path};
-            archive.addTimeSampling(TimeSampling(1.0/24, frame_start / 24.0));
-            meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
-        }
-        auto prim = get_input<PrimitiveObject>("prim");
-        if (frame_start <= frameid && frameid <= frame_end) {
-            // Create a PolyMesh class.
-            OPolyMeshSchema &mesh = meshyObj.getSchema();
-            mesh.setTimeSampling(1);
+    std::unique_ptr<AbcSampleWriter> writer;  // last, so it finishes before the archive is closed
 
-            // some apps can arbitrarily name their primary UVs, this function allows
-            // you to do that, and must be done before the first time you set UVs
-            // on the schema
-            mesh.setUVSourceName("main_uv");
+    void writeSample(std::shared_ptr<PrimitiveObject> prim, bool flipFrontBack) {
+        // Create a PolyMesh class.
+        OPolyMeshSchema &mesh = meshyObj.getSchema();
+        mesh.setTimeSampling(1);
 
-            // Set a mesh sample.
-            // We're creating the sample inline here,
-            // but we could create a static sample and leave it around,
-            // only modifying the parts that have changed.
-            std::vector<int32_t> vertex_index_per_face;
-            std::vector<int32_t> vertex_count_per_face;
+        // some apps can arbitrarily name their primary UVs, this function allows
+        // you to do that, and must be done before the first time you set UVs
+        // on the schema
+        mesh.setUVSourceName("main_uv");
 
-            if (prim->loops.size()) {
+        // Set a mesh sample.
+        // We're creating the sample inline here,
+        // but we could create a static sample and leave it around,
+        // only modifying the parts that have changed.
+        std::vector<int32_t> vertex_index_per_face;
+        std::vector<int32_t> vertex_count_per_face;
+
+        if (prim->loops.size()) {
+            for (const auto& [start, size]: prim->polys) {
+                for (auto i = 0; i < size; i++) {
+                    vertex_index_per_face.push_back(prim->loops[start + i]);
+                }
+                auto base = vertex_index_per_face.size() - size;
+                if (flipFrontBack) {
+                    for (int j = 0; j < (size / 2); j++) {
+                        std::swap(vertex_index_per_face[base + j], vertex_index_per_face[base + size - 1 - j]);
+                    }
+                }
+                vertex_count_per_face.push_back(size);
+            }
+            if (prim->loops.has_attr("uvs")) {
+                std::vector<zeno::vec2f> uv_data;
+                for (const auto& uv: prim->uvs) {
+                    uv_data.push_back(uv);
+                }
+                std::vector<uint32_t> uv_indices;
                 for (const auto& [start, size]: prim->polys) {
                     for (auto i = 0; i < size; i++) {
-                        vertex_index_per_face.push_back(prim->loops[start + i]);
+                        auto uv_index = prim->loops.attr<int>("uvs")[start + i];
+                        uv_indices.push_back(uv_index);
                     }
-                    auto base = vertex_index_per_face.size() - size;
+                    auto base = uv_indices.size() - size;
                     if (flipFrontBack) {
                         for (int j = 0; j < (size / 2); j++) {
-                            std::swap(vertex_index_per_face[base + j], vertex_index_per_face[base + size - 1 - j]);
+                            std::swap(uv_indices[base + j], uv_indices[base + size - 1 - j]);
                         }
                     }
-                    vertex_count_per_face.push_back(size);
                 }
-                if (prim->loops.has_attr("uvs")) {
-                    std::vector<zeno::vec2f> uv_data;
-                    for (const auto& uv: prim->uvs) {
-                        uv_data.push_back(uv);
-                    }
-                    std::vector<uint32_t> uv_indices;
-                    for (const auto& [start, size]: prim->polys) {
-                        for (auto i = 0; i < size; i++) {
-                            auto uv_index = prim->loops.attr<int>("uvs")[start + i];
-                            uv_indices.push_back(uv_index);
-                        }
-                        auto base = uv_indices.size() - size;
-                        if (flipFrontBack) {
-                            for (int j = 0; j < (size / 2); j++) {
-                                std::swap(uv_indices[base + j], uv_indices[base + size - 1 - j]);
-                            }
-                        }
-                    }
-                    // UVs and Normals use GeomParams, which can be written or read
-                    // as indexed or not, as you'd like.
-                    OV2fGeomParam::Sample uvsamp;
-                    uvsamp.setVals(V2fArraySample( (const V2f *)uv_data.data(), uv_data.size()));
-                    uvsamp.setIndices(UInt32ArraySample( uv_indices.data(), uv_indices.size() ));
-                    uvsamp.setScope(kFacevaryingScope);
-                    OPolyMeshSchema::Sample mesh_samp(
-                    V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
-                            Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
-                            Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ),
-                            uvsamp);
+                // UVs and Normals use GeomParams, which can be written or read
+                // as indexed or not, as you'd like.
+                OV2fGeomParam::Sample uvsamp;
+                uvsamp.setVals(V2fArraySample( (const V2f *)uv_data.data(), uv_data.size()));
+                uvsamp.setIndices(UInt32ArraySample( uv_indices.data(), uv_indices.size() ));
+                uvsamp.setScope(kFacevaryingScope);
+                OPolyMeshSchema::Sample mesh_samp(
+                V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
+                        Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
+                        Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ),
+                        uvsamp);
 
-                    mesh.set( mesh_samp );
+                mesh.set( mesh_samp );
+            }
+            else {
+                OPolyMeshSchema::Sample mesh_samp(
+                V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
+                        Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
+                        Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
+                mesh.set( mesh_samp );
+            }
+        }
+        else {
+            for (auto i = 0; i < prim->tris.size(); i++) {
+                vertex_index_per_face.push_back(prim->tris[i][0]);
+                if (flipFrontBack) {
+                    vertex_index_per_face.push_back(prim->tris[i][2]);
+                    vertex_index_per_face.push_back(prim->tris[i][1]);
                 }
                 else {
-                    OPolyMeshSchema::Sample mesh_samp(
-                    V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
-                            Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
-                            Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
-                    mesh.set( mesh_samp );
+                    vertex_index_per_face.push_back(prim->tris[i][1]);
+                    vertex_index_per_face.push_back(prim->tris[i][2]);
                 }
             }
-            else {
+            vertex_count_per_face.resize(prim->tris.size(), 3);
+            if (prim->tris.has_attr("uv0")) {
+                std::vector<zeno::vec2f> uv_data;
+                std::vector<uint32_t> uv_indices;
+                auto& uv0 = prim->tris.attr<zeno::vec3f>("uv0");
+                auto& uv1 = prim->tris.attr<zeno::vec3f>("uv1");
+                auto& uv2 = prim->tris.attr<zeno::vec3f>("uv2");
                 for (auto i = 0; i < prim->tris.size(); i++) {
-                    vertex_index_per_face.push_back(prim->tris[i][0]);
+                    uv_data.emplace_back(uv0[i][0], uv0[i][1]);
                     if (flipFrontBack) {
-                        vertex_index_per_face.push_back(prim->tris[i][2]);
-                        vertex_index_per_face.push_back(prim->tris[i][1]);
+                        uv_data.emplace_back(uv2[i][0], uv2[i][1]);
+                        uv_data.emplace_back(uv1[i][0], uv1[i][1]);
                     }
                     else {
-                        vertex_index_per_face.push_back(prim->tris[i][1]);
-                        vertex_index_per_face.push_back(prim->tris[i][2]);
+                        uv_data.emplace_back(uv1[i][0], uv1[i][1]);
+                        uv_data.emplace_back(uv2[i][0], uv2[i][1]);
                     }
+                    uv_indices.push_back(uv_indices.size());
+                    uv_indices.push_back(uv_indices.size());
+                    uv_indices.push_back(uv_indices.size());
                 }
-                vertex_count_per_face.resize(prim->tris.size(), 3);
-                if (prim->tris.has_attr("uv0")) {
-                    std::vector<zeno::vec2f> uv_data;
-                    std::vector<uint32_t> uv_indices;
-                    auto& uv0 = prim->tris.attr<zeno::vec3f>("uv0");
-                    auto& uv1 = prim->tris.attr<zeno::vec3f>("uv1");
-                    auto& uv2 = prim->tris.attr<zeno::vec3f>("uv2");
-                    for (auto i = 0; i < prim->tris.size(); i++) {
-                        uv_data.emplace_back(uv0[i][0], uv0[i][1]);
-                        if (flipFrontBack) {
-                            uv_data.emplace_back(uv2[i][0], uv2[i][1]);
-                            uv_data.emplace_back(uv1[i][0], uv1[i][1]);
-                        }
-                        else {
-                            uv_data.emplace_back(uv1[i][0], uv1[i][1]);
-                            uv_data.emplace_back(uv2[i][0], uv2[i][1]);
-                        }
-                        uv_indices.push_back(uv_indices.size());
-                        uv_indices.push_back(uv_indices.size());
-                        uv_indices.push_back(uv_indices.size());
-                    }
 
-                    // UVs and Normals use GeomParams, which can be written or read
-                    // as indexed or not, as you'd like.
-                    OV2fGeomParam::Sample uvsamp;
-                    uvsamp.setVals(V2fArraySample( (const V2f *)uv_data.data(), uv_data.size()));
-                    uvsamp.setIndices(UInt32ArraySample( uv_indices.data(), uv_indices.size() ));
-                    uvsamp.setScope(kFacevaryingScope);
-                    OPolyMeshSchema::Sample mesh_samp(
-                        V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
-                        Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
-                        Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ),
-                        uvsamp);
+                // UVs and Normals use GeomParams, which can be written or read
+                // as indexed or not, as you'd like.
+                OV2fGeomParam::Sample uvsamp;
+                uvsamp.setVals(V2fArraySample( (const V2f *)uv_data.data(), uv_data.size()));
+                uvsamp.setIndices(UInt32ArraySample( uv_indices.data(), uv_indices.size() ));
+                uvsamp.setScope(kFacevaryingScope);
+                OPolyMeshSchema::Sample mesh_samp(
+                    V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
+                    Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
+                    Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ),
+                    uvsamp);
 
-                    mesh.set( mesh_samp );
-                } else {
-                    OPolyMeshSchema::Sample mesh_samp(
-                        V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
-                        Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
-                        Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
-                    mesh.set( mesh_samp );
+                mesh.set( mesh_samp );
+            } else {
+                OPolyMeshSchema::Sample mesh_samp(
+                    V3fArraySample( ( const V3f * )prim->verts.data(), prim->verts.size() ),
+                    Int32ArraySample( vertex_index_per_face.data(), vertex_index_per_face.size() ),
+                    Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
+                mesh.set( mesh_samp );
+            }
+        }
+    }
+
+    virtual void apply() override {
+        bool flipFrontBack = get_param<int>("flipFrontBack");
+        int frameid;
+        if (has_input("frameid")) {
+            frameid = get_param<int>("frameid");
+        } else {
+            frameid = getGlobalState()->frameid;
+        }
+        int frame_start = get_param<int>("frame_start");
+        int frame_end = get_param<int>("frame_end");
+        if (frameid == frame_start) {
+            if (writer) {
+                writer->wait();
+            }
+            std::string path = get_param<std::string>("path");
+            archive = {Alembic::AbcCoreOgawa::WriteArchive(), path};
+            archive.addTimeSampling(TimeSampling(1.0/24, frame_start / 24.0));
+            meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
+        }
+        auto prim = get_input<PrimitiveObject>("prim");
+        if (frame_start <= frameid && frameid <= frame_end) {
+            if (get_param<int>("writeInBackground")) {
+                if (!writer) {
+                    writer = std::make_unique<AbcSampleWriter>();
+                }
+                writer->push([this, prim = std::make_shared<PrimitiveObject>(*prim), flipFrontBack] {
+                    writeSample(prim, flipFrontBack);
+                });
+                if (frameid == frame_end) {
+                    writer->wait();
                 }
+            } else {
+                if (writer) {
+                    writer->wait();
+                }
+                writeSample(prim, flipFrontBack);
             }
         }
     }
@@ -192,6 +317,7 @@ ZENDEFNODE(WriteAlembic, {
         {"int", "frame_start", "0"},
         {"int", "frame_end", "100"},
         {"bool", "flipFrontBack", "1"},
+        {"bool", "writeInBackground", "1"},
     },
     {"deprecated"},
 });
@@ -202,6 +328,7 @@ struct WriteAlembic2 : INode {
     OPoints pointsObj;
     std::map<std::string, OFloatGeomParam> attrs;
     std::map<std::string, std::any> user_attrs;
+    std::unique_ptr<AbcSampleWriter> writer;  // last, as in WriteAlembic
 
     template<typename T1, typename T2>
     void write_attrs(std::shared_ptr<PrimitiveObject> prim, T1& schema, T2& samp) {
@@ -299,37 +426,7 @@ struct WriteAlembic2 : INode {
             }
         }
     }
-    virtual void apply() override {
-        auto prim = get_input<PrimitiveObject>("prim");
-        bool flipFrontBack = get_input2<int>("flipFrontBack");
-        float fps = has_input("fps")? get_input2<float>("fps") : 24.0f;
-        int frameid;
-        if (has_input("frameid")) {
-            frameid = get_input2<int>("frameid");
-        } else {
-            frameid = getGlobalState()->frameid;
-        }
-        int frame_start = get_input2<int>("frame_start");
-        int frame_end = get_input2<int>("frame_end");
-        if (frameid == frame_start) {
-            std::string path = get_input2<std::string>("path");
-            archive = {Alembic::AbcCoreOgawa::WriteArchive(), path};
-            archive.addTimeSampling(TimeSampling(1.0/fps, frame_start / fps));
-            if (prim->polys.size() || prim->tris.size()) {
-                meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
-            }
-            else {
-                pointsObj = OPoints (OObject( archive, 1 ), "points");
-            }
-            attrs.clear();
-            user_attrs.clear();
-        }
-        if (!(frame_start <= frameid && frameid <= frame_end)) {
-            return;
-        }
-        if (archive.valid() == false) {
-            zeno::makeError("Not init. Check whether in correct correct frame range.");
-        }
+    void writeSample(std::shared_ptr<PrimitiveObject> prim, bool flipFrontBack) {
         if (prim->polys.size() || prim->tris.size()) {
             // Create a PolyMesh class.
             OPolyMeshSchema &mesh = meshyObj.getSchema();
@@ -484,6 +581,60 @@ struct WriteAlembic2 : INode {
             points.set( samp );
         }
     }
+
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        bool flipFrontBack = get_input2<int>("flipFrontBack");
+        float fps = has_input("fps")? get_input2<float>("fps") : 24.0f;
+        int frameid;
+        if (has_input("frameid")) {
+            frameid = get_input2<int>("frameid");
+        } else {
+            frameid = getGlobalState()->frameid;
+        }
+        int frame_start = get_input2<int>("frame_start");
+        int frame_end = get_input2<int>("frame_end");
+        if (frameid == frame_start) {
+            if (writer) {
+                writer->wait();
+            }
+            std::string path = get_input2<std::string>("path");
+            archive = {Alembic::AbcCoreOgawa::WriteArchive(), path};
+            archive.addTimeSampling(TimeSampling(1.0/fps, frame_start / fps));
+            if (prim->polys.size() || prim->tris.size()) {
+                meshyObj = OPolyMesh( OObject( archive, 1 ), "mesh" );
+            }
+            else {
+                pointsObj = OPoints (OObject( archive, 1 ), "points");
+            }
+            attrs.clear();
+            user_attrs.clear();
+        }
+        if (!(frame_start <= frameid && frameid <= frame_end)) {
+            return;
+        }
+        if (archive.valid() == false) {
+            zeno::makeError("Not init. Check whether in correct correct frame range.");
+        }
+        if (get_input2<bool>("writeInBackground")) {
+            if (!writer) {
+                writer = std::make_unique<AbcSampleWriter>();
+            }
+            // a copy, the prim may be modified in place for the next frame, e.g. by a solver;
+            // named attributes are shared copy-on-write, only verts/tris/loops... values are duplicated
+            writer->push([this, prim = std::make_shared<PrimitiveObject>(*prim), flipFrontBack] {
+                writeSample(prim, flipFrontBack);
+            });
+            if (frameid == frame_end) {
+                writer->wait();
+            }
+        } else {
+            if (writer) {
+                writer->wait();
+            }
+            writeSample(prim, flipFrontBack);
+        }
+    }
 };
 
 ZENDEFNODE(WriteAlembic2, {
@@ -495,6 +646,7 @@ ZENDEFNODE(WriteAlembic2, {
         {"int", "frame_end", "100"},
         {"fps"},
         {"bool", "flipFrontBack", "1"},
+        {"bool", "writeInBackground", "1"},
     },
     {},
     {},
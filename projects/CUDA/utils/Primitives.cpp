@@ -918,7 +918,7 @@ struct PrimitiveFuse : INode {
                                 auto &loopUV = loops.attr<int>("uvs");
                                 loopUV[loopI] = loopI;
                                 auto &uvs = prim->uvs.values;
-                                const auto &srcVertUV = std::get<std::vector<vec3f>>(vertArr);
+                                const auto &srcVertUV = std::get<zeno::cow_vector<vec3f>>(vertArr);
                                 auto vertUV = srcVertUV[ptNo];
                                 uvs[loopI] = vec2f(vertUV[0], vertUV[1]);
                             }
@@ -251,7 +251,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
             if (key == "uv0" || key == "uv1" || key == "uv2")
                 return;
             using T = std::decay_t<decltype(arr[0])>;
-            auto &pat = oldpolyattrs[key].emplace<std::vector<T>>();
+            auto &pat = oldpolyattrs[key].emplace<cow_vector<T>>().mut();
             fits(pat);
             size_t stride = 3 << shift;
             for (size_t i = 0; i < prim->tris.size(); i++) {
@@ -265,7 +265,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
             if (key == "uv0" || key == "uv1" || key == "uv2" || key == "uv3")
                 return;
             using T = std::decay_t<decltype(arr[0])>;
-            auto &pat = oldpolyattrs[key].emplace<std::vector<T>>();
+            auto &pat = oldpolyattrs[key].emplace<cow_vector<T>>().mut();
             fits(pat);
             size_t stride = 4 << shift;
                 /* ZENO_P(prim->quads->size()); */
@@ -279,7 +279,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
         offsetred += prim->quads.size();
         prim->polys.foreach_attr<AttrAcceptAll>([&](std::string const &key, auto &arr) {
             using T = std::decay_t<decltype(arr[0])>;
-            auto &pat = oldpolyattrs[key].emplace<std::vector<T>>();
+            auto &pat = oldpolyattrs[key].emplace<cow_vector<T>>().mut();
             fits(pat);
             for (size_t i = 0; i < prim->polys.size(); i++) {
                 size_t stride = prim->polys[i][1] << shift;
@@ -214,6 +214,10 @@ static int defFunctionObjectDefactory = capiRegisterObjectDefactory("FunctionObj
 }
 
 struct PythonScript : INode {
+    virtual bool isPure() const override {
+        return false;
+    }
+
     void apply() override {
         auto args = has_input("args") ? get_input<DictObject>("args") : std::make_shared<DictObject>();
         auto path = get_input2<std::string>("path");
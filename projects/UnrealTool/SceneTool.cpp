@@ -410,7 +410,7 @@ namespace zeno {
     struct ResampleToUnrealLandscape : public INode {
 
         template<typename T>
-        using V = std::vector<T>;
+        using V = zeno::cow_vector<T>;
 
         void apply() override {
             std::shared_ptr<PrimitiveObject> OldPrim = get_input2<PrimitiveObject>("Prim");
@@ -276,7 +276,7 @@ struct Grid2DSample : zeno::INode {
         }
 
         if (prim->has_attr(sampleby)) {
-            if (!(sampleby == "pos" || std::holds_alternative<std::vector<vec3f>>(prim->attr(sampleby))))
+            if (!(sampleby == "pos" || std::holds_alternative<cow_vector<vec3f>>(prim->attr(sampleby))))
                 throw std::runtime_error("[sampleBy] has to be a vec3f attribute!");
 
             for (const auto &ch : channels) {
@@ -2,7 +2,9 @@
 
 #include <memory>
 #include <cstring>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <map>
 
 namespace zfx::x64 {
@@ -13,11 +15,23 @@ struct Executable {
     float consts[1024];
     void **functable = nullptr;
 
-    static constexpr size_t SimdWidth = 4;
+    static constexpr size_t MaxSimdWidth = 16;
+    size_t SimdWidth = 4;  // lanes per channel, picked by the assembler from the CPU features
+
+    // stride in floats of each channel for kernels assembled with a channel layout, see execute_strided
+    std::vector<int> strides;
+
+    // what such kernels are called with, they loop over nblocks blocks of SimdWidth elements
+    struct Frame {
+        float locals[MaxSimdWidth * 256];  // spilled registers
+        float scratch[MaxSimdWidth];       // staging area for channels with stride > 1
+        float *ptrs[256];                  // first element of the current block, per channel
+        intptr_t nblocks;
+    };
 
     struct Context {
         Executable *exec;
-        float locals[SimdWidth * 256];
+        float locals[MaxSimdWidth * 256];
 
         void execute() {
             auto entry = (void(*)(void *, void *, void *))exec->mem;
@@ -25,10 +39,13 @@ struct Executable {
         }
 
         float *channel(int chid) {
-            return locals + SimdWidth * chid;
+            return locals + exec->SimdWidth * chid;
         }
     };
 
+    // runs count elements in place, bases[i] points to the first element of channel i
+    void execute_strided(float *const *bases, size_t count);
+
     inline float &parameter(int parid) {
         return consts[parid];
     }
@@ -43,6 +60,7 @@ struct Executable {
 
     static std::unique_ptr<Executable> assemble
         ( std::string const &lines
+        , std::vector<int> const &strides = {}
         );
 };
 
@@ -58,6 +76,22 @@ struct Assembler {
         cache[lines] = std::move(prog);
         return raw_ptr;
     }
+
+    // kernel reading and writing the channels in place, strides[i] is the
+    // distance in floats between two elements of channel i (3 for a vec3f)
+    Executable *assemble(std::string const &lines, std::vector<int> const &strides) {
+        auto key = lines;
+        for (auto stride: strides) {
+            key += "|" + std::to_string(stride);
+        }
+        if (auto it = cache.find(key); it != cache.end()) {
+            return it->second.get();
+        }
+        auto prog = Executable::assemble(lines, strides);
+        auto raw_ptr = prog.get();
+        cache[key] = std::move(prog);
+        return raw_ptr;
+    }
 };
 
 }
@@ -5,10 +5,145 @@
 #include <zfx/x64.h>
 #include <algorithm>
 #include <sstream>
+#include <cstdlib>
+#include <cstddef>
+#include <mutex>
 #include <map>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 
 namespace zfx::x64 {
 
+struct CPUFeatures {
+    bool avx = false;
+    bool fma = false;
+    bool avx512 = false;  // F and DQ, with zmm state enabled by the OS
+
+    CPUFeatures() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        unsigned regs[4] = {0, 0, 0, 0};
+        auto cpuid = [&] (unsigned leaf) {
+#if defined(_MSC_VER)
+            __cpuidex((int *)regs, leaf, 0);
+#else
+            __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        };
+        cpuid(0);
+        unsigned maxleaf = regs[0];
+        cpuid(1);
+        bool osxsave = regs[2] >> 27 & 1;
+        bool hasavx = regs[2] >> 28 & 1;
+        bool hasfma = regs[2] >> 12 & 1;
+        if (!osxsave || !hasavx)
+            return;
+#if defined(_MSC_VER)
+        unsigned long long xcr0 = _xgetbv(0);
+#else
+        unsigned xcr0lo, xcr0hi;
+        __asm__ volatile ("xgetbv" : "=a"(xcr0lo), "=d"(xcr0hi) : "c"(0));
+        unsigned long long xcr0 = xcr0lo | (unsigned long long)xcr0hi << 32;
+#endif
+        if ((xcr0 & 0x06) != 0x06)  // xmm and ymm state
+            return;
+        avx = true;
+        fma = hasfma;
+        if (maxleaf >= 7) {
+            cpuid(7);
+            bool hasavx512 = (regs[1] >> 16 & 1) && (regs[1] >> 17 & 1);
+            avx512 = hasavx512 && (xcr0 & 0xe0) == 0xe0;  // opmask and zmm state
+        }
+#endif
+    }
+
+    static CPUFeatures const &get() {
+        static CPUFeatures features;
+        return features;
+    }
+};
+
+// widest kind the CPU supports, can be lowered by env ZFX_SIMD_WIDTH=4/8/16
+static int detect_simdkind() {
+    auto const &cpu = CPUFeatures::get();
+    int width = cpu.avx512 ? 16 : 8;
+    if (auto env = std::getenv("ZFX_SIMD_WIDTH"); env && *env)
+        width = std::min(width, std::atoi(env));
+    if (width >= 16)
+        return simdtype::zmmps;
+    if (width >= 8)
+        return simdtype::ymmps;
+    return simdtype::xmmps;
+}
+
+// replace `mul t a b` ... `add d t c` with `fma d a b c` when t is not used afterwards
+static std::string fuse_multiply_add(std::string const &lines) {
+    std::vector<std::vector<std::string>> insts;
+    for (auto line: split_str(lines, '\n')) {
+        if (!line.size()) continue;
+        insts.push_back(split_str(line, ' '));
+    }
+    auto isRead = [] (std::vector<std::string> const &inst, std::string const &reg) {
+        auto const &cmd = inst[0];
+        if (cmd == "const" || cmd == "ldp" || cmd == "ldl")
+            return false;
+        if (cmd == "stl")
+            return inst.size() > 1 && inst[1] == reg;
+        return std::find(inst.begin() + std::min<size_t>(2, inst.size()), inst.end(), reg) != inst.end();
+    };
+    auto isWritten = [] (std::vector<std::string> const &inst, std::string const &reg) {
+        auto const &cmd = inst[0];
+        return cmd != "const" && cmd != "stl" && inst.size() > 1 && inst[1] == reg;
+    };
+    auto isDead = [&] (size_t from, std::string const &reg) {
+        for (size_t j = from; j < insts.size(); j++) {
+            if (isRead(insts[j], reg))
+                return false;
+            if (isWritten(insts[j], reg))
+                return true;
+        }
+        return true;
+    };
+
+    // the add may come a few instructions later, as long as those leave the
+    // product and both factors alone, the fused op then replaces the add
+    std::vector<bool> fused(insts.size());
+    for (size_t i = 0; i < insts.size(); i++) {
+        auto const &inst = insts[i];
+        if (inst[0] != "mul" || inst.size() < 4)
+            continue;
+        auto const &tmp = inst[1];
+        for (size_t j = i + 1; j < insts.size() && j <= i + 8; j++) {
+            auto &next = insts[j];
+            if (next[0] == "add" && next.size() >= 4 && (next[2] == tmp) != (next[3] == tmp)
+                && (next[1] == tmp || isDead(j + 1, tmp))) {
+                auto addend = next[2] == tmp ? next[3] : next[2];
+                next = {"fma", next[1], inst[2], inst[3], addend};
+                fused[i] = true;
+                break;
+            }
+            if (isRead(next, tmp) || isWritten(next, tmp)
+                || isWritten(next, inst[2]) || isWritten(next, inst[3]))
+                break;
+        }
+    }
+
+    std::string res;
+    for (size_t i = 0; i < insts.size(); i++) {
+        if (fused[i])
+            continue;
+        auto const &inst = insts[i];
+        for (size_t k = 0; k < inst.size(); k++) {
+            if (k) res += ' ';
+            res += inst[k];
+        }
+        res += '\n';
+    }
+    return res;
+}
+
 #define ERROR_IF(x) do { \
     if (x) { \
         error("`%s`", #x); \
@@ -16,16 +151,49 @@ namespace zfx::x64 {
 } while (0)
 
 struct ImplAssembler {
-    int simdkind = simdtype::xmmps;
+    int simdkind = detect_simdkind();
 
     std::unique_ptr<SIMDBuilder> builder = std::make_unique<SIMDBuilder>();
     std::unique_ptr<Executable> exec = std::make_unique<Executable>();
-    static inline std::unique_ptr<FuncTable> functable;
+    static inline std::map<int, std::unique_ptr<FuncTable>> functables;  // by simd width
+    static inline std::mutex functablesMutex;
 
     int nconsts = 0;
     int nlocals = 0;
     //int nglobals = 0;
 
+    // channel layout, local ids below strides.size() are then channels
+    std::vector<int> strides;
+
+    static constexpr int scratchOffset = offsetof(Executable::Frame, scratch);
+    static constexpr int ptrsOffset = offsetof(Executable::Frame, ptrs);
+    static constexpr int nblocksOffset = offsetof(Executable::Frame, nblocks);
+
+    // rdi points to the frame, rax to the current block of channel id
+    void addChannelOp(int op, int val, int id) {
+        int width = SIMDBuilder::sizeOfType(simdkind) / sizeof(float);
+        int stride = strides[id];
+        builder->addRegularMemoryOp(0x8b, true, opreg::rax,
+            {opreg::a1, memflag::reg_imm8, ptrsOffset + id * (int)sizeof(void *)});
+        if (stride == 1) {
+            builder->addAvxMemoryOp(simdkind, op, val, opreg::rax);
+            return;
+        }
+        // no simd register is free for a gather, stage the lanes through memory instead
+        if (op == opcode::storeu)
+            builder->addAvxMemoryOp(simdkind, op, val,
+                {opreg::a1, memflag::reg_imm8, scratchOffset});
+        for (int k = 0; k < width; k++) {
+            SIMDBuilder::MemoryAddress elem{opreg::rax, memflag::reg_imm8, k * stride * (int)sizeof(float)};
+            SIMDBuilder::MemoryAddress lane{opreg::a1, memflag::reg_imm8, scratchOffset + k * (int)sizeof(float)};
+            builder->addRegularMemoryOp(0x8b, false, opreg::r11, op == opcode::storeu ? lane : elem);
+            builder->addRegularMemoryOp(0x89, false, opreg::r11, op == opcode::storeu ? elem : lane);
+        }
+        if (op == opcode::loadu)
+            builder->addAvxMemoryOp(simdkind, op, val,
+                {opreg::a1, memflag::reg_imm8, scratchOffset});
+    }
+
     static float parse_float(std::string const &expr) {
         float value = 0.0f;
         if (std::istringstream(expr) >> value)
@@ -39,7 +207,8 @@ struct ImplAssembler {
     }
 
     void parse(std::string const &lines) {
-        for (auto line: split_str(lines, '\n')) {
+        bool usefma = CPUFeatures::get().fma;
+        for (auto line: split_str(usefma ? fuse_multiply_add(lines) : lines, '\n')) {
             if (!line.size()) continue;
 
             auto linesep = split_str(line, ' ');
@@ -67,6 +236,10 @@ struct ImplAssembler {
                 auto dst = from_string<int>(linesep[1]);
                 auto id = from_string<int>(linesep[2]);
                 nlocals = std::max(nlocals, id + 1);
+                if (id < strides.size()) {
+                    addChannelOp(opcode::loadu, dst, id);
+                    continue;
+                }
                 int offset = id * SIMDBuilder::sizeOfType(simdkind);
                 builder->addAvxMemoryOp(simdkind, opcode::loadu,
                     dst, {opreg::a1, memflag::reg_imm8, offset});
@@ -76,6 +249,10 @@ struct ImplAssembler {
                 auto dst = from_string<int>(linesep[1]);
                 auto id = from_string<int>(linesep[2]);
                 nlocals = std::max(nlocals, id + 1);
+                if (id < strides.size()) {
+                    addChannelOp(opcode::storeu, dst, id);
+                    continue;
+                }
                 int offset = id * SIMDBuilder::sizeOfType(simdkind);
                 builder->addAvxMemoryOp(simdkind, opcode::storeu,
                     dst, {opreg::a1, memflag::reg_imm8, offset});
@@ -143,6 +320,23 @@ struct ImplAssembler {
                 //builder->addAvxBinaryOp(simdkind, opcode::mod,
                     //dst, lhs, rhs);
 
+            } else if (cmd == "fma") {
+                ERROR_IF(linesep.size() < 4);
+                auto dst = from_string<int>(linesep[1]);
+                auto lhs = from_string<int>(linesep[2]);
+                auto rhs = from_string<int>(linesep[3]);
+                auto addend = from_string<int>(linesep[4]);
+                if (dst == addend) {
+                    builder->addAvxFmaOp(simdkind, opcode::fmadd231, dst, lhs, rhs);
+                } else if (dst == lhs) {
+                    builder->addAvxFmaOp(simdkind, opcode::fmadd213, dst, rhs, addend);
+                } else if (dst == rhs) {
+                    builder->addAvxFmaOp(simdkind, opcode::fmadd213, dst, lhs, addend);
+                } else {
+                    builder->addAvxMoveOp(simdkind, dst, addend);
+                    builder->addAvxFmaOp(simdkind, opcode::fmadd231, dst, lhs, rhs);
+                }
+
             } else if (cmd == "min") {
                 ERROR_IF(linesep.size() < 3);
                 auto dst = from_string<int>(linesep[1]);
@@ -299,6 +493,8 @@ struct ImplAssembler {
 #if defined(_WIN32)
                     builder->addAdjStackTop(-64);
 #endif
+                    if (simdkind != simdtype::xmmps)
+                        builder->addVzeroupper();
                     builder->addCallOp({opreg::a3, memflag::reg_imm8, offset});
 #if defined(_WIN32)
                     builder->addAdjStackTop(64);
@@ -330,6 +526,8 @@ struct ImplAssembler {
 #if defined(_WIN32)
                     builder->addAdjStackTop(-64);
 #endif
+                    if (simdkind != simdtype::xmmps)
+                        builder->addVzeroupper();
                     builder->addCallOp({opreg::a3, memflag::reg_imm8, offset});
 #if defined(_WIN32)
                     builder->addAdjStackTop(64);
@@ -347,6 +545,18 @@ struct ImplAssembler {
             }
         }
 
+        if (strides.size()) {
+            // advance to the next block, the loop head is the very first instruction
+            int width = SIMDBuilder::sizeOfType(simdkind) / sizeof(float);
+            for (int id = 0; id < strides.size(); id++) {
+                builder->addRegularMemoryImmOp(0, {opreg::a1, memflag::reg_imm8,
+                    ptrsOffset + id * (int)sizeof(void *)}, width * strides[id] * (int)sizeof(float));
+            }
+            builder->addRegularMemoryImmOp(5, {opreg::a1, memflag::reg_imm8, nblocksOffset}, 1);
+            builder->addCondJumpOp(jmpcode::jne, 0);
+        }
+        if (simdkind != simdtype::xmmps)
+            builder->addVzeroupper();
         builder->addReturn();
         auto const &insts = builder->getResult();
 
@@ -364,9 +574,13 @@ struct ImplAssembler {
         }
 #endif
 
+        int width = SIMDBuilder::sizeOfType(simdkind) / sizeof(float);
+        std::lock_guard lck(functablesMutex);
+        auto &functable = functables[width];
         if (!functable)
-            functable = std::make_unique<FuncTable>();
+            functable = std::make_unique<FuncTable>(width);
         exec->functable = functable->funcptrs.data();
+        exec->SimdWidth = width;
         exec->memsize = (insts.size() + 4095) / 4096 * 4096;
         exec->mem = (uint8_t *)exec_page_allocate(exec->memsize);
         for (int i = 0; i < insts.size(); i++) {
@@ -378,12 +592,59 @@ struct ImplAssembler {
 
 std::unique_ptr<Executable> Executable::assemble
     ( std::string const &lines
+    , std::vector<int> const &strides
     ) {
     ImplAssembler a;
+    a.strides = strides;
     a.parse(lines);
+    a.exec->strides = strides;
     return std::move(a.exec);
 }
 
+void Executable::execute_strided(float *const *bases, size_t count) {
+    auto entry = (void(*)(void *, void *, void *))mem;
+    Frame frame;
+    size_t nfull = count / SimdWidth;
+    if (nfull) {
+        for (size_t i = 0; i < strides.size(); i++) {
+            frame.ptrs[i] = bases[i];
+        }
+        frame.nblocks = nfull;
+        entry((void *)&frame, (void *)consts, (void *)functable);
+    }
+    size_t rest = count - nfull * SimdWidth;
+    if (!rest)
+        return;
+
+    // the last partial block runs on a padded copy, its spare lanes repeat the last element
+    size_t total = 0;
+    for (auto stride: strides) {
+        total += SimdWidth * stride;
+    }
+    std::vector<float> tail(total);
+    float *p = tail.data();
+    for (size_t i = 0; i < strides.size(); i++) {
+        size_t stride = strides[i];
+        float *src = bases[i] + nfull * SimdWidth * stride;
+        for (size_t k = 0; k < SimdWidth; k++) {
+            p[k * stride] = src[std::min(k, rest - 1) * stride];
+        }
+        frame.ptrs[i] = p;
+        p += SimdWidth * stride;
+    }
+    frame.nblocks = 1;
+    entry((void *)&frame, (void *)consts, (void *)functable);
+    p = tail.data();
+    for (size_t i = 0; i < strides.size(); i++) {
+        size_t stride = strides[i];
+        float *dst = bases[i] + nfull * SimdWidth * stride;
+        for (size_t k = 0; k < rest; k++) {
+            dst[k * stride] = p[k * stride];
+        }
+        p += SimdWidth * stride;
+    }
+}
+
 Executable::~Executable() {
     if (mem) {
         exec_page_free(mem, memsize);
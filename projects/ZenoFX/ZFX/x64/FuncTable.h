@@ -11,8 +11,9 @@
 namespace zfx::x64 {
 
 struct FuncTable {
-#define DEF_FN1(name) static void func_##name(float *a) { vcl::Vec4f x; x.load(a); x = vcl::name(x); x.store(a); }
-#define DEF_FN2(name) static void func_##name(float *a, float *b) { vcl::Vec4f x, y; x.load(a); y.load(b); x = vcl::name(x, y); x.store(a); }
+    // Vec is vcl::Vec4f, Vec8f or Vec16f, matching the simd width of the executable
+#define DEF_FN1(name) template <class Vec> static void func_##name(float *a) { Vec x; x.load(a); x = vcl::name(x); x.store(a); }
+#define DEF_FN2(name) template <class Vec> static void func_##name(float *a, float *b) { Vec x, y; x.load(a); y.load(b); x = vcl::name(x, y); x.store(a); }
 DEF_FN1(sin)
 DEF_FN1(cos)
 DEF_FN1(tan)
@@ -25,9 +26,9 @@ DEF_FN1(floor)
 DEF_FN1(ceil)
 DEF_FN2(atan2)
 DEF_FN2(pow)
-static void func_fb2i(float *a) { vcl::Vec4f x; x.load(a); x = vcl::fb2i(x); x.store(a); }
-static void func_ib2f(float *a) { vcl::Vec4f x; x.load(a); x = vcl::ib2f(x); x.store(a); }
-static void func_fmod(float *a, float *b) { vcl::Vec4f x, y; x.load(a); y.load(b); x = x - vcl::floor(x / y) * y; x.store(a); }
+template <class Vec> static void func_fb2i(float *a) { Vec x; x.load(a); x = vcl::to_float(decltype(vcl::roundi(x))(vcl::reinterpret_i(x))); x.store(a); }
+template <class Vec> static void func_ib2f(float *a) { Vec x; x.load(a); x = vcl::reinterpret_f(vcl::roundi(x)); x.store(a); }
+template <class Vec> static void func_fmod(float *a, float *b) { Vec x, y; x.load(a); y.load(b); x = x - vcl::floor(x / y) * y; x.store(a); }
 #undef DEF_FN1
 #undef DEF_FN2
 
@@ -55,10 +56,19 @@ DEF_FN2(fmod)
 
     std::vector<void *> funcptrs;
 
-    FuncTable() {
+    explicit FuncTable(int width) {
+        if (width == 16)
+            fill<vcl::Vec16f>();
+        else if (width == 8)
+            fill<vcl::Vec8f>();
+        else
+            fill<vcl::Vec4f>();
+    }
+
+    template <class Vec>
+    void fill() {
         // we have to assign funcptrs at runtime to prevent dll relocation
-        for (int i = 0; i < funcnames.size(); i++) {
-#define DEF_FN1(name) funcptrs.push_back((void *)func_##name);
+#define DEF_FN1(name) funcptrs.push_back((void *)func_##name<Vec>);
 #define DEF_FN2(name) DEF_FN1(name)
 DEF_FN1(sin)
 DEF_FN1(cos)
@@ -77,7 +87,6 @@ DEF_FN2(pow)
 DEF_FN2(fmod)
 #undef DEF_FN1
 #undef DEF_FN2
-        }
     }
 };
 
@@ -36,6 +36,9 @@ namespace opcode {
         cmp_le = 0x02c2,
         cmp_gt = 0x0ec2,
         cmp_ge = 0x0dc2,
+        fmadd132 = 0x98,
+        fmadd213 = 0xa8,
+        fmadd231 = 0xb8,
     };
 };
 
@@ -103,10 +106,11 @@ namespace simdtype {
         ymmpd = 0x05,
         ymmss = 0x06,
         ymmsd = 0x07,
+        zmmps = 0x10,  // EVEX encoded, requires AVX-512F and AVX-512DQ
     };
 };
 
-struct SIMDBuilder {   // requires AVX2
+struct SIMDBuilder {   // requires AVX, see simdtype for wider ones
     std::vector<uint8_t> res;
 
     struct MemoryAddress {
@@ -166,6 +170,7 @@ struct SIMDBuilder {   // requires AVX2
         case simdtype::xmmsd: return sizeof(double);
         case simdtype::ymmps: return sizeof(float);
         case simdtype::ymmpd: return sizeof(double);
+        case simdtype::zmmps: return sizeof(float);
         default: return 0;
         }
     }
@@ -178,11 +183,52 @@ struct SIMDBuilder {   // requires AVX2
         case simdtype::xmmsd: return 1 * sizeof(double);
         case simdtype::ymmps: return 8 * sizeof(float);
         case simdtype::ymmpd: return 4 * sizeof(double);
+        case simdtype::zmmps: return 16 * sizeof(float);
         default: return 0;
         }
     }
 
+    // zmm0-15 only, mm: 1 = 0F, 2 = 0F38; pp: 0 = none, 1 = 66, 2 = F3; aaa: opmask k0-k7
+    void addEvexPrefix(int mm, int pp, int reg, int vvvv, int rm, int aaa = 0) {
+        res.push_back(0x62);
+        res.push_back(0x50 | mm | (~reg >> 3 & 1) << 7 | (~rm >> 3 & 1) << 5);
+        res.push_back(0x04 | pp | (~vvvv & 0x0f) << 3);
+        res.push_back(0x48 | aaa);
+    }
+
+    void addEvexRegOp(int mm, int pp, int op, int reg, int vvvv, int rm, int aaa = 0) {
+        addEvexPrefix(mm, pp, reg, vvvv, rm, aaa);
+        res.push_back(op);
+        res.push_back(0xc0 | reg << 3 & 0x38 | rm & 0x07);
+    }
+
+    // EVEX scales 8-bit displacements by the size n of the memory operand
+    void addEvexMemoryOp(int mm, int pp, int op, int reg, MemoryAddress adr, int n) {
+        addEvexPrefix(mm, pp, reg, 0, adr.adr);
+        res.push_back(op);
+        int mod = 0;
+        if (adr.mflag & (memflag::reg_imm8 | memflag::reg_imm32) || (adr.adr & 0x07) == opreg::rbp) {
+            bool short_ = adr.immadr % n == 0 && -128 <= adr.immadr / n && adr.immadr / n <= 127;
+            mod = short_ ? memflag::reg_imm8 : memflag::reg_imm32;
+        }
+        res.push_back(mod | reg << 3 & 0x38 | adr.adr & 0x07);
+        if ((adr.adr & 0x07) == opreg::rsp)
+            res.push_back(0x24);
+        if (mod == memflag::reg_imm8) {
+            res.push_back(adr.immadr / n & 0xff);
+        } else if (mod == memflag::reg_imm32) {
+            res.push_back(adr.immadr & 0xff);
+            res.push_back(adr.immadr >> 8 & 0xff);
+            res.push_back(adr.immadr >> 16 & 0xff);
+            res.push_back(adr.immadr >> 24 & 0xff);
+        }
+    }
+
     void addAvxBroadcastLoadOp(int type, int val, MemoryAddress adr) {
+        if (type == simdtype::zmmps) {
+            addEvexMemoryOp(2, 1, 0x18, val, adr, sizeof(float));
+            return;
+        }
         res.push_back(0xc4);
         res.push_back(0x62 | ~val >> 3 << 7);
         res.push_back(0x79 | type & 0x04);
@@ -200,6 +246,10 @@ struct SIMDBuilder {   // requires AVX2
     }
 
     void addAvxMemoryOp(int type, int op, int val, MemoryAddress adr) {
+        if (type == simdtype::zmmps) {
+            addEvexMemoryOp(1, 0, op, val, adr, sizeOfType(type));
+            return;
+        }
         res.push_back(0xc5);
         res.push_back(type | 0x78 | ~val >> 3 << 7);
         res.push_back(op);
@@ -218,6 +268,26 @@ struct SIMDBuilder {   // requires AVX2
         adr.dump(res, val);
     }
 
+    // 32 or 64-bit move between a general register and memory, op is 0x8b to load or 0x89 to store
+    void addRegularMemoryOp(int op, bool wide, int val, MemoryAddress adr) {
+        int rex = (wide ? 0x08 : 0) | (val >> 3 & 1) << 2 | (adr.adr >> 3 & 1);
+        if (rex)
+            res.push_back(0x40 | rex);
+        res.push_back(op);
+        adr.dump(res, val);
+    }
+
+    // ext is the /digit of the 0x81 group, e.g. 0 for add and 5 for sub, on a qword in memory
+    void addRegularMemoryImmOp(int ext, MemoryAddress adr, int imm) {
+        res.push_back(0x48 | (adr.adr >> 3 & 1));
+        res.push_back(0x81);
+        adr.dump(res, ext);
+        res.push_back(imm & 0xff);
+        res.push_back(imm >> 8 & 0xff);
+        res.push_back(imm >> 16 & 0xff);
+        res.push_back(imm >> 24 & 0xff);
+    }
+
     void addRegularMoveOp(int dst, int src) {
         res.push_back(0x48 | dst >> 3 | src >> 1 & 0x04);
         res.push_back(0x89);
@@ -226,9 +296,18 @@ struct SIMDBuilder {   // requires AVX2
 
     void addAdjStackTop(int imm_add) {
         res.push_back(0x48);
-        res.push_back(0x83);
-        res.push_back(0xc4);
-        res.push_back(imm_add);
+        if (-128 <= imm_add && imm_add <= 127) {
+            res.push_back(0x83);
+            res.push_back(0xc4);
+            res.push_back(imm_add & 0xff);
+        } else {
+            res.push_back(0x81);
+            res.push_back(0xc4);
+            res.push_back(imm_add & 0xff);
+            res.push_back(imm_add >> 8 & 0xff);
+            res.push_back(imm_add >> 16 & 0xff);
+            res.push_back(imm_add >> 24 & 0xff);
+        }
     }
 
     void addCallOp(MemoryAddress adr) {
@@ -239,6 +318,17 @@ struct SIMDBuilder {   // requires AVX2
     }
 
     void addAvxBinaryOp(int type, int op, int dst, int lhs, int rhs) {
+        if (type == simdtype::zmmps) {
+            if ((op & 0xff) == opcode::cmp_eq) {
+                // compares write an opmask, turn it back into all-ones lanes like VEX does
+                addEvexRegOp(1, 0, op & 0xff, 1, lhs, rhs);
+                res.push_back(op >> 8);
+                addEvexRegOp(2, 2, 0x38, dst, 0, 1);  // vpmovm2d dst, k1
+            } else {
+                addEvexRegOp(1, 0, op & 0xff, dst, lhs, rhs);
+            }
+            return;
+        }
         if (rhs >= 8) {
             res.push_back(0xc4);
             res.push_back(0x41 | ~dst >> 3 << 7);
@@ -258,7 +348,25 @@ struct SIMDBuilder {   // requires AVX2
         addAvxBinaryOp(type, op, dst, opreg::mm0, src);
     }
 
+    // dst = lhs * dst + rhs (fmadd213), lhs * rhs + dst (fmadd231)...
+    void addAvxFmaOp(int type, int op, int dst, int lhs, int rhs) {
+        if (type == simdtype::zmmps) {
+            addEvexRegOp(2, 1, op, dst, lhs, rhs);
+            return;
+        }
+        res.push_back(0xc4);
+        res.push_back(0x42 | ~dst >> 3 << 7 | (~rhs >> 3 & 1) << 5);
+        res.push_back(0x01 | type & 0x04 | ~lhs << 3 & 0x78);
+        res.push_back(op);
+        res.push_back(0xc0 | dst << 3 & 0x38 | rhs & 0x07);
+    }
+
     void addAvxBlendvOp(int type, int dst, int lhs, int rhs, int mask) {
+        if (type == simdtype::zmmps) {
+            addEvexRegOp(2, 2, 0x39, 1, 0, mask);  // vpmovd2m k1, mask
+            addEvexRegOp(2, 1, 0x65, dst, lhs, rhs, 1);  // vblendmps dst {k1}, lhs, rhs
+            return;
+        }
         res.push_back(0xc4);
         res.push_back(0x43 | ~dst >> 3 << 7 | (~rhs >> 3 & 1) << 5);
         res.push_back(0x01 | type & 0x04 | ~lhs << 3 & 0x78);
@@ -268,7 +376,14 @@ struct SIMDBuilder {   // requires AVX2
     }
 
     void addAvxMoveOp(int type, int dst, int src) {
-        addAvxBinaryOp(opcode::loadu, opcode::mov, dst, opreg::mm0, src);
+        addAvxBinaryOp(type, opcode::mov, dst, opreg::mm0, src);
+    }
+
+    // avoids AVX-SSE transition penalties when calling into non-VEX code
+    void addVzeroupper() {
+        res.push_back(0xc5);
+        res.push_back(0xf8);
+        res.push_back(0x77);
     }
 
     void addJumpOp(int off) {
@@ -283,6 +398,17 @@ struct SIMDBuilder {   // requires AVX2
         }
     }
 
+    // jcc with a 32-bit displacement to position target of res, see jmpcode
+    void addCondJumpOp(int cond, size_t target) {
+        res.push_back(0x0f);
+        res.push_back(0x80 | cond);
+        int off = (int)target - (int)(res.size() + 4);
+        res.push_back(off & 0xff);
+        res.push_back(off >> 8 & 0xff);
+        res.push_back(off >> 16 & 0xff);
+        res.push_back(off >> 24 & 0xff);
+    }
+
     void addPushReg(int reg) {
         if (reg & 0x08)
             res.push_back(0x41);
@@ -18,8 +18,8 @@ namespace zeno {
     std::string preApplyRefs(const std::string& code, Graph* pGraph);
 
 namespace {
-static zfx::Compiler compiler;
-static zfx::x64::Assembler assembler;
+static thread_local zfx::Compiler compiler;
+static thread_local zfx::x64::Assembler assembler;
 
 static void numeric_eval (zfx::x64::Executable *exec,
                          std::vector<float> &chs) {
@@ -16,8 +16,8 @@ namespace zeno {
 namespace {
     using namespace zeno;
 
-static zfx::Compiler compiler;
-static zfx::x64::Assembler assembler;
+static thread_local zfx::Compiler compiler;
+static thread_local zfx::x64::Assembler assembler;
 
 static void numeric_wrangle
     ( zfx::x64::Executable *exec
@@ -15,8 +15,8 @@ namespace zeno {
 
 namespace {
 
-static zfx::Compiler compiler;
-static zfx::x64::Assembler assembler;
+static thread_local zfx::Compiler compiler;
+static thread_local zfx::x64::Assembler assembler;
 
 struct Buffer {
     float *base = nullptr;
@@ -36,33 +36,24 @@ static void vectors_wrangle
         size = std::min(chs[i].count, size);
     }
 
+    // the last batch may be partial, its spare lanes repeat the last element and are discarded
+    const int width = exec->SimdWidth;
     #pragma omp parallel for
-    for (int i = 0; i < size - exec->SimdWidth + 1; i += exec->SimdWidth) {
+    for (intptr_t i = 0; i < (intptr_t)size; i += width) {
+        int n = std::min<intptr_t>(width, size - i);
         auto ctx = exec->make_context();
         for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
-                ctx.channel(j)[k] = chs[j].base[chs[j].stride * (i + k)];
+            for (int k = 0; k < width; k++)
+                ctx.channel(j)[k] = chs[j].base[chs[j].stride * (i + std::min(k, n - 1))];
         }
         ctx.execute();
-        for (int k = 0; k < exec->SimdWidth; k++) {
+        for (int k = 0; k < n; k++) {
             for (int j = 0; j < chs.size(); j++) {
                 if (maskarr[i + k] != 0)
                     chs[j].base[chs[j].stride * (i + k)] = ctx.channel(j)[k];
             }
         }
     }
-    for (int i = size / exec->SimdWidth * exec->SimdWidth; i < size; i++) {
-        auto ctx = exec->make_context();
-        for (int j = 0; j < chs.size(); j++) {
-            ctx.channel(j)[0] = chs[j].base[chs[j].stride * i];
-        }
-        ctx.execute();
-        for (int j = 0; j < chs.size(); j++) {
-            if (maskarr[i] != 0) {
-                chs[j].base[chs[j].stride * i] = ctx.channel(j)[0];
-            }
-        }
-    }
 }
 
 struct ParticlesMaskedWrangle : zeno::INode {
@@ -20,8 +20,8 @@
 
 namespace zeno {
 
-static zfx::Compiler compiler;
-static zfx::x64::Assembler assembler;
+static thread_local zfx::Compiler compiler;
+static thread_local zfx::x64::Assembler assembler;
 
 struct Buffer {
   float *base = nullptr;
@@ -15,8 +15,8 @@ namespace zeno {
 
 namespace {
 
-static zfx::Compiler compiler;
-static zfx::x64::Assembler assembler;
+static thread_local zfx::Compiler compiler;
+static thread_local zfx::x64::Assembler assembler;
 
 struct Buffer {
     float *base = nullptr;
@@ -35,28 +35,17 @@ static void vectors_wrangle
         size = std::min(chs[i].count, size);
     }
 
+    // the kernel walks the attribute arrays by itself, the threads get a chunk each
+    const size_t chunk = exec->SimdWidth * 256;
+    const intptr_t nchunks = (size + chunk - 1) / chunk;
     #pragma omp parallel for
-    for (int i = 0; i < size - exec->SimdWidth + 1; i += exec->SimdWidth) {
-        auto ctx = exec->make_context();
+    for (intptr_t c = 0; c < nchunks; c++) {
+        size_t i = c * chunk;
+        std::vector<float *> bases(chs.size());
         for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
-                ctx.channel(j)[k] = chs[j].base[chs[j].stride * (i + k)];
-        }
-        ctx.execute();
-        for (int j = 0; j < chs.size(); j++) {
-            for (int k = 0; k < exec->SimdWidth; k++)
-                 chs[j].base[chs[j].stride * (i + k)] = ctx.channel(j)[k];
-        }
-    }
-    for (int i = size / exec->SimdWidth * exec->SimdWidth; i < size; i++) {
-        auto ctx = exec->make_context();
-        for (int j = 0; j < chs.size(); j++) {
-            ctx.channel(j)[0] = chs[j].base[chs[j].stride * i];
-        }
-        ctx.execute();
-        for (int j = 0; j < chs.size(); j++) {
-            chs[j].base[chs[j].stride * i] = ctx.channel(j)[0];
+            bases[j] = chs[j].base + chs[j].stride * i;
         }
+        exec->execute_strided(bases.data(), std::min(chunk, size - i));
     }
 }
 
@@ -168,7 +157,6 @@ struct ParticlesWrangle : zeno::INode {
         }
 
         auto prog = compiler.compile(code, opts);
-        auto exec = assembler.assemble(prog->assembly);
 
         for (auto const &[name, dim]: prog->newsyms) {
             dbg_printf("auto-defined new attribute: %s with dim %d\n",
@@ -185,17 +173,6 @@ struct ParticlesWrangle : zeno::INode {
             }
         }
 
-        for (int i = 0; i < prog->params.size(); i++) {
-            auto [name, dimid] = prog->params[i];
-            dbg_printf("parameter %d: %s.%d\n", i, name.c_str(), dimid);
-            assert(name[0] == '$');
-            auto it = std::find(parnames.begin(),
-                parnames.end(), std::pair{name, dimid});
-            auto value = parvals.at(it - parnames.begin());
-            dbg_printf("(valued %f)\n", value);
-            exec->parameter(prog->param_id(name, dimid)) = value;
-        }
-
         std::vector<Buffer> chs(prog->symbols.size());
         for (int i = 0; i < chs.size(); i++) {
             auto [name, dimid] = prog->symbols[i];
@@ -210,6 +187,23 @@ struct ParticlesWrangle : zeno::INode {
             });
             chs[i] = iob;
         }
+
+        std::vector<int> strides(chs.size());
+        for (int i = 0; i < chs.size(); i++) {
+            strides[i] = chs[i].stride;
+        }
+        auto exec = assembler.assemble(prog->assembly, strides);
+
+        for (int i = 0; i < prog->params.size(); i++) {
+            auto [name, dimid] = prog->params[i];
+            dbg_printf("parameter %d: %s.%d\n", i, name.c_str(), dimid);
+            assert(name[0] == '$');
+            auto it = std::find(parnames.begin(),
+                parnames.end(), std::pair{name, dimid});
+            auto value = parvals.at(it - parnames.begin());
+            dbg_printf("(valued %f)\n", value);
+            exec->parameter(prog->param_id(name, dimid)) = value;
+        }
         vectors_wrangle(exec, chs);
 
         set_output("prim", std::move(prim));
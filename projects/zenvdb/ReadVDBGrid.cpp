@@ -49,6 +49,10 @@ static std::shared_ptr<VDBGrid> readGenericVDBGrid(const std::string &fn) {
 struct CacheVDBGrid : zeno::INode {
     int m_framecounter = 0;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         if (get_param<bool>("mute")) {
             requireInput("inGrid");
@@ -20,6 +20,7 @@ struct LAUNCH_PARAM {
     QString zsgPath;
     int projectFps = 24;
     QString paramPath;
+    bool persistentRunner = false;  //keep the runner alive between runs, see runnermain.cpp
 };
 
 void launchProgram(IGraphsModel *pModel, LAUNCH_PARAM param);
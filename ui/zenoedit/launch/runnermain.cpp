@@ -10,15 +10,20 @@
 #include <zeno/extra/GlobalComm.h>
 #include <zeno/extra/GlobalStatus.h>
 #include <zeno/extra/GraphException.h>
+#include <zeno/extra/IncrementalCache.h>
+#include <zeno/extra/FrameCacheWriter.h>
 #include <zeno/extra/EventCallbacks.h>
+#include <zeno/extra/Profiler.h>
 #include <zeno/extra/assetDir.h>
 #include <zeno/funcs/ObjectCodec.h>
+#include <zeno/utils/envconfig.h>
 #include <zeno/zeno.h>
 #include <string>
 #ifdef ZENO_IPC_USE_TCP
 #include <QTcpServer>
 #include <QtWidgets>
 #include <QTcpSocket>
+#include <QSharedMemory>
 #endif
 #include <zeno/utils/scope_exit.h>
 #include "corelaunch.h"
@@ -63,25 +68,105 @@ static void send_packet(std::string_view info, const char *buf, size_t len) {
 
     zeno::log_debug("runner tx head-buffer {} data-buffer {}", headbuffer.size(), len);
 #ifdef ZENO_IPC_USE_TCP
-    for (char c: headbuffer) {
-        clientSocket->write(&c, 1);
-    }
-    clientSocket->write(buf, len);
+    clientSocket->write(headbuffer.data(), headbuffer.size());
+    if (len)
+        clientSocket->write(buf, len);
     while (clientSocket->bytesToWrite() > 0) {
         clientSocket->waitForBytesWritten();
     }
 #else
-    for (char c : headbuffer) {
-        fputc(c, ourfp);
+    auto lck = zeno::lock_log_stream();
+    fwrite(headbuffer.data(), 1, headbuffer.size(), ourfp);
+    fwrite(buf, 1, len, ourfp);
+    fflush(ourfp);
+#endif
+}
+
+#ifdef ZENO_IPC_USE_TCP
+// View objects go through a shared memory ring (size by env ZENO_SHM_RING_MB, 0 to
+// disable), only their location is sent over the socket. The editor decodes them in
+// place and writes back the end position of each one, so that space can be reused.
+struct ShmRing {
+    QSharedMemory shm;
+    std::string key;
+    size_t capacity = 0;
+    uint64_t head = 0;      // total bytes ever pushed
+    uint64_t tail = 0;      // everything before has been decoded by the editor
+    QByteArray acks;
+    bool stalled = false;   // the editor stopped consuming, the socket is used for the rest of the session
+
+    void init(int sessionid) {
+        size_t size = size_t(zeno::envconfig::getInt("SHM_RING_MB", 256)) << 20;
+        if (!size)
+            return;
+        key = "zeno_view_" + std::to_string(sessionid) + "_" + std::to_string(QCoreApplication::applicationPid());
+        shm.setKey(QString::fromStdString(key));
+        if (!shm.create(size) && shm.error() == QSharedMemory::AlreadyExists) {
+            //left by a crashed runner of the same pid, detaching the last reference frees it on unix.
+            if (shm.attach())
+                shm.detach();
+            shm.create(size);
+        }
+        if (!shm.isAttached()) {
+            zeno::log_warn("failed to create shared memory ring: {}", shm.errorString().toStdString());
+            return;
+        }
+        capacity = size;
     }
-    for (size_t i = 0; i < len; i++) {
-        fputc(buf[i], ourfp);
+
+    void readAcks() {
+        acks += clientSocket->readAll();
+        int nl;
+        while ((nl = acks.indexOf('\n')) >= 0) {
+            tail = std::max<uint64_t>(tail, acks.left(nl).toULongLong());
+            acks.remove(0, nl + 1);
+        }
+    }
+
+    // false if the data should be sent through the socket instead
+    bool push(const char *buf, size_t len, uint64_t &offset, uint64_t &end) {
+        if (!capacity || stalled || len > capacity)
+            return false;
+        uint64_t pos = head;
+        if (pos % capacity + len > capacity)
+            pos += capacity - pos % capacity;   // objects never wrap around
+        readAcks();
+        while (pos + len - tail > capacity) {
+            if (!clientSocket->waitForReadyRead(30000)) {
+                zeno::log_warn("editor not consuming the shared memory ring, fallback to socket");
+                stalled = true;
+                return false;
+            }
+            readAcks();
+        }
+        offset = pos % capacity;
+        std::memcpy((char *)shm.data() + offset, buf, len);
+        head = end = pos + len;
+        return true;
+    }
+};
+
+static ShmRing viewRing;
+#endif
+
+static void send_view_object(std::string const &key, std::vector<char> const &buffer) {
+    std::string info = "{\"action\":\"viewObject\",\"key\":\"" + key + "\"";
+#ifdef ZENO_IPC_USE_TCP
+    uint64_t offset, end;
+    if (viewRing.push(buffer.data(), buffer.size(), offset, end)) {
+        info += ",\"shm\":\"" + viewRing.key + "\",\"offset\":" + std::to_string(offset)
+            + ",\"size\":" + std::to_string(buffer.size()) + ",\"end\":" + std::to_string(end) + "}";
+        send_packet(info, "", 0);
+        return;
     }
-    fflush(ourfp);
 #endif
+    send_packet(info + "}", buffer.data(), buffer.size());
 }
 
-static int runner_start(std::string const &progJson, int sessionid, bool bZenCache, int cachenum, std::string cachedir, bool cacheautorm, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string zsg_path, std::string projectFps) {
+// kept across runs in persistent mode, only the changed part is re-evaluated
+static std::shared_ptr<zeno::Graph> persistentGraph;
+
+static int runner_start(std::string const &progJson, int sessionid, bool bZenCache, int cachenum, std::string cachedir, bool cacheautorm, bool cacheLightCameraOnly, bool cacheMaterialOnly, std::string zsg_path, std::string projectFps, bool persistent) {
     zeno::log_trace("runner got program JSON: {}", progJson);
     //MessageBox(0, "runner", "runner", MB_OK);           //convient to attach process by debugger, at windows.
     zeno::scope_exit sp([=]() { std::cout.flush(); });
@@ -92,7 +177,17 @@ static int runner_start(std::string const &progJson, int sessionid, bool bZenCac
     session->globalState->clearState();
     session->globalComm->clearState();
     session->globalStatus->clearState();
-    auto graph = session->createGraph();
+    zeno::Profiler::clear();
+    std::shared_ptr<zeno::Graph> graph;
+    if (persistent) {
+        if (!persistentGraph) {
+            persistentGraph = session->createGraph();
+            persistentGraph->incrementalCache = std::make_unique<zeno::IncrementalCache>();
+        }
+        graph = persistentGraph;
+    } else {
+        graph = session->createGraph();
+    }
 
     //$ZSG value
     zeno::setConfigVariable("ZSG", zsg_path);
@@ -109,17 +204,49 @@ static int runner_start(std::string const &progJson, int sessionid, bool bZenCac
         zeno::getSession().globalComm->frameCache("", 0);
     }
 
+    // frames are encoded and written in the background while the next ones simulate,
+    // finishFrame is only sent once a frame is on disk, since the editor loads it from there
+    std::unique_ptr<zeno::FrameCacheWriter> cacheWriter;
+    if (bZenCache && zeno::envconfig::getBool("ZENCACHE_ASYNC", true))
+        cacheWriter = std::make_unique<zeno::FrameCacheWriter>(session->globalComm.get());
+    auto sendWrittenFrames = [&] (bool wait) {
+        if (!cacheWriter)
+            return;
+        if (wait)
+            cacheWriter->wait();
+        for (int frame: cacheWriter->takeWritten())
+            send_packet("{\"action\":\"finishFrame\",\"key\":\"" + std::to_string(frame) + "\"}", "", 0);
+    };
+
+    // per-node summary goes to the editor with the status, the full trace to env ZENO_PROFILE_TRACE
+    auto collectProfile = [&] {
+        if (!zeno::Profiler::enabled())
+            return;
+        session->globalStatus->nodeStats = zeno::Profiler::nodeStats();
+        if (auto path = zeno::envconfig::getStr("PROFILE_TRACE"); !path.empty()) {
+            if (!zeno::Profiler::writeTrace(path))
+                zeno::log_warn("failed to write profile trace to {}", path);
+        }
+    };
+
     auto onfail = [&] {
+        sendWrittenFrames(true);
+        collectProfile();
         auto statJson = session->globalStatus->toJson();
         send_packet("{\"action\":\"reportStatus\"}", statJson.data(), statJson.size());
         return 1;
     };
 
     zeno::GraphException::catched([&] {
-        graph->loadGraph(progJson.c_str());
+        if (persistent)
+            graph->incrementalCache->loadGraph(graph.get(), progJson.c_str());
+        else
+            graph->loadGraph(progJson.c_str());
     }, *session->globalStatus);
-    if (session->globalStatus->failed())
+    if (session->globalStatus->failed()) {
+        persistentGraph = nullptr;  // half loaded, start over next time
         return onfail();
+    }
 
     std::vector<char> buffer;
 
@@ -138,8 +265,17 @@ static int runner_start(std::string const &progJson, int sessionid, bool bZenCac
         session->globalComm->newFrame();
         session->globalState->frameBegin();
 
+        // outputs of the first substep are kept for the next run at the same frame
+        bool firstPass = persistent && frame == graph->beginFrameNumber;
         while (session->globalState->substepBegin())
         {
+            if (firstPass)
+                graph->incrementalCache->beginPass(frame);
+            zeno::scope_exit endPass([&] {
+                if (firstPass)
+                    graph->incrementalCache->endPass();
+                firstPass = false;
+            });
             zeno::GraphException::catched([&] {
                 graph->applyNodesToExec();
             }, *session->globalStatus);
@@ -156,26 +292,40 @@ static int runner_start(std::string const &progJson, int sessionid, bool bZenCac
         if (bZenCache) {
             //construct cache lock.
             std::string sLockFile = cachedir + "/" + zeno::iotags::sZencache_lockfile_prefix + std::to_string(frame) + ".lock";
-            QLockFile lckFile(QString::fromStdString(sLockFile));
-            bool ret = lckFile.tryLock();
-            //dump cache to disk.
-            session->globalComm->dumpFrameCache(frame, cacheLightCameraOnly, cacheMaterialOnly);
+            auto lckFile = std::make_shared<QLockFile>(QString::fromStdString(sLockFile));
+            bool ret = lckFile->tryLock();
+            //dump cache to disk, the lock is held until the frame is written.
+            if (cacheWriter) {
+                cacheWriter->push(frame, cacheLightCameraOnly, cacheMaterialOnly, [lckFile] {
+                    lckFile->unlock();
+                });
+            } else {
+                session->globalComm->dumpFrameCache(frame, cacheLightCameraOnly, cacheMaterialOnly);
+            }
         } else {
             auto const& viewObjs = session->globalComm->getViewObjects();
             zeno::log_debug("runner got {} view objects", viewObjs.size());
             for (auto const& [key, obj] : viewObjs) {
                 if (zeno::encodeObject(obj.get(), buffer))
-                    send_packet("{\"action\":\"viewObject\",\"key\":\"" + key + "\"}",
-                        buffer.data(), buffer.size());
+                    send_view_object(key, buffer);
                 buffer.clear();
             }
         }
 
-        send_packet("{\"action\":\"finishFrame\",\"key\":\"" + std::to_string(frame) + "\"}", "", 0);
+        if (cacheWriter)
+            sendWrittenFrames(false);
+        else
+            send_packet("{\"action\":\"finishFrame\",\"key\":\"" + std::to_string(frame) + "\"}", "", 0);
 
         if (session->globalStatus->failed())
             return onfail();
     }
+    sendWrittenFrames(true);
+    collectProfile();
+    if (!session->globalStatus->nodeStats.empty()) {
+        auto statJson = session->globalStatus->toJson();
+        send_packet("{\"action\":\"reportStatus\"}", statJson.data(), statJson.size());
+    }
     return 0;
 }
 
@@ -197,6 +347,7 @@ int runner_main(const QCoreApplication& app) {
     bool cacheautorm = false;
     std::string zsg_path = "";
     std::string projectFps = "";
+    bool persistent = false;
     QCommandLineParser cmdParser;
     cmdParser.addHelpOption();
     cmdParser.addOptions({
@@ -211,6 +362,7 @@ int runner_main(const QCoreApplication& app) {
         {"cacheautorm", "cacheautoremove", "remove cache after render"},
         {"zsg", "zsg", "zsg"},
         {"projectFps", "current project fps", "fps"},
+        {"persistent", "persistent", "keep running and read one program per line from stdin"},
         });
     cmdParser.process(app);
     if (cmdParser.isSet("sessionid"))
@@ -233,6 +385,8 @@ int runner_main(const QCoreApplication& app) {
         zsg_path = cmdParser.value("zsg").toStdString();
     if (cmdParser.isSet("projectFps"))
         projectFps = cmdParser.value("projectFps").toStdString();
+    if (cmdParser.isSet("persistent"))
+        persistent = cmdParser.value("persistent").toInt();
 
     std::cerr.rdbuf(std::cout.rdbuf());
     std::clog.rdbuf(std::cout.rdbuf());
@@ -249,6 +403,7 @@ int runner_main(const QCoreApplication& app) {
     } else {
         zeno::log_info("tcp connection succeed");
     }
+    viewRing.init(sessionid);
 #else
     zeno::log_debug("started IPC in pipe mode");
     ourfp = stdout;
@@ -256,12 +411,6 @@ int runner_main(const QCoreApplication& app) {
 
     zeno::log_debug("runner started on sessionid={}", sessionid);
 
-    std::string progJson;
-    std::istreambuf_iterator<char> iit(std::cin.rdbuf()), eiit;
-    std::back_insert_iterator<std::string> sit(progJson);
-    std::copy(iit, eiit, sit);
-
-
 #ifdef ZENO_IPC_USE_TCP
     // Notify this is runner process
     static int calledOnce = ([]{
@@ -269,6 +418,23 @@ int runner_main(const QCoreApplication& app) {
     }(), 0);
 #endif
 
-    return runner_start(progJson, sessionid, enablecache, cachenum, cachedir, cacheautorm, cacheLightCameraOnly, cacheMaterialOnly, zsg_path, projectFps);
+    if (persistent) {
+        // one program JSON per line, until the editor kills us or closes stdin
+        std::string progJson;
+        while (std::getline(std::cin, progJson)) {
+            if (progJson.empty())
+                continue;
+            runner_start(progJson, sessionid, enablecache, cachenum, cachedir, cacheautorm, cacheLightCameraOnly, cacheMaterialOnly, zsg_path, projectFps, true);
+            send_packet("{\"action\":\"runFinished\"}", "", 0);
+        }
+        return 0;
+    }
+
+    std::string progJson;
+    std::istreambuf_iterator<char> iit(std::cin.rdbuf()), eiit;
+    std::back_insert_iterator<std::string> sit(progJson);
+    std::copy(iit, eiit, sit);
+
+    return runner_start(progJson, sessionid, enablecache, cachenum, cachedir, cacheautorm, cacheLightCameraOnly, cacheMaterialOnly, zsg_path, projectFps, false);
 }
 #endif
@@ -111,10 +111,13 @@ static void getOptStr(const QString& sockType, QVariant& defl, QString& opStr)
     }
 }
 
-static void serializeGraph(IGraphsModel* pGraphsModel, const QModelIndex& subgIdx, QString const &graphIdPrefix, bool bView, RAPIDJSON_WRITER& writer, bool bNestedSubg = true, bool applyLightAndCameraOnly = false, bool applyMaterialOnly = false, const QString &configPath = "")
+static void serializeGraph(IGraphsModel* pGraphsModel, const QModelIndex& subgIdx, QString const &graphIdPrefix, bool bView, RAPIDJSON_WRITER& writer, bool bNestedSubg = true, bool applyLightAndCameraOnly = false, bool applyMaterialOnly = false, const QString &configPath = "", QSet<QString>* pDefinedSubgs = nullptr)
 {
     ZASSERT_EXIT(pGraphsModel && subgIdx.isValid());
 
+    QSet<QString> definedHere;
+    QSet<QString>& definedSubgs = pDefinedSubgs ? *pDefinedSubgs : definedHere;
+
     rapidjson::Document configDoc;
     if (!configPath.isEmpty())
     {
@@ -173,12 +176,20 @@ static void serializeGraph(IGraphsModel* pGraphsModel, const QModelIndex& subgId
             }
             else
             {
-                AddStringList({"addSubnetNode", name, ident}, writer);
-                AddStringList({"pushSubnetScope", ident}, writer);
-                const QString& prefix = nameMangling(graphIdPrefix, idx.data(ROLE_OBJID).toString());
+                //each subgraph is defined once, with names relative to the instance, which the core prefixes.
                 bool _bView = bView && (idx.data(ROLE_OPTIONS).toInt() & OPT_VIEW);
-                serializeGraph(pGraphsModel, pGraphsModel->index(name), prefix, _bView, writer, true, applyLightAndCameraOnly, applyMaterialOnly, configPath);
-                AddStringList({"popSubnetScope", ident}, writer);
+                const QString& defName = _bView ? name + ":VIEW" : name;
+                if (!definedSubgs.contains(defName))
+                {
+                    definedSubgs.insert(defName);
+                    JsonArrayBatch batch(writer);
+                    auto s = defName.toStdString();
+                    writer.String("defineSubgraph");
+                    writer.String(s.data(), s.size());
+                    JsonArrayBatch batchCmds(writer);
+                    serializeGraph(pGraphsModel, pGraphsModel->index(name), "", _bView, writer, true, applyLightAndCameraOnly, applyMaterialOnly, configPath, &definedSubgs);
+                }
+                AddStringList({"addSubgraphInstance", defName, ident, idx.data(ROLE_OBJID).toString()}, writer);
             }
         }
 
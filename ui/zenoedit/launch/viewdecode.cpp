@@ -14,6 +14,7 @@
 #include "unrealhook.h"
 #endif
 #include <rapidjson/document.h>
+#include <QSharedMemory>
 #include <type_traits>
 #include <iostream>
 #include <cassert>
@@ -44,6 +45,22 @@ struct PacketProc {
     std::string fcPath = {};
     int fcMax = 0;
 
+    QSharedMemory viewRing;     //view objects ring of the runner, see runnermain.cpp
+
+    const char *attachViewRing(std::string const &key) {
+        QString qsKey = QString::fromStdString(key);
+        if (viewRing.key() != qsKey) {
+            if (viewRing.isAttached())
+                viewRing.detach();
+            viewRing.setKey(qsKey);
+        }
+        if (!viewRing.isAttached() && !viewRing.attach(QSharedMemory::ReadOnly)) {
+            zeno::log_warn("failed to attach view ring {}: {}", key, viewRing.errorString().toStdString());
+            return nullptr;
+        }
+        return (const char *)viewRing.constData();
+    }
+
     void onStart() {
         globalCommNeedClean = 1;
         globalCommNeedNewFrame = 0;
@@ -148,13 +165,22 @@ struct PacketProc {
             zeno::getSession().globalStatus->fromJson(statJson);
 
             const auto& stat = zeno::getSession().globalStatus;
-            if (stat) {
+            for (auto const &st : stat->nodeStats) {
+                zeno::log_info("profile: {} ran {} times, {} ms total, {} ms max, {} bytes",
+                               st.name, st.count, st.totalMs, st.maxMs, st.bytes);
+            }
+            if (stat->failed()) {
                 zeno::log_error("reportStatus: error in {}, message {}", stat->nodeName, stat->error->message);
                 auto nodeName = stat->nodeName.substr(0, stat->nodeName.find(':'));
                 zenoApp->graphsManagment()->appendErr(QString::fromStdString(nodeName),
                                                       QString::fromStdString(stat->error->message));
             }
 
+        } else if (action == "runFinished") {
+            ZTcpServer* pServer = zenoApp->getServer();
+            if (pServer)
+                pServer->onRunFinished();
+
         } else {
             zeno::log_warn("unknown packet action type {}", action);
             return false;
@@ -195,6 +221,19 @@ struct PacketProc {
         const char *data = buf + header.info_size;
         size_t size = header.total_size - header.info_size;
 
+        if (auto it = root.FindMember("shm"); it != root.MemberEnd() && it->value.IsString()) {
+            //the data stays in the shared memory ring, decode it from there.
+            auto base = attachViewRing(it->value.GetString());
+            size_t offset = root["offset"].GetUint64();
+            size = root["size"].GetUint64();
+            zeno::log_debug("decoder got action=[{}] key=[{}] size={} in shared memory", action, objKey, size);
+            bool ret = base && processPacket(action, objKey, base + offset, size);
+            ZTcpServer* pServer = zenoApp->getServer();
+            if (pServer)
+                pServer->sendToRunner(QByteArray::number((qulonglong)root["end"].GetUint64()) + '\n');
+            return ret;
+        }
+
         zeno::log_debug("decoder got action=[{}] key=[{}] size={}", action, objKey, size);
 
         return processPacket(action, objKey, data, size);
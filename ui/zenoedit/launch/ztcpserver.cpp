@@ -60,7 +60,7 @@ void ZTcpServer::init(const QHostAddress& address)
 void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
 {
     ZASSERT_EXIT(m_tcpServer);
-    if (m_proc && m_proc->isOpen())
+    if (m_proc && m_proc->isOpen() && m_bRunning)
     {
         zeno::log_info("background process already running");
         return;
@@ -69,10 +69,6 @@ void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
     zeno::log_info("launching program...");
     zeno::log_debug("program JSON: {}", progJson);
 
-    m_proc = std::make_unique<QProcess>();
-    m_proc->setInputChannelMode(QProcess::InputChannelMode::ManagedInputChannel);
-    m_proc->setReadChannel(QProcess::ProcessChannel::StandardOutput);
-    m_proc->setProcessChannelMode(QProcess::ProcessChannelMode::ForwardedErrorChannel);
     int sessionid = zeno::getSession().globalState->sessionid;
 
     QString cachedir;
@@ -120,8 +116,33 @@ void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
         "--cacheautorm", QString::number(param.autoRmCurcache),
         "--zsg", param.zsgPath,
         "--projectFps", QString::number(param.projectFps),
+        "--persistent", QString::number(param.persistentRunner),
     };
 
+    if (m_proc && m_proc->isOpen())
+    {
+        if (param.persistentRunner && args == m_procArgs)
+        {
+            //the idle runner keeps its graph, and only re-evaluates what changed.
+            zeno::log_info("reusing persistent runner process");
+            viewDecodeClear();
+            m_bRunning = true;
+            m_proc->write(progJson.data(), progJson.size());
+            m_proc->write("\n", 1);
+#ifdef ZENO_OPTIX_PROC
+            sendCacheRenderInfoToOptix(cachedir, param.cacheNum, param.applyLightAndCameraOnly, param.applyMaterialOnly);
+#endif
+            return;
+        }
+        //settings changed, the idle runner cannot be reused.
+        m_proc->disconnect(this);
+        killProc();
+    }
+
+    m_proc = std::make_unique<QProcess>();
+    m_proc->setInputChannelMode(QProcess::InputChannelMode::ManagedInputChannel);
+    m_proc->setReadChannel(QProcess::ProcessChannel::StandardOutput);
+    m_proc->setProcessChannelMode(QProcess::ProcessChannelMode::ForwardedErrorChannel);
     m_proc->start(QCoreApplication::applicationFilePath(), args);
 
     if (!m_proc->waitForStarted(-1)) {
@@ -129,8 +150,13 @@ void ZTcpServer::startProc(const std::string& progJson, LAUNCH_PARAM param)
         return;
     }
 
+    m_procArgs = args;
+    m_bRunning = true;
     m_proc->write(progJson.data(), progJson.size());
-    m_proc->closeWriteChannel();
+    if (param.persistentRunner)
+        m_proc->write("\n", 1);
+    else
+        m_proc->closeWriteChannel();
 
     connect(m_proc.get(), SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(onProcFinished(int, QProcess::ExitStatus)));
     connect(m_proc.get(), SIGNAL(readyRead()), this, SLOT(onProcPipeReady()));
@@ -335,6 +361,7 @@ void ZTcpServer::killProc()
         m_proc->kill();
         m_proc = nullptr;
     }
+    m_bRunning = false;
 }
 
 void ZTcpServer::onNewConnection()
@@ -356,6 +383,12 @@ void ZTcpServer::onNewConnection()
     viewDecodeClear();
 }
 
+void ZTcpServer::sendToRunner(const QByteArray& data)
+{
+    if (m_tcpSocket)
+        m_tcpSocket->write(data);
+}
+
 void ZTcpServer::onReadyRead()
 {
     QByteArray arr = m_tcpSocket->readAll();
@@ -404,8 +437,22 @@ void ZTcpServer::onDisconnect()
     viewDecodeFinish();
 }
 
+void ZTcpServer::onRunFinished()
+{
+    //the persistent runner has finished one program and waits for the next one.
+    m_bRunning = false;
+    viewDecodeFinish();
+
+    auto mainWin = zenoApp->getMainWindow();
+    if (mainWin)
+        emit mainWin->runFinished();
+    else
+        emit runFinished();
+}
+
 void ZTcpServer::onProcFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    m_bRunning = false;
     if (exitStatus == QProcess::NormalExit)
     {
         if (m_proc)
@@ -23,6 +23,8 @@ public:
     void onFrameFinished(const QString& action, const QString& keyObj);
     void onInitFrameRange(const QString& action, int frameStart, int frameEnd);
     void onClearFrameState();
+    void onRunFinished();
+    void sendToRunner(const QByteArray& data);
 
 signals:
     void runFinished();
@@ -45,6 +47,8 @@ private:
     QLocalServer* m_optixServer;
     QVector<QLocalSocket*> m_optixSockets;
     std::unique_ptr<QProcess> m_proc;
+    QStringList m_procArgs;     //args of m_proc, a persistent runner is reused only if they match.
+    bool m_bRunning = false;
 
     std::vector<std::unique_ptr<QProcess>> m_optixProcs;
     int m_port;
@@ -943,12 +943,14 @@ void ZenoGraphsEditor::onAction(QAction* pAction, const QVariantList& args, bool
         QVariant varCacheRoot = inst.getValue("zencachedir");
         QVariant varCacheNum = inst.getValue("zencachenum");
         QVariant varAutoCleanCache = inst.getValue("zencache-autoclean");
+        QVariant varPersistentRunner = inst.getValue("zenrunner-persistent");
 
         bool bEnableCache = varEnableCache.isValid() ? varEnableCache.toBool() : false;
         bool bTempCacheDir = varTempCacheDir.isValid() ? varTempCacheDir.toBool() : false;
         QString cacheRootDir = varCacheRoot.isValid() ? varCacheRoot.toString() : "";
         int cacheNum = varCacheNum.isValid() ? varCacheNum.toInt() : 1;
         bool bAutoCleanCache = varAutoCleanCache.isValid() ? varAutoCleanCache.toBool() : true;
+        bool bPersistentRunner = varPersistentRunner.isValid() ? varPersistentRunner.toBool() : false;
 
         CALLBACK_SWITCH cbSwitch = [=](bool bOn) {
             zenoApp->getMainWindow()->setInDlgEventLoop(bOn); //deal with ubuntu dialog slow problem when update viewport.
@@ -990,6 +992,10 @@ void ZenoGraphsEditor::onAction(QAction* pAction, const QVariantList& args, bool
             pAutoCleanCache->setEnabled(state && !pTempCacheDir->isChecked());
         });
 
+        //keep the runner process and its graph between runs, unchanged nodes are not evaluated again
+        QCheckBox* pPersistentRunner = new QCheckBox;
+        pPersistentRunner->setCheckState(bPersistentRunner ? Qt::Checked : Qt::Unchecked);
+
         QDialogButtonBox* pButtonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
 
         QDialog dlg(this);
@@ -1004,7 +1010,9 @@ void ZenoGraphsEditor::onAction(QAction* pAction, const QVariantList& args, bool
         pLayout->addWidget(pathLineEdit, 3, 1);
         pLayout->addWidget(new QLabel(tr("Cache auto clean up")), 4, 0);
         pLayout->addWidget(pAutoCleanCache, 4, 1);
-        pLayout->addWidget(pButtonBox, 5, 1);
+        pLayout->addWidget(new QLabel(tr("Persistent runner")), 5, 0);
+        pLayout->addWidget(pPersistentRunner, 5, 1);
+        pLayout->addWidget(pButtonBox, 6, 1);
 
         connect(pButtonBox, SIGNAL(accepted()), &dlg, SLOT(accept()));
         connect(pButtonBox, SIGNAL(rejected()), &dlg, SLOT(reject()));
@@ -1017,6 +1025,7 @@ void ZenoGraphsEditor::onAction(QAction* pAction, const QVariantList& args, bool
             inst.setValue("zencachedir", pathLineEdit->text());
             inst.setValue("zencachenum", pSpinBox->value());
             inst.setValue("zencache-autoclean", pAutoCleanCache->checkState() == Qt::Checked);
+            inst.setValue("zenrunner-persistent", pPersistentRunner->checkState() == Qt::Checked);
         }
     }
     else if (actionType == ZenoMainWindow::ACTION_ZOOM) 
@@ -387,6 +387,7 @@ void AppHelper::initLaunchCacheParam(LAUNCH_PARAM& param)
     param.cacheDir = settings.value("zencachedir").isValid() ? settings.value("zencachedir").toString() : "";
     param.cacheNum = settings.value("zencachenum").isValid() ? settings.value("zencachenum").toInt() : 1;
     param.autoCleanCacheInCacheRoot = settings.value("zencache-autoclean").isValid() ? settings.value("zencache-autoclean").toBool() : true;
+    param.persistentRunner = settings.value("zenrunner-persistent").isValid() ? settings.value("zenrunner-persistent").toBool() : false;
 }
 
 bool AppHelper::openZsgAndRun(const ZENO_RECORD_RUN_INITPARAM& param, LAUNCH_PARAM launchParam)
@@ -7,6 +7,8 @@
 #include <functional>
 #include <variant>
 #include <memory>
+#include <vector>
+#include <cstdint>
 #include <string>
 #include <set>
 #include <any>
@@ -17,13 +19,39 @@ namespace zeno {
 struct Session;
 struct SubgraphNode;
 struct DirtyChecker;
+struct ParallelExecutor;
+struct IncrementalCache;
+struct LivenessTracker;
+struct ExecPlan;
 struct INode;
+struct INodeClass;
+struct SubgraphDefinition;
 
 struct Context {
-    std::set<std::string> visited;
+    std::vector<std::uint64_t> visited;  // bit per INode::execIndex
+
+    bool isVisited(int i) const {
+        std::size_t w = i >> 6;
+        return w < visited.size() && (visited[w] >> (i & 63) & 1);
+    }
+
+    // false if it was already visited
+    bool markVisited(int i) {
+        std::size_t w = i >> 6;
+        if (w >= visited.size())
+            visited.resize(w + 1);
+        auto bit = std::uint64_t(1) << (i & 63);
+        if (visited[w] & bit)
+            return false;
+        visited[w] |= bit;
+        return true;
+    }
 
     inline void mergeVisited(Context const &other) {
-        visited.insert(other.visited.begin(), other.visited.end());
+        if (visited.size() < other.visited.size())
+            visited.resize(other.visited.size());
+        for (std::size_t w = 0; w < other.visited.size(); w++)
+            visited[w] |= other.visited[w];
     }
 
     ZENO_API Context();
@@ -43,9 +71,20 @@ struct Graph : std::enable_shared_from_this<Graph> {
     std::map<std::string, zany> portals;
     std::map<std::string, std::string> subInputNodes;
     std::map<std::string, std::string> subOutputNodes;
+    std::map<std::string, std::shared_ptr<SubgraphDefinition>> subgraphDefs;  // from defineSubgraph, kept across loadGraph
 
     std::unique_ptr<Context> ctx;
     std::unique_ptr<DirtyChecker> dirtyChecker;
+    std::unique_ptr<IncrementalCache> incrementalCache;  // only set by the persistent runner
+
+    bool parallelExec = false;  // evaluate independent branches concurrently, env ZENO_PARALLEL_GRAPH
+    ParallelExecutor *executor = nullptr;  // only set while the parallel executor is running
+
+    bool releaseOutputs = true;  // drop outputs once consumed, env ZENO_RELEASE_OUTPUTS
+    LivenessTracker *liveness = nullptr;  // only set while applyNodes is running
+
+    std::shared_ptr<ExecPlan const> execPlan;  // see getExecPlan
+    bool execPlanStale = false;  // nodes or links changed, the plan is rebuilt keeping its slots
 
     ZENO_API Graph();
     ZENO_API ~Graph();
@@ -60,9 +99,14 @@ struct Graph : std::enable_shared_from_this<Graph> {
     ZENO_API void applyNodesToExec();
     ZENO_API void applyNodes(std::set<std::string> const &ids);
     ZENO_API void addNode(std::string const &cls, std::string const &id);
+    ZENO_API void addNode(INodeClass *cl, std::string const &id);
+    ZENO_API void removeNode(std::string const &id);
     ZENO_API Graph *addSubnetNode(std::string const &id);
     ZENO_API Graph *getSubnetGraph(std::string const &id) const;
+    ZENO_API Graph *addSubgraphInstance(SubgraphDefinition const &def, std::string const &id, std::string const &prefix);
     ZENO_API bool applyNode(std::string const &id);
+    ZENO_API bool applyNode(INode *node);
+    ZENO_API std::shared_ptr<ExecPlan const> const &getExecPlan();
     ZENO_API void completeNode(std::string const &id);
     ZENO_API void bindNodeInput(std::string const &dn, std::string const &ds,
         std::string const &sn, std::string const &ss);
@@ -72,6 +116,7 @@ struct Graph : std::enable_shared_from_this<Graph> {
     ZENO_API void setFormula(std::string const &id, std::string const &par, zany const &val);
     ZENO_API void addNodeOutput(std::string const &id, std::string const &par);
     ZENO_API zany const &getNodeOutput(std::string const &sn, std::string const &ss) const;
+    ZENO_API zany const &getNodeOutput(INode *node, std::string const &ss) const;
     ZENO_API void loadGraph(const char *json);
     ZENO_API void setNodeParam(std::string const &id, std::string const &par,
         std::variant<int, float, std::string, zany> const &val);  /* to be deprecated */
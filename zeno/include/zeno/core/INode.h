@@ -27,6 +27,7 @@ public:
     INodeClass *nodeClass = nullptr;
 
     std::string myname;
+    int execIndex = -1;  // slot in the graph's ExecPlan, assigned when the plan is built
     std::map<std::string, std::pair<std::string, std::string>> inputBounds;
     std::map<std::string, zany> inputs;
     std::map<std::string, zany> outputs;
@@ -34,6 +35,9 @@ public:
     std::set<std::string> formulas;
     zany muted_output;
 
+    struct FormulaCache;
+    std::shared_ptr<FormulaCache> formulaCache;  // last value of each keyframe and formula input, shared by copies
+
     ZENO_API INode();
     ZENO_API virtual ~INode();
 
@@ -56,6 +60,15 @@ public:
 
     ZENO_API virtual void preApply();
 
+    // true when preApply() decides itself which inputs to require
+    ZENO_API virtual bool hasLazyInputs() const;
+
+    // false when outputs don't only depend on inputs (random, internal state...), see IncrementalCache
+    // defaults to false for nodes without outputs or with a writepath socket, as they run for side effects
+    ZENO_API virtual bool isPure() const;
+    // opt-in for MemoCache, which hashes the inputs and may serve the outputs to any graph
+    ZENO_API virtual bool isMemoizable() const;
+
     ZENO_API Graph *getThisGraph() const;
     ZENO_API Session *getThisSession() const;
     ZENO_API GlobalState *getGlobalState() const;
@@ -70,9 +83,12 @@ public:
     ZENO_API bool has_formula(std::string const &id) const;
     ZENO_API zany get_formula(std::string const &id) const;
 
+    // the error messages are only formatted on failure, these are called a lot
     template <class T>
     std::shared_ptr<T> get_input(std::string const &id) const {
         auto obj = get_input(id);
+        if (auto p = std::dynamic_pointer_cast<T>(obj))
+            return p;
         return safe_dynamic_cast<T>(std::move(obj), "input socket `" + id + "` of node `" + myname + "`");
     }
 
@@ -91,7 +107,10 @@ public:
 
     template <class T>
     auto get_input2(std::string const &id) const {
-        return objectToLiterial<T>(get_input(id), "input socket `" + id + "` of node `" + myname + "`");
+        auto obj = get_input(id);
+        if (!objectIsLiterial<T>(obj))
+            return objectToLiterial<T>(obj, "input socket `" + id + "` of node `" + myname + "`");
+        return objectToLiterial<T>(obj);
     }
 
     template <class T>
@@ -14,6 +14,7 @@ struct INode;
 
 struct INodeClass {
     std::unique_ptr<Descriptor> desc;
+    std::string classname;  // set by Session::defNodeClass, empty for subnets
 
     ZENO_API INodeClass(Descriptor const &desc);
     ZENO_API virtual ~INodeClass();
@@ -27,6 +28,7 @@ struct GlobalComm;
 struct GlobalStatus;
 struct EventCallbacks;
 struct UserData;
+struct MemoCache;
 
 struct Session {
     std::map<std::string, std::unique_ptr<INodeClass>> nodeClasses;
@@ -36,6 +38,7 @@ struct Session {
     std::unique_ptr<GlobalStatus> const globalStatus;
     std::unique_ptr<EventCallbacks> const eventCallbacks;
     std::unique_ptr<UserData> const m_userData;
+    std::unique_ptr<MemoCache> const memoCache;
 
     ZENO_API Session();
     ZENO_API ~Session();
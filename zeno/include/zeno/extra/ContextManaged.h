@@ -11,6 +11,15 @@ namespace zeno {
 struct ContextManagedNode : INode {
     std::unique_ptr<Context> m_ctx = nullptr;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
+    // true when outputs evaluate the node's upstream again once called (FuncEnd)
+    virtual bool hasReentrantOutputs() const {
+        return false;
+    }
+
     void push_context() {
         assert(!m_ctx);
         m_ctx = std::move(graph->ctx);
@@ -6,18 +6,22 @@
 #include <zeno/funcs/ObjectCodec.h>
 #include <zeno/types/UserData.h>
 #include <set>
+#include <mutex>
 #include <string>
 
 namespace zeno {
 
 struct DirtyChecker {
     std::set<std::string> dirts;
+    mutable std::mutex mtx;  // nodes may be applied concurrently by ParallelExecutor
 
     void taintThisNode(std::string ident) {
+        std::lock_guard lck(mtx);
         dirts.insert(std::move(ident));
     }
 
     bool amIDirty(std::string const &ident) const {
+        std::lock_guard lck(mtx);
         return dirts.find(ident) != dirts.end();
     }
 };
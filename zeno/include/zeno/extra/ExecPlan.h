@@ -0,0 +1,51 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/core/INode.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace zeno {
+
+struct Graph;
+
+/* A graph lowered for evaluation: every node gets a dense slot number
+ * (INode::execIndex), which Context::visited is a bitset of, and the node each
+ * input is bound to is resolved once, so pulling inputs follows pointers
+ * instead of looking names up in Graph::nodes again and again, e.g. for every
+ * iteration of a loop body.
+ *
+ * Graph::getExecPlan() builds it lazily and again after nodes were added or
+ * removed or links changed through the Graph API, which stays the way to edit
+ * a graph. Slots of the nodes still there are kept across rebuilds.
+ */
+struct ExecPlan {
+    struct Input {
+        std::string const *ds;  // socket of the consumer, key of its inputBounds
+        std::string const *sn, *ss;
+        INode *src;             // nullptr when bound to a node that doesn't exist
+    };
+
+    struct Slot {
+        INode *node = nullptr;  // nullptr for the slots of removed nodes
+        std::vector<Input> inputs;  // in inputBounds order
+    };
+
+    std::vector<Slot> slots;
+    std::size_t nodeCount = 0;
+
+    ZENO_API ExecPlan(Graph *graph, ExecPlan const *previous);
+
+    // inputs of a node of the graph, nullptr for nodes outside of it, like temp nodes
+    std::vector<Input> const *inputsOf(INode const *node) const {
+        auto i = node->execIndex;
+        if (i < 0 || (std::size_t)i >= slots.size() || slots[i].node != node)
+            return nullptr;
+        return &slots[i].inputs;
+    }
+
+    ZENO_API static void resolveInputs(Graph *graph, INode *node, std::vector<Input> &inputs);
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace zeno {
+
+struct GlobalComm;
+
+/* Writes zencache frames on its own threads, so that the next frame can be
+ * simulated while the previous ones are encoded and flushed.
+ *
+ * push() takes the view objects of a finished frame out of GlobalComm and
+ * blocks while ZENO_ZENCACHE_QUEUE frames (default 2) are already pending, so
+ * memory stays bounded when the disk is slower than the simulation, or when
+ * the disk space guard of the writer is waiting. ZENO_ZENCACHE_WRITERS threads
+ * (default 2) do the writing.
+ */
+struct FrameCacheWriter {
+    ZENO_API explicit FrameCacheWriter(GlobalComm *comm);
+    ZENO_API ~FrameCacheWriter();  // waits for the pending frames
+
+    FrameCacheWriter(FrameCacheWriter const &) = delete;
+    FrameCacheWriter &operator=(FrameCacheWriter const &) = delete;
+
+    // onWritten is called on a writer thread once the frame is on disk
+    ZENO_API void push(int frameid, bool cacheLightCameraOnly, bool cacheMaterialOnly,
+                       std::function<void()> onWritten = {});
+
+    // frames written since the last call, in push() order, up to the first one still pending
+    ZENO_API std::vector<int> takeWritten();
+
+    ZENO_API void wait();
+
+private:
+    struct Job;
+
+    GlobalComm *m_comm;
+    std::size_t m_maxPending;
+    std::deque<std::unique_ptr<Job>> m_queue;  // not started yet
+    std::deque<std::pair<int, bool>> m_order;  // frame and whether it is written, in push() order
+    std::size_t m_npending = 0;
+    bool m_stop = false;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::vector<std::thread> m_threads;
+
+    void worker();
+};
+
+}
@@ -12,6 +12,8 @@
 
 namespace zeno {
 
+struct mapped_file;
+
 struct GlobalComm {
     using ViewObjects = PolymorphicMap<std::map<std::string, std::shared_ptr<IObject>>>;
 
@@ -21,8 +23,16 @@ struct GlobalComm {
         FRAME_BROKEN
     };
 
+    // an object of a frame loaded back from disk, decoded on first access
+    struct LazyObject {
+        std::shared_ptr<mapped_file> file;
+        std::size_t offset = 0;
+        std::size_t size = 0;
+    };
+
     struct FrameData {
         ViewObjects view_objects;
+        std::map<std::string, LazyObject> lazy_objects;
         FRAME_STATE frame_state = FRAME_UNFINISH;
     };
     std::vector<FrameData> m_frames;
@@ -40,6 +50,9 @@ struct GlobalComm {
     ZENO_API void newFrame();
     ZENO_API void finishFrame();
     ZENO_API void dumpFrameCache(int frameid, bool cacheLightCameraOnly = false, bool cacheMaterialOnly = false);
+    // dumpFrameCache in two steps, so that the encoding and writing can happen without holding the lock
+    ZENO_API bool takeFrameCache(int frameid, ViewObjects &objs, std::string &cachedir);
+    ZENO_API static void writeFrameCache(std::string const &cachedir, int frameid, ViewObjects &objs, bool cacheLightCameraOnly, bool cacheMaterialOnly);
     ZENO_API void addViewObject(std::string const &key, std::shared_ptr<IObject> object);
     ZENO_API int maxPlayFrames();
     ZENO_API int numOfFinishedFrame();
@@ -49,9 +62,11 @@ struct GlobalComm {
     ZENO_API void clearFrameState();
     ZENO_API ViewObjects const *getViewObjects(const int frameid);
     ZENO_API ViewObjects const &getViewObjects();
+    // objects for which isNeeded returns false are passed as nullptr if not decoded yet
     ZENO_API bool load_objects(const int frameid, 
                 const std::function<bool(std::map<std::string, std::shared_ptr<zeno::IObject>> const& objs)>& cb,
-                bool& isFrameValid);
+                bool& isFrameValid,
+                const std::function<bool(std::string const& key)>& isNeeded = {});
     ZENO_API bool isFrameCompleted(int frameid) const;
     ZENO_API FRAME_STATE getFrameState(int frameid) const;
     ZENO_API bool isFrameBroken(int frameid) const;
@@ -62,6 +77,7 @@ struct GlobalComm {
 
 private:
     ViewObjects const *_getViewObjects(const int frameid);
+    FrameData *_loadFrame(const int frameid);
 };
 
 }
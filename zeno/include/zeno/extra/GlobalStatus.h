@@ -1,9 +1,11 @@
 #pragma once
 
 #include <zeno/utils/Error.h>
+#include <zeno/extra/Profiler.h>
 #include <string_view>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace zeno {
 
@@ -12,6 +14,7 @@ struct INode;
 struct GlobalStatus {
     std::string nodeName;
     std::shared_ptr<Error> error;
+    std::vector<Profiler::NodeStat> nodeStats;  // filled by the runner when profiling
 
     bool failed() const {
         return !nodeName.empty();
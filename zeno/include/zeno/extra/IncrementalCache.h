@@ -0,0 +1,65 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/core/IObject.h>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <set>
+#include <map>
+
+namespace zeno {
+
+struct Graph;
+struct INode;
+
+/* Lets a long-lived Graph re-evaluate only what changed between two programs
+ * sent by the editor (see the persistent mode of runnermain.cpp).
+ *
+ * loadGraph() compares the commands of every top-level node with the previous
+ * program. Changed nodes and everything downstream of them are re-created from
+ * scratch, so stateful nodes behave exactly like in a fresh run; other nodes
+ * keep their objects. Nodes with lazy inputs or hidden dependencies (e.g.
+ * PortalOut, EndFor) drag their whole upstream along when they re-run.
+ *
+ * During a pass (the first substep of a run), the outputs of every applied node
+ * are cloned right after apply(), since consumers may modify their inputs in
+ * place; dummy, numeric and string objects are shared instead. The next pass
+ * at the same frame restores these outputs instead of applying the unchanged
+ * nodes again. Nodes that accessed the session (frame number...) or are not
+ * pure (random, internal state) may give another result once applied
+ * again, so they and their consumers are re-created on the next loadGraph().
+ *
+ * A node with a string input naming a file is re-created as well when the size
+ * or mtime of that file changed since it was applied, like MemoCache checks
+ * them. Files a node finds by other means (e.g. a directory listing) are not
+ * tracked, such nodes keep their old result until one of their parameters
+ * changes.
+ */
+struct IncrementalCache {
+    // same format as Graph::loadGraph, applied as a diff against the last program
+    ZENO_API void loadGraph(Graph *graph, const char *json);
+
+    ZENO_API void beginPass(int frameid);
+    ZENO_API void endPass();
+
+    ZENO_API bool isReusable(std::string const &id) const;
+
+    // evaluate node through apply(), or restore its kept outputs, returns false in the latter case
+    ZENO_API bool applyNode(INode *node, std::function<void()> const &apply);
+
+private:
+    std::map<std::string, std::string> m_programs;  // commands of each top-level node, last program
+    std::map<std::string, std::map<std::string, zany>> m_kept;
+    std::map<std::string, std::set<std::string>> m_hiddenDeps;  // applied by a node outside of its inputBounds
+    std::set<std::string> m_touched;  // applied while depending on more than their inputs
+    std::map<std::string, std::uint64_t> m_fileStamps;  // of the files named by their inputs when applied
+    int m_frameid = 0;
+    bool m_inPass = false;
+    mutable std::mutex m_mtx;
+
+    void forget(std::string const &id);
+};
+
+}
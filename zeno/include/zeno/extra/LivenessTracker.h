@@ -0,0 +1,56 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <set>
+
+namespace zeno {
+
+struct Graph;
+struct INode;
+
+/* Drops node outputs during Graph::applyNodes as soon as every consumer has
+ * pulled them, so that a long chain over a big object doesn't keep all of its
+ * intermediate versions alive. Consumers forget the inputs they pulled once
+ * applied too, since they are pulled again on the next run anyway.
+ *
+ * Consumer counts come from inputBounds. Outputs are kept for the nodes being
+ * executed (they are the result, e.g. subnet outputs), for lazy nodes and all
+ * of their upstream (loops and caches pull again, or skip applying), for nodes
+ * referenced by ref() in any string input (formulas, wrangle code...) and the
+ * producers of their inputs, and for nodes not pulled by all of their consumers
+ * during the run.
+ *
+ * Enabled unless env ZENO_RELEASE_OUTPUTS=0, and never together with an
+ * IncrementalCache, which relies on outputs surviving the run. With env
+ * ZENO_MEMORY_BUDGET_MB set, a warning (once per process) names the node after
+ * which the resident memory first exceeded the budget.
+ */
+struct LivenessTracker {
+    ZENO_API LivenessTracker(Graph *graph, std::set<std::string> const &ids);
+    ZENO_API ~LivenessTracker();
+
+    LivenessTracker(LivenessTracker const &) = delete;
+    LivenessTracker &operator=(LivenessTracker const &) = delete;
+
+    // an output of node src was pulled by a consumer, may be called concurrently
+    ZENO_API void notePulled(INode *src);
+
+    // node finished applying, may be called concurrently for distinct nodes
+    ZENO_API void noteApplied(INode *node);
+
+    // resident memory of the process in bytes, 0 if unknown on this platform
+    ZENO_API static std::size_t residentBytes();
+
+private:
+    Graph *const graph;
+    std::unordered_map<INode *, std::atomic<int>> m_pending;  // pulls left, for releasable nodes only
+    std::unordered_set<INode *> m_pinned;
+    std::size_t m_budget = 0;
+};
+
+}
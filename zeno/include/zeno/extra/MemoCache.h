@@ -0,0 +1,95 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/core/IObject.h>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <list>
+#include <map>
+
+namespace zeno {
+
+struct INode;
+
+/* Graph-wide memoization of node outputs, enabled by env ZENO_MEMOIZE.
+ *
+ * The key of a node is hashed from its class name and all of its inputs: an
+ * input produced by a memoized node contributes that node's key and socket
+ * name, any other input contributes a hash of its encoded content (plus size
+ * and mtime when it is a string naming an existing file). Identical subgraphs
+ * thus hit the cache on every frame, whichever graph they live in.
+ *
+ * Outputs are kept encoded by ObjectCodec, which doubles as a deep copy and a
+ * size estimate for the ZENO_MEMOIZE_MB byte budget. Least recently used
+ * entries are evicted to ZENO_MEMOIZE_DIR when set, so that later runs can
+ * pick them up again.
+ *
+ * Only node classes opting in through INode::isMemoizable() are memoized.
+ * They are still applied when they have lazy inputs, keyframes or formulas,
+ * access the session or global state (frame number, view objects...) during
+ * apply(), or take or produce objects that ObjectCodec can't give back as is
+ * (see canEncodeObject). Objects taken or produced by applied nodes lose their
+ * memoized key, so that in-place modifications are hashed by content downstream.
+ */
+struct MemoCache {
+    using Key = std::uint64_t;
+
+    ZENO_API MemoCache();
+    ZENO_API ~MemoCache();
+
+    MemoCache(MemoCache const &) = delete;
+    MemoCache &operator=(MemoCache const &) = delete;
+
+    bool enabled() const {
+        return m_enabled;
+    }
+
+    ZENO_API void setEnabled(bool enabled);
+    ZENO_API void setBudget(std::size_t bytes);
+    ZENO_API void setSpillDir(std::string dir);
+    ZENO_API void clear();
+
+    // evaluate node through apply(), or restore its memoized outputs, returns false in the latter case
+    ZENO_API bool applyNode(INode *node, std::function<void()> const &apply);
+
+    // called by INode accessors, marks the node being applied on this thread as impure
+    ZENO_API static void noteSessionAccess();
+    // number of such accesses on this thread, grows while a node or any node it applies access the session
+    ZENO_API static int sessionAccesses();
+    // hash of the size and mtime of the file a string object names, 0 if it names no regular file
+    ZENO_API static Key fileStamp(IObject const *obj);
+
+private:
+    struct Entry {
+        Key key = 0;
+        std::map<std::string, std::vector<char>> outputs;  // empty buffer for null outputs
+        std::size_t bytes = 0;
+    };
+
+    std::list<Entry> m_lru;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator> m_lut;
+    std::unordered_map<IObject const *, std::pair<std::weak_ptr<IObject>, Key>> m_objKeys;
+    std::size_t m_objKeysPruneAt = 1024;
+    std::size_t m_bytes = 0;
+    std::size_t m_budget = 0;
+    std::string m_spillDir;
+    bool m_enabled = false;
+    mutable std::mutex m_mtx;
+
+    bool makeKey(INode *node, Key &key);
+    bool hashInput(zany const &obj, Key &hash);
+    bool restore(INode *node, Key key);
+    void store(Entry entry);
+    void evict();
+    void remember(zany const &obj, Key hash);
+    void forget(INode *node);
+    bool loadSpilled(Key key, Entry &entry) const;
+    void spill(Entry const &entry) const;
+};
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/extra/GraphException.h>
+#include <unordered_map>
+#include <cstddef>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <map>
+
+namespace zeno {
+
+struct Graph;
+struct INode;
+struct thread_pool;
+
+/* Dataflow scheduler used by Graph::applyNodes when Graph::parallelExec is on.
+ *
+ * Nodes with lazy inputs (control flow, caches, see INode::hasLazyInputs),
+ * nodes downstream of a function (FuncEnd, whose calls evaluate the function
+ * body again) and everything upstream of them are evaluated first by the
+ * ordinary recursive Graph::applyNode, so push_context/pop_context never race
+ * with workers. The remaining nodes form a DAG built from inputBounds and run
+ * on the global thread_pool as soon as their inputs are ready. When several
+ * nodes fail, the one a serial run would have reached first is reported.
+ */
+struct ParallelExecutor {
+    enum SlotState : int {
+        Pending, Running, Done,
+    };
+
+    struct Slot {
+        INode *node = nullptr;
+        std::size_t order = 0;  // index in the serial depth-first evaluation order
+        std::vector<Slot *> consumers;
+        std::atomic<std::size_t> npending{0};
+        std::atomic<int> state{Pending};
+        std::unique_ptr<GraphException> error;
+    };
+
+    Graph *const graph;
+    thread_pool &pool;
+
+    ZENO_API explicit ParallelExecutor(Graph *graph);
+    ZENO_API ~ParallelExecutor();
+
+    ParallelExecutor(ParallelExecutor const &) = delete;
+    ParallelExecutor &operator=(ParallelExecutor const &) = delete;
+
+    ZENO_API void execute(std::set<std::string> const &ids);
+    ZENO_API bool applyNode(std::string const &id);
+
+private:
+    std::deque<Slot> m_slots;
+    std::unordered_map<std::string, Slot *> m_lut;
+    std::map<std::string, Slot> m_unplanned;
+    std::mutex m_mtx;
+    std::atomic<std::size_t> m_nremain{0};
+    std::atomic<std::size_t> m_failorder{static_cast<std::size_t>(-1)};
+
+    bool claimAndRun(Slot &slot);
+    void runSlot(Slot &slot);
+    void schedule(Slot *slot);
+    void markFailed(std::size_t order);
+    bool isDirty(std::string const &id) const;
+};
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace zeno {
+
+/* Records spans (node applies, parallel_for chunks, cache I/O) into per-thread
+ * buffers, so recording never contends on a global lock. It is switched on at
+ * startup by env ZENO_PROFILE, or at runtime with setEnabled(), and a disabled
+ * Span costs one relaxed atomic load.
+ *
+ * traceJson() is the Chrome trace event format, to be opened in chrome://tracing
+ * or ui.perfetto.dev. Bytes allocated inside node spans are only counted when
+ * built with ZENO_PROFILE_ALLOC, which replaces the global operator new.
+ */
+struct Profiler {
+    struct NodeStat {
+        std::string name;
+        int count = 0;
+        double totalMs = 0;
+        double maxMs = 0;
+        std::size_t bytes = 0;  // allocated on the applying thread, 0 without ZENO_PROFILE_ALLOC
+    };
+
+    struct Span {
+        // cat must be a string literal, name is copied only when profiling is on
+        ZENO_API Span(const char *cat, std::string_view name);
+        ZENO_API ~Span();
+
+        Span(Span const &) = delete;
+        Span &operator=(Span const &) = delete;
+
+    private:
+        const char *m_cat;
+        std::string m_name;
+        std::int64_t m_beg = -1;  // -1 when not recording
+        std::size_t m_bytes = 0;
+        Span *m_parent = nullptr;
+
+        friend Profiler;
+    };
+
+    ZENO_API static bool enabled();
+    ZENO_API static void setEnabled(bool on);
+    ZENO_API static void clear();
+
+    // name of the innermost span on the calling thread, empty if none
+    ZENO_API static std::string currentSpan();
+
+    ZENO_API static std::string traceJson();
+    ZENO_API static bool writeTrace(std::string const &path);
+
+    // per node name, sorted by total time, slowest first
+    ZENO_API static std::vector<NodeStat> nodeStats();
+};
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace zeno {
+
+struct Graph;
+
+/* The commands of a graph json parsed once: literal values are converted and
+ * node classes looked up ahead, so a subgraph used by many instances is
+ * instantiated from here instead of going through its json every time.
+ *
+ * Node names are relative to the instance, which prefixes them with its path
+ * ("instance/node") just like the editor used to when inlining subgraphs.
+ * A definition is immutable once parsed, each instance gets its own nodes and
+ * copies of the literal inputs, so instances can be evaluated concurrently.
+ */
+struct SubgraphDefinition {
+    struct State;
+
+    struct Command {
+        std::string node;  // relative name of the node it applies to, for error reports
+        std::function<void(State &, std::string const &)> apply;
+    };
+
+    std::vector<Command> commands;
+
+    // parses a json array of commands, defineSubgraph ones are registered into root->subgraphDefs
+    ZENO_API static std::shared_ptr<SubgraphDefinition> parse(Graph *root, const char *json);
+
+    ZENO_API void instantiate(Graph *g, std::string const &prefix) const;
+};
+
+}
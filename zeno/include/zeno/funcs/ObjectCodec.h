@@ -7,7 +7,14 @@
 
 namespace zeno {
 
+struct ObjectCodecOptions {
+    bool compress = false;       // per-attribute codecs for primitives, decoding doesn't need to know
+    float quantizeError = 0;     // max absolute error of pos/vel when compressed, 0 for lossless
+};
+
 ZENO_API std::shared_ptr<IObject> decodeObject(const char *buf, size_t len);
-ZENO_API bool encodeObject(IObject const *object, std::vector<char> &buf);
+ZENO_API bool encodeObject(IObject const *object, std::vector<char> &buf, ObjectCodecOptions const &opts = {});
+// quiet check that decoding gives back an equal object: exact types only, user data included
+ZENO_API bool canEncodeObject(IObject const *object);
 
 }
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/utils/vec.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace zeno {
+
+struct PrimitiveObject;
+
+/* Connectivity of a primitive in CSR form (offsets of n + 1 entries into a flat
+ * array). Lines, tris, quads and polys are numbered as faces in this order, each
+ * one a loop of corners, and corner c starts the half-edge going to the next
+ * corner of its face. A line is a face of two corners, so its two half-edges are
+ * opposite to each other.
+ */
+struct PrimAdjacency {
+    enum FaceType { Lines, Tris, Quads, Polys };
+
+    int faceBegin[5]{};              // faces of type t are [faceBegin[t], faceBegin[t + 1])
+    std::vector<int> faceCornerOffs;  // corners of face f are [faceCornerOffs[f], faceCornerOffs[f + 1])
+    std::vector<int> cornerVert;
+    std::vector<int> cornerFace;
+
+    std::vector<int> vertCornerOffs;
+    std::vector<int> vertCorners;     // corners on each vert, ascending, so their faces are too
+    std::vector<int> vertVertOffs;
+    std::vector<int> vertVerts;       // verts sharing an edge with each vert, ascending
+
+    std::vector<vec2i> edges;         // undirected, with edges[e][0] < edges[e][1], sorted
+    std::vector<int> vertEdgeOffs;    // edges starting from each vert, that is to a higher one
+    std::vector<int> edgeFaceOffs;
+    std::vector<int> edgeFaces;       // faces around each edge, ascending
+    std::vector<int> cornerEdge;      // edge of the half-edge starting at each corner
+    std::vector<int> cornerOpposite;  // half-edge going the other way, -1 on boundaries
+
+    std::uint64_t topologyHash = 0;   // set by primAdjacency, which checks the cache against it
+
+    int numVerts() const {
+        return (int)vertCornerOffs.size() - 1;
+    }
+
+    int numFaces() const {
+        return faceBegin[4];
+    }
+
+    int nextCorner(int c) const {
+        int f = cornerFace[c];
+        return c + 1 == faceCornerOffs[f + 1] ? faceCornerOffs[f] : c + 1;
+    }
+
+    int prevCorner(int c) const {
+        int f = cornerFace[c];
+        return c == faceCornerOffs[f] ? faceCornerOffs[f + 1] - 1 : c - 1;
+    }
+
+    // edge id of verts a and b, -1 if they are not connected
+    ZENO_API int findEdge(int a, int b) const;
+
+    template <class F>
+    void foreach_vert_corner(int v, F const &f) const {
+        for (int i = vertCornerOffs[v]; i < vertCornerOffs[v + 1]; i++)
+            f(vertCorners[i]);
+    }
+
+    template <class F>
+    void foreach_vert_vert(int v, F const &f) const {
+        for (int i = vertVertOffs[v]; i < vertVertOffs[v + 1]; i++)
+            f(vertVerts[i]);
+    }
+
+    template <class F>
+    void foreach_edge_face(int e, F const &f) const {
+        for (int i = edgeFaceOffs[e]; i < edgeFaceOffs[e + 1]; i++)
+            f(edgeFaces[i]);
+    }
+
+    ZENO_API static std::shared_ptr<PrimAdjacency> build(PrimitiveObject const *prim);
+    ZENO_API static std::uint64_t hashTopology(PrimitiveObject const *prim);
+};
+
+// adjacency of prim, cached on it and rebuilt only when lines, tris, quads,
+// polys, loops or the vert count changed since, safe to call concurrently
+ZENO_API std::shared_ptr<PrimAdjacency const> primAdjacency(PrimitiveObject const *prim);
+
+}
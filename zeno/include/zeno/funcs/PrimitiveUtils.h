@@ -32,9 +32,13 @@ ZENO_API void primLineDistance(PrimitiveObject *prim, std::string resAttr, int s
 
 ZENO_API void primFilterVerts(PrimitiveObject *prim, std::string tagAttr, int tagValue, bool isInversed = false, std::string revampAttrO = {}, std::string method = "verts");
 
-ZENO_API void primMarkIsland(PrimitiveObject *prim, std::string tagAttr);
+// islands are numbered from 0 in order of their lowest vert, returns how many verts each one has
+ZENO_API std::vector<int> primMarkIsland(PrimitiveObject *prim, std::string tagAttr);
 ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr);
 
+// merges verts closer than distance, transitively, and returns how many are left
+ZENO_API int primFuse(PrimitiveObject *prim, float distance, std::string method = "average");
+
 ZENO_API void primSimplifyTag(PrimitiveObject *prim, std::string tagAttr);
 ZENO_API void primColorByTag(PrimitiveObject *prim, std::string tagAttr, std::string clrAttr, int seed = -1);
 
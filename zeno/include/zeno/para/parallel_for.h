@@ -2,12 +2,17 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <algorithm>
+#include <iterator>
+#include <type_traits>
 
 namespace zeno {
 
+#ifdef ZENO_PARALLEL_STL
+
 template <class Index, class Func>
-void parallel_for(Index first, Index last, Func func) {
+void parallel_for(Index first, Index last, Func func, std::size_t grain = 0) {
     std::for_each(ZENO_PAR counter_iterator<Index>(first), counter_iterator<Index>(last), func);
 }
 
@@ -21,4 +26,38 @@ void parallel_for_each(It first, It last, Func func) {
     std::for_each(ZENO_PAR_UNSEQ first, last, func);
 }
 
+#else
+
+template <class Index, class Func>
+void parallel_for(Index first, Index last, Func func, std::size_t grain = 0) {
+    if (!(first < last))
+        return;
+    std::size_t n = static_cast<std::size_t>(last - first);
+    auto &pool = thread_pool::global();
+    pool.for_each_chunk(n, pool.chunk_count(n, grain), [&] (std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t i = b; i < e; i++) {
+            func(static_cast<Index>(first + static_cast<Index>(i)));
+        }
+    });
+}
+
+template <class Index, class Func>
+void parallel_for(Index count, Func func) {
+    parallel_for(Index{}, count, std::move(func));
+}
+
+template <class It, class Func>
+void parallel_for_each(It first, It last, Func func) {
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                  typename std::iterator_traits<It>::iterator_category>) {
+        parallel_for(std::ptrdiff_t{}, last - first, [&] (std::ptrdiff_t i) {
+            func(first[i]);
+        });
+    } else {
+        std::for_each(first, last, func);
+    }
+}
+
+#endif
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/para/execution.h>
+#include <zeno/para/thread_pool.h>
 #include <functional>
 #include <algorithm>
 #include <array>
@@ -10,7 +11,13 @@ namespace zeno {
 template <class ...Tasks>
 void parallel_invoke(Tasks &&...tasks) {
     std::array<std::function<void()>, sizeof...(Tasks)> tmp{std::forward<Tasks>(tasks)...};
+#ifdef ZENO_PARALLEL_STL
     std::for_each(ZENO_PAR tmp.begin(), tmp.end(), [] (auto &&f) { std::move(f)(); });
+#else
+    thread_pool::global().for_each_chunk(tmp.size(), tmp.size(), [&] (std::size_t i, std::size_t, std::size_t) {
+        std::move(tmp[i])();
+    });
+#endif
 }
 
 //inline void parallel_invoke(std::initializer_list<std::function<void()> tasks) {
@@ -2,24 +2,60 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <zeno/utils/type_traits.h>
 #include <zeno/utils/vec.h>
+#include <optional>
 #include <numeric>
 #include <limits>
+#include <vector>
 #include <tuple>
 
 namespace zeno {
 
+#ifdef ZENO_PARALLEL_STL
+
+template <class It, class Value, class Reduce, class Transform>
+Value parallel_transform_reduce(It first, It last, Value initVal, Reduce reduceFn, Transform transformFn) {
+    return std::transform_reduce(ZENO_PAR first, last, initVal, reduceFn, transformFn);
+}
+
+#else
+
+template <class It, class Value, class Reduce, class Transform>
+Value parallel_transform_reduce(It first, It last, Value initVal, Reduce reduceFn, Transform transformFn) {
+    if (first == last)
+        return initVal;
+    std::size_t n = static_cast<std::size_t>(last - first);
+    auto &pool = thread_pool::global();
+    std::size_t nchunks = pool.chunk_count(n);
+    // chunks are combined in index order, so non-commutative reductions stay deterministic
+    std::vector<std::optional<Value>> partial(nchunks);
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t c, std::size_t b, std::size_t e) {
+        Value acc = transformFn(first[b]);
+        for (std::size_t i = b + 1; i < e; i++) {
+            acc = reduceFn(std::move(acc), transformFn(first[i]));
+        }
+        partial[c].emplace(std::move(acc));
+    });
+    for (auto &val: partial) {
+        initVal = reduceFn(std::move(initVal), std::move(*val));
+    }
+    return initVal;
+}
+
+#endif
+
 template <class Index, class Value, class Reduce, class Transform>
 Value parallel_reduce(Index first, Index last, Value initVal, Reduce reduceFn, Transform transformFn) {
-    return std::transform_reduce(ZENO_PAR counter_iterator<Index>(first), counter_iterator<Index>(last),
+    return parallel_transform_reduce(counter_iterator<Index>(first), counter_iterator<Index>(last),
             initVal, reduceFn, transformFn);
 }
 
 template <class It, class Transform = identity>
 auto parallel_reduce_min(It first, It last, Transform transformFn = {}) {
     if (first == last) return std::decay_t<decltype(*first)>();
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, *first, [] (auto &&x, auto &&y) {
+    return parallel_transform_reduce(first, last, *first, [] (auto &&x, auto &&y) {
         return zeno::min(x, y);
     }, transformFn);
 }
@@ -27,7 +63,7 @@ auto parallel_reduce_min(It first, It last, Transform transformFn = {}) {
 template <class It, class Transform = identity>
 auto parallel_reduce_max(It first, It last, Transform transformFn = {}) {
     if (first == last) return std::decay_t<decltype(*first)>();
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, *first, [] (auto &&x, auto &&y) {
+    return parallel_transform_reduce(first, last, *first, [] (auto &&x, auto &&y) {
         return zeno::max(x, y);
     }, transformFn);
 }
@@ -35,7 +71,7 @@ auto parallel_reduce_max(It first, It last, Transform transformFn = {}) {
 template <class It, class Transform = identity>
 auto parallel_reduce_minmax(It first, It last, Transform transformFn = {}) {
     if (first == last) return std::make_pair(std::decay_t<decltype(*first)>(), std::decay_t<decltype(*first)>());
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, std::make_pair(*first, *first), [] (auto &&x, auto &&y) {
+    return parallel_transform_reduce(first, last, std::make_pair(*first, *first), [] (auto &&x, auto &&y) {
         return std::make_pair(zeno::min(x.first, y.first), zeno::max(x.second, y.second));
     }, [transformFn] (auto const &val) {
         return std::make_pair(val, val);
@@ -44,7 +80,7 @@ auto parallel_reduce_minmax(It first, It last, Transform transformFn = {}) {
 
 template <class It, class Transform = identity>
 auto parallel_reduce_sum(It first, It last, Transform transformFn = {}) {
-    return std::transform_reduce(ZENO_PAR_UNSEQ first, last, std::decay_t<decltype(transformFn(*first))>(), [] (auto &&x, auto &&y) {
+    return parallel_transform_reduce(first, last, std::decay_t<decltype(transformFn(*first))>(), [] (auto &&x, auto &&y) {
         return x + y;
     }, transformFn);
 }
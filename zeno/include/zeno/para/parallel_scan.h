@@ -2,25 +2,99 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <zeno/utils/type_traits.h>
 #include <zeno/utils/vec.h>
+#include <optional>
 #include <numeric>
 #include <limits>
+#include <vector>
 #include <tuple>
 
 namespace zeno {
 
+#ifdef ZENO_PARALLEL_STL
+
+template <class It, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt parallel_transform_inclusive_scan(It first, It last, OutputIt dest,
+                    Reduce reduceFn, Transform transformFn, Value initVal) {
+    return std::transform_inclusive_scan(ZENO_PAR first, last, dest, reduceFn, transformFn, initVal);
+}
+
+template <class It, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt parallel_transform_exclusive_scan(It first, It last, OutputIt dest,
+                    Value initVal, Reduce reduceFn, Transform transformFn) {
+    return std::transform_exclusive_scan(ZENO_PAR first, last, dest, initVal, reduceFn, transformFn);
+}
+
+#else
+
+namespace _parallel_scan_details {
+
+// two passes over the same static chunks: per-chunk totals, then a scan seeded by their prefix
+template <bool Inclusive, class It, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt chunked_scan(It first, It last, OutputIt dest, Value initVal, Reduce &reduceFn, Transform &transformFn) {
+    if (first == last)
+        return dest;
+    std::size_t n = static_cast<std::size_t>(last - first);
+    auto &pool = thread_pool::global();
+    std::size_t nchunks = pool.chunk_count(n);
+    std::vector<std::optional<Value>> offsets(nchunks);
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t c, std::size_t b, std::size_t e) {
+        if (c + 1 == nchunks)
+            return;
+        Value acc = transformFn(first[b]);
+        for (std::size_t i = b + 1; i < e; i++) {
+            acc = reduceFn(std::move(acc), transformFn(first[i]));
+        }
+        offsets[c + 1].emplace(std::move(acc));
+    });
+    offsets[0].emplace(std::move(initVal));
+    for (std::size_t c = 1; c < nchunks; c++) {
+        offsets[c].emplace(reduceFn(*offsets[c - 1], std::move(*offsets[c])));
+    }
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t c, std::size_t b, std::size_t e) {
+        Value acc = std::move(*offsets[c]);
+        for (std::size_t i = b; i < e; i++) {
+            if constexpr (Inclusive) {
+                acc = reduceFn(std::move(acc), transformFn(first[i]));
+                dest[i] = acc;
+            } else {
+                dest[i] = acc;
+                acc = reduceFn(std::move(acc), transformFn(first[i]));
+            }
+        }
+    });
+    return dest + n;
+}
+
+}
+
+template <class It, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt parallel_transform_inclusive_scan(It first, It last, OutputIt dest,
+                    Reduce reduceFn, Transform transformFn, Value initVal) {
+    return _parallel_scan_details::chunked_scan<true>(first, last, dest, std::move(initVal), reduceFn, transformFn);
+}
+
+template <class It, class OutputIt, class Value, class Reduce, class Transform>
+OutputIt parallel_transform_exclusive_scan(It first, It last, OutputIt dest,
+                    Value initVal, Reduce reduceFn, Transform transformFn) {
+    return _parallel_scan_details::chunked_scan<false>(first, last, dest, std::move(initVal), reduceFn, transformFn);
+}
+
+#endif
+
 template <class Index, class OutputIt, class Value, class Reduce, class Transform>
 OutputIt parallel_inclusive_scan(Index first, Index last, OutputIt dest,
                     Value initVal, Reduce reduceFn, Transform transformFn) {
-    return std::transform_inclusive_scan(ZENO_PAR
+    return parallel_transform_inclusive_scan(
             counter_iterator<Index>(first), counter_iterator<Index>(last),
             dest, reduceFn, transformFn, initVal);
 }
 
 template <class It, class OutputIt, class Transform = identity>
 OutputIt parallel_inclusive_scan_sum(It first, It last, OutputIt dest, Transform transformFn = {}) {
-    return std::transform_inclusive_scan(ZENO_PAR_UNSEQ first, last, dest, [] (auto &&x, auto &&y) {
+    return parallel_transform_inclusive_scan(first, last, dest, [] (auto &&x, auto &&y) {
         return x + y;
     }, transformFn, std::decay_t<decltype(transformFn(*first))>());
 }
@@ -28,18 +102,18 @@ OutputIt parallel_inclusive_scan_sum(It first, It last, OutputIt dest, Transform
 template <class Index, class OutputIt, class Value, class Reduce, class Transform>
 Value parallel_exclusive_scan(Index first, Index last, OutputIt dest,
                     Value initVal, Reduce reduceFn, Transform transformFn) {
-    auto endp = std::transform_exclusive_scan(ZENO_PAR
+    auto endp = parallel_transform_exclusive_scan(
             counter_iterator<Index>(first), counter_iterator<Index>(last),
             dest, initVal, reduceFn, transformFn);
     if (first != last)
-        return reduceFn(*std::prev(endp), transformFn(*std::prev(last)));
+        return reduceFn(*std::prev(endp), transformFn(last - 1));
     else
         return initVal;
 }
 
 template <class It, class OutputIt, class Transform = identity>
 auto parallel_exclusive_scan_sum(It first, It last, OutputIt dest, Transform transformFn = {}) {
-    auto endp = std::transform_exclusive_scan(ZENO_PAR_UNSEQ first, last, dest, std::decay_t<decltype(transformFn(*first))>(), [] (auto &&x, auto &&y) {
+    auto endp = parallel_transform_exclusive_scan(first, last, dest, std::decay_t<decltype(transformFn(*first))>(), [] (auto &&x, auto &&y) {
         return x + y;
     }, transformFn);
     if (first != last)
@@ -2,13 +2,47 @@
 
 #include <zeno/para/execution.h>
 #include <zeno/para/counter_iterator.h>
+#include <zeno/para/thread_pool.h>
 #include <algorithm>
+#include <vector>
 
 namespace zeno {
 
+#ifdef ZENO_PARALLEL_STL
+
 template <class It, class Func>
 void parallel_sort(It first, It last, Func func) {
     std::sort(ZENO_PAR_UNSEQ first, last, func);
 }
 
+#else
+
+template <class It, class Func>
+void parallel_sort(It first, It last, Func func) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    auto &pool = thread_pool::global();
+    std::size_t nchunks = pool.chunk_count(n, 4096);
+    if (nchunks <= 1) {
+        std::sort(first, last, func);
+        return;
+    }
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t, std::size_t b, std::size_t e) {
+        std::sort(first + b, first + e, func);
+    });
+    // merge sorted neighbours pairwise, doubling the run width every round
+    auto bound = [&] (std::size_t c) {
+        return first + n * std::min(c, nchunks) / nchunks;
+    };
+    for (std::size_t width = 1; width < nchunks; width *= 2) {
+        std::size_t npairs = (nchunks + 2 * width - 1) / (2 * width);
+        pool.for_each_chunk(npairs, npairs, [&] (std::size_t p, std::size_t, std::size_t) {
+            std::size_t c = p * 2 * width;
+            if (c + width < nchunks)
+                std::inplace_merge(bound(c), bound(c + width), bound(c + 2 * width), func);
+        });
+    }
+}
+
+#endif
+
 }
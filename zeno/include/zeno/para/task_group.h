@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zeno/para/execution.h>
+#include <zeno/para/thread_pool.h>
 #include <functional>
 #include <algorithm>
 #include <vector>
@@ -19,9 +20,15 @@ struct task_group {
     }
 
     void run() {
+#ifdef ZENO_PARALLEL_STL
         std::for_each(ZENO_PAR m_tasks.begin(), m_tasks.end(), [&] (auto &&f) {
             std::move(f)();
         });
+#else
+        thread_pool::global().for_each_chunk(m_tasks.size(), m_tasks.size(), [&] (std::size_t i, std::size_t, std::size_t) {
+            std::move(m_tasks[i])();
+        });
+#endif
     }
 };
 
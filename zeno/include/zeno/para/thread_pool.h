@@ -0,0 +1,58 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <functional>
+#include <memory>
+#include <cstddef>
+
+namespace zeno {
+
+struct thread_pool {
+    using task_type = std::function<void()>;
+    using chunk_func_type = std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)>;
+
+    struct Impl;
+
+private:
+    std::unique_ptr<Impl> impl;
+
+public:
+    // the calling thread also executes tasks while waiting, so 0 workers is valid
+    ZENO_API explicit thread_pool(std::size_t nworkers);
+    ZENO_API ~thread_pool();
+
+    thread_pool(thread_pool const &) = delete;
+    thread_pool &operator=(thread_pool const &) = delete;
+    thread_pool(thread_pool &&) = delete;
+    thread_pool &operator=(thread_pool &&) = delete;
+
+    // number of threads that may execute tasks, including the waiting caller
+    ZENO_API std::size_t concurrency() const;
+
+    // tasks submitted from a worker go to its own deque (LIFO), others steal FIFO
+    ZENO_API void submit(task_type task);
+
+    // run one pending task on the calling thread, returns false if none found
+    ZENO_API bool try_run_one();
+
+    // keep executing pending tasks until done() holds, never blocks a worker idle
+    ZENO_API void wait_until(std::function<bool()> const &done);
+
+    // wake up threads blocked in wait_until to re-check their condition
+    ZENO_API void notify_waiters();
+
+    ZENO_API bool is_worker_thread() const;
+
+    // how many chunks to split n items into, each holding at least grain items (0 = auto)
+    ZENO_API std::size_t chunk_count(std::size_t n, std::size_t grain = 0) const;
+
+    // call body(c, n * c / nchunks, n * (c + 1) / nchunks) for every chunk c, the caller
+    // takes part so nested calls from inside a task cannot deadlock; the first exception
+    // thrown by body is rethrown here after all chunks are finished
+    ZENO_API void for_each_chunk(std::size_t n, std::size_t nchunks, chunk_func_type const &body);
+
+    // sized by hardware_concurrency(), capped by env ZENO_MAX_THREADS
+    ZENO_API static thread_pool &global();
+};
+
+}
@@ -3,6 +3,7 @@
 #include <zeno/utils/vec.h>
 #include <zeno/utils/Error.h>
 #include <zeno/utils/type_traits.h>
+#include <zeno/utils/cow_vector.h>
 #include <variant>
 #include <vector>
 #include <map>
@@ -26,17 +27,22 @@ struct AttrVectorIndex {
 };
 
 // AttrVector = BaseVector + attrs
+// attrs are copy-on-write: copies of an AttrVector share the attribute
+// buffers until one of them is accessed through a non-const path, such as the
+// non-const attr<T>(), even if it is only read afterwards.
+// values (pos, and the indices of tris, loops, polys...) is a plain vector and
+// is still deep copied with the AttrVector.
 template <class ValT>
 struct AttrVector {
     using AttrVectorVariant = std::variant
-        < std::vector<vec3f>
-        , std::vector<float>
-        , std::vector<vec3i>
-        , std::vector<int>
-        , std::vector<vec2f>
-        , std::vector<vec2i>
-        , std::vector<vec4f>
-        , std::vector<vec4i>
+        < cow_vector<vec3f>
+        , cow_vector<float>
+        , cow_vector<vec3i>
+        , cow_vector<int>
+        , cow_vector<vec2f>
+        , cow_vector<vec2i>
+        , cow_vector<vec4f>
+        , cow_vector<vec4i>
         >;
 
     using value_type = ValT;
@@ -147,7 +153,7 @@ struct AttrVector {
         std::visit([&] (auto &arr) {
             using T = std::decay_t<decltype(arr[0])>;
             if constexpr (variant_contains<T, Accept>::value) {
-                f(arr);
+                f(arr.get());
             }
         }, it->second);
     }
@@ -166,7 +172,7 @@ struct AttrVector {
         std::visit([&] (auto &arr) {
             using T = std::decay_t<decltype(arr[0])>;
             if constexpr (variant_contains<T, Accept>::value) {
-                f(arr);
+                f(arr.mut());
             }
         }, it->second);
     }
@@ -178,7 +184,7 @@ struct AttrVector {
             std::visit([&] (auto &arr) {
                 using T = std::decay_t<decltype(arr[0])>;
                 if constexpr (variant_contains<T, Accept>::value) {
-                    f(k, arr);
+                    f(k, arr.get());
                 }
             }, arr);
         }
@@ -191,7 +197,7 @@ struct AttrVector {
             std::visit([&] (auto &arr) {
                 using T = std::decay_t<decltype(arr[0])>;
                 if constexpr (variant_contains<T, Accept>::value) {
-                    f(k, arr);
+                    f(k, arr.mut());
                 }
             }, arr);
         }
@@ -205,7 +211,7 @@ struct AttrVector {
             std::visit([&] (auto &arr) {
                 using T = std::decay_t<decltype(arr[0])>;
                 if constexpr (variant_contains<T, Accept>::value) {
-                    f(k, arr);
+                    f(k, arr.get());
                 }
             }, arr);
         }
@@ -219,7 +225,7 @@ struct AttrVector {
             std::visit([&] (auto &arr) {
                 using T = std::decay_t<decltype(arr[0])>;
                 if constexpr (variant_contains<T, Accept>::value) {
-                    f(k, arr);
+                    f(k, arr.mut());
                 }
             }, arr);
         }
@@ -378,7 +384,7 @@ struct AttrVector {
     template <class T>
     auto &add_attr(std::string const &name) {
         if (!attr_is<T>(name))
-            attrs[name] = std::vector<T>(size());
+            attrs[name] = cow_vector<T>(size());
         return attr<T>(name);
     }
 
@@ -386,7 +392,7 @@ struct AttrVector {
     template <class T>
     auto &add_attr(std::string const &name, T const &val) {
         if (!attr_is<T>(name))
-            attrs[name] = std::vector<T>(size(), val);
+            attrs[name] = cow_vector<T>(size(), val);
         return attr<T>(name);
     }
 
@@ -407,11 +413,12 @@ struct AttrVector {
             }
         }
         auto const &arr = attr(name);
-        if (!std::holds_alternative<std::vector<T>>(arr))
+        if (!std::holds_alternative<cow_vector<T>>(arr))
             throw makeError<TypeError>(typeid(T), std::visit([&] (auto const &t) -> std::type_info const & { return typeid(std::decay_t<decltype(t[0])>); }, arr), "type of primitive attribute " + name);
-        return std::get<std::vector<T>>(arr);
+        return std::get<cow_vector<T>>(arr).get();
     }
 
+    // detaches a shared attribute, read through a const AttrVector when possible
     template <class T>
     auto &attr(std::string const &name) {
         if (name == "pos") {
@@ -422,9 +429,9 @@ struct AttrVector {
             }
         }
         auto &arr = attr(name);
-        if (!std::holds_alternative<std::vector<T>>(arr))
+        if (!std::holds_alternative<cow_vector<T>>(arr))
             throw makeError<TypeError>(typeid(T), std::visit([&] (auto const &t) -> std::type_info const & { return typeid(std::decay_t<decltype(t[0])>); }, arr), "type of primitive attribute " + name);
-        return std::get<std::vector<T>>(arr);
+        return std::get<cow_vector<T>>(arr).mut();
     }
 
     // deprecated:
@@ -465,7 +472,7 @@ struct AttrVector {
     bool attr_is(std::string const &name) const {
         if (name == "pos") return std::is_same_v<T, ValT>;
         auto it = attrs.find(name);
-        return it != attrs.end() && std::holds_alternative<std::vector<T>>(it->second);
+        return it != attrs.end() && std::holds_alternative<cow_vector<T>>(it->second);
     }
 
     void clear_attrs() {
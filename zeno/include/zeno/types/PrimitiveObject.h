@@ -15,6 +15,7 @@ namespace zeno {
 
 struct MaterialObject;
 struct InstancingObject;
+struct PrimAdjacency;
 /*
     Assuming points {p_i}, 0<=i<n, forms a counterclockwise polygon,
     compute the sum of the cross product of every triangle of a triangle
@@ -143,6 +144,9 @@ struct PrimitiveObject : IObjectClone<PrimitiveObject> {
     std::shared_ptr<MaterialObject> mtl;
     std::shared_ptr<InstancingObject> inst;
 
+    // cache of primAdjacency(), only valid while the topology hash matches
+    mutable std::shared_ptr<PrimAdjacency const> adjacency;
+
     // deprecated:
     template <class Accept = std::variant<vec3f, float>, class F>
     void foreach_attr(F &&f) {
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <zeno/core/IObject.h>
+#include <zeno/utils/api.h>
+#include <zeno/utils/vec.h>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace zeno {
+
+struct PrimitiveObject;
+
+/* Spatial index over the verts, lines or tris of a primitive, either a linear
+ * BVH (Karras 2012, morton-sorted and built in parallel) or a uniform hash grid,
+ * which only holds points. The geometry is copied in, so the index stays valid
+ * while the primitive is modified, and can be refit to moved verts as long as
+ * the topology is unchanged.
+ *
+ * Queries are const and safe to call concurrently, nodes run them in parallel
+ * over their query points. Distances are euclidean, maxDist bounds the search.
+ */
+struct SpatialIndexObject : IObjectClone<SpatialIndexObject> {
+    enum ElementType { Points, Lines, Tris };
+    enum Structure { Bvh, HashGrid };
+
+    struct Hit {
+        int id = -1;         // vert, or index into prim->lines/tris, -1 if none
+        float dist = 0;      // distance to the element, or along the ray
+        vec3f pos{};         // closest point on the element, or where the ray hits
+        vec3f bary{1, 0, 0}; // weights of the element verts at pos
+    };
+
+    ElementType elementType = Tris;
+    Structure structure = Bvh;
+    std::uint64_t topologyHash = 0;
+
+    std::vector<vec3f> verts;
+    std::vector<vec3i> elems;  // vert indices of each element, unused ones repeat the first
+
+    // bvh: internal nodes, root at 0 when there are at least two elements, holding the boxes
+    // of both children so that a visit reads a single node; a child c < 0 is the element ~c
+    struct Node {
+        vec3f bmin[2], bmax[2];
+        int child[2];
+    };
+    std::vector<Node> nodes;
+    std::vector<int> parents;  // parent of internal node i, then of element i
+
+    // hash grid: point ids sorted by cell, with the occupied cells and where they start
+    float cellSize = 0;
+    vec3f gridOrigin{};
+    vec3i gridMax{};  // highest cell coordinate along each axis
+    std::vector<int> cellPoints;
+    std::vector<std::uint64_t> cellCodes;
+    std::vector<int> cellBegin;
+
+    ZENO_API static std::shared_ptr<SpatialIndexObject> build(PrimitiveObject const *prim, ElementType type,
+                                                              Structure structure = Bvh, float cellSize = 0);
+    // takes the new vert positions of prim and updates the bounds, false if its topology
+    // changed since the build, in which case the index must be rebuilt
+    ZENO_API bool refit(PrimitiveObject const *prim);
+
+    ZENO_API Hit closest(vec3f const &pos, float maxDist = std::numeric_limits<float>::infinity()) const;
+    // up to k elements, nearest first
+    ZENO_API void knn(vec3f const &pos, int k, float maxDist, std::vector<Hit> &out) const;
+    // all elements within radius, in no particular order
+    ZENO_API void radius(vec3f const &pos, float radius, std::vector<Hit> &out) const;
+    // first triangle hit by the ray at a distance in [0, maxDist], rd need not be normalized
+    ZENO_API Hit raycast(vec3f const &ro, vec3f const &rd, float maxDist = std::numeric_limits<float>::infinity()) const;
+
+    // order in which to run a batch of queries at pos, along a morton curve so that
+    // consecutive ones go through the same nodes while they are still cached
+    ZENO_API std::vector<int> batchOrder(std::vector<vec3f> const &pos) const;
+
+    std::size_t size() const {
+        return elems.size();
+    }
+
+    // closest point on element e, filling its bary weights
+    ZENO_API vec3f closestOnElement(int e, vec3f const &pos, vec3f &bary) const;
+};
+
+}
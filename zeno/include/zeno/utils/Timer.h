@@ -20,7 +20,7 @@ public:
     };
 
 private:
-    static Timer *current;
+    static thread_local Timer *current;
     static std::vector<Record> records;
 
     Timer *parent = nullptr;
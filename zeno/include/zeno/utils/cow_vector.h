@@ -0,0 +1,203 @@
+#pragma once
+
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <atomic>
+#include <vector>
+
+namespace zeno {
+
+// std::vector sharing its buffer between copies, the buffer is duplicated on
+// the first mutable access of a copy, as with Qt implicit sharing.
+//
+// Any non-const member (non-const operator[] included) may detach, so read
+// through a const reference, or take the std::vector once with mut() before
+// a hot loop. Concurrent first accesses from several threads are fine: they
+// race on a compare-exchange and all end up on the same private buffer.
+// A reference returned by mut() must not be written after the cow_vector is
+// copied, the write would show through the copy.
+template <class T>
+struct cow_vector {
+    using vector_type = std::vector<T>;
+    using value_type = typename vector_type::value_type;
+    using size_type = typename vector_type::size_type;
+    using difference_type = typename vector_type::difference_type;
+    using reference = typename vector_type::reference;
+    using const_reference = typename vector_type::const_reference;
+    using pointer = typename vector_type::pointer;
+    using const_pointer = typename vector_type::const_pointer;
+    using iterator = typename vector_type::iterator;
+    using const_iterator = typename vector_type::const_iterator;
+
+private:
+    struct block {
+        std::atomic<long> refs{1};
+        vector_type vec;
+
+        explicit block(vector_type vec_) : vec(std::move(vec_)) {}
+    };
+
+    std::atomic<block *> m_blk{nullptr};  // null for an empty vector with no buffer yet
+
+    static void release(block *blk) noexcept {
+        if (blk && blk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete blk;
+    }
+
+    static vector_type const &empty_vector() noexcept {
+        static const vector_type empty;
+        return empty;
+    }
+
+    vector_type &detach(block *blk) {
+        auto nblk = new block(blk ? blk->vec : vector_type());
+        if (m_blk.compare_exchange_strong(blk, nblk, std::memory_order_acq_rel)) {
+            release(blk);
+            return nblk->vec;
+        }
+        delete nblk;  // another thread detached first, blk is now its buffer
+        return blk->vec;
+    }
+
+public:
+    cow_vector() noexcept = default;
+
+    cow_vector(vector_type const &vec) : m_blk(new block(vec)) {}
+    cow_vector(vector_type &&vec) : m_blk(new block(std::move(vec))) {}
+    explicit cow_vector(size_type n) : m_blk(new block(vector_type(n))) {}
+    cow_vector(size_type n, T const &val) : m_blk(new block(vector_type(n, val))) {}
+    cow_vector(std::initializer_list<T> init) : m_blk(new block(vector_type(init))) {}
+
+    template <class It, class = std::enable_if_t<!std::is_integral_v<It>>>
+    cow_vector(It first, It last) : m_blk(new block(vector_type(first, last))) {}
+
+    cow_vector(cow_vector const &that) noexcept {
+        auto blk = that.m_blk.load(std::memory_order_acquire);
+        if (blk)
+            blk->refs.fetch_add(1, std::memory_order_relaxed);
+        m_blk.store(blk, std::memory_order_relaxed);
+    }
+
+    cow_vector(cow_vector &&that) noexcept
+        : m_blk(that.m_blk.exchange(nullptr, std::memory_order_acq_rel)) {}
+
+    cow_vector &operator=(cow_vector const &that) noexcept {
+        if (this != &that) {
+            cow_vector tmp(that);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    cow_vector &operator=(cow_vector &&that) noexcept {
+        if (this != &that) {
+            cow_vector tmp(std::move(that));
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    cow_vector &operator=(vector_type const &vec) {
+        return *this = cow_vector(vec);
+    }
+
+    cow_vector &operator=(vector_type &&vec) {
+        return *this = cow_vector(std::move(vec));
+    }
+
+    ~cow_vector() {
+        release(m_blk.load(std::memory_order_relaxed));
+    }
+
+    void swap(cow_vector &that) noexcept {
+        auto blk = m_blk.load(std::memory_order_relaxed);
+        m_blk.store(that.m_blk.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        that.m_blk.store(blk, std::memory_order_relaxed);
+    }
+
+    // whether the buffer is shared with another copy
+    bool shared() const noexcept {
+        auto blk = m_blk.load(std::memory_order_acquire);
+        return blk && blk->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    vector_type const &get() const noexcept {
+        auto blk = m_blk.load(std::memory_order_acquire);
+        return blk ? blk->vec : empty_vector();
+    }
+
+    // the private buffer, duplicated from the shared one when needed
+    vector_type &mut() {
+        auto blk = m_blk.load(std::memory_order_acquire);
+        if (blk && blk->refs.load(std::memory_order_acquire) == 1)
+            return blk->vec;
+        return detach(blk);
+    }
+
+    // read-only on purpose: a visitor taking std::vector<T> const & must not detach,
+    // writers call mut() explicitly
+    operator vector_type const &() const noexcept {
+        return get();
+    }
+
+    size_type size() const noexcept { return get().size(); }
+    size_type capacity() const noexcept { return get().capacity(); }
+    bool empty() const noexcept { return get().empty(); }
+
+    const_pointer data() const noexcept { return get().data(); }
+    const_iterator begin() const noexcept { return get().begin(); }
+    const_iterator end() const noexcept { return get().end(); }
+    const_iterator cbegin() const noexcept { return get().cbegin(); }
+    const_iterator cend() const noexcept { return get().cend(); }
+    const_reference operator[](size_type i) const noexcept { return get()[i]; }
+    const_reference at(size_type i) const { return get().at(i); }
+    const_reference front() const { return get().front(); }
+    const_reference back() const { return get().back(); }
+
+    pointer data() { return mut().data(); }
+    iterator begin() { return mut().begin(); }
+    iterator end() { return mut().end(); }
+    reference operator[](size_type i) { return mut()[i]; }
+    reference at(size_type i) { return mut().at(i); }
+    reference front() { return mut().front(); }
+    reference back() { return mut().back(); }
+
+    void resize(size_type n) { mut().resize(n); }
+    void resize(size_type n, T const &val) { mut().resize(n, val); }
+    void reserve(size_type n) { mut().reserve(n); }
+    void shrink_to_fit() { mut().shrink_to_fit(); }
+    void push_back(T const &val) { mut().push_back(val); }
+    void push_back(T &&val) { mut().push_back(std::move(val)); }
+    void pop_back() { mut().pop_back(); }
+
+    void clear() {
+        if (shared())
+            cow_vector().swap(*this);  // no need to copy what is about to be dropped
+        else if (auto blk = m_blk.load(std::memory_order_acquire))
+            blk->vec.clear();
+    }
+
+    template <class ...Ts>
+    reference emplace_back(Ts &&...ts) {
+        return mut().emplace_back(std::forward<Ts>(ts)...);
+    }
+
+    // iterators must come from the non-const begin() or end(), which already detached
+    template <class ...Ts>
+    iterator insert(const_iterator pos, Ts &&...ts) {
+        return mut().insert(pos, std::forward<Ts>(ts)...);
+    }
+
+    template <class ...Ts>
+    iterator erase(Ts &&...ts) {
+        return mut().erase(std::forward<Ts>(ts)...);
+    }
+
+    template <class ...Ts>
+    void assign(Ts &&...ts) {
+        mut().assign(std::forward<Ts>(ts)...);
+    }
+};
+
+}
@@ -5,6 +5,7 @@
 //#include <zeno/utils/cformat.h>
 #include <zeno/utils/format.h>
 #include <string_view>
+#include <mutex>
 
 namespace zeno {
 
@@ -31,8 +32,24 @@ enum class log_level_t {
 ZENO_API void set_log_level(log_level_t level);
 ZENO_API void set_log_stream(std::ostream &osin);
 ZENO_API bool __check_log_level(log_level_t level);
+// waits until what was logged so far is written out
+ZENO_API void log_flush();
+// hold it while writing anything else to the log stream, so it doesn't land in the middle of a line
+ZENO_API std::unique_lock<std::mutex> lock_log_stream();
 ZENO_API void __impl_log_print(log_level_t level, source_location const &loc, std::string_view msg);
 
+// lines logged by this thread while it lives are tagged with {node=... frame=...}
+struct log_fields_scope {
+    ZENO_API log_fields_scope(std::string_view node, int frame = -1);
+    ZENO_API ~log_fields_scope();
+    log_fields_scope(log_fields_scope const &) = delete;
+    log_fields_scope &operator=(log_fields_scope const &) = delete;
+
+private:
+    std::string_view m_node;
+    int m_frame;
+};
+
 template <class ...Args>
 void log_print(log_level_t level, __with_source_location<std::string_view> const &msg, Args &&...args) {
     if (__check_log_level(level))
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/utils/disable_copy.h>
+#include <filesystem>
+#include <cstddef>
+
+namespace zeno {
+
+// read-only view of a whole file through mmap (MapViewOfFile on Windows)
+struct mapped_file : disable_copy {
+    ZENO_API explicit mapped_file(std::filesystem::path const &path);
+    ZENO_API ~mapped_file();
+
+    // false when the file can't be opened or mapped, empty files included
+    explicit operator bool() const {
+        return m_data != nullptr;
+    }
+
+    const char *data() const {
+        return m_data;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+private:
+    const char *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void *m_hFile = nullptr;
+    void *m_hMapping = nullptr;
+#endif
+};
+
+}
@@ -19,7 +19,7 @@ constexpr static uint64_t encode1(uint64_t x)
 
 constexpr static uint64_t encode(uint64_t x, uint64_t y)
 {
-    return encode1(x) | encode1(y << 1);
+    return encode1(x) | (encode1(y) << 1);
 }
 
 constexpr static uint64_t decode1(uint64_t x)
@@ -54,7 +54,7 @@ constexpr static uint64_t encode1(uint64_t x)
 
 constexpr static uint64_t encode(uint64_t x, uint64_t y, uint64_t z)
 {
-    return encode1(x) | encode1(y << 1) | encode1(z << 2);
+    return encode1(x) | (encode1(y) << 1) | (encode1(z) << 2);
 }
 
 constexpr static uint64_t decode1(uint64_t x)
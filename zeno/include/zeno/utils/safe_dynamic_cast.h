@@ -2,13 +2,14 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <typeinfo>
 #include <zeno/utils/Error.h>
 
 namespace zeno {
 
 template <class T, class S>
-T *safe_dynamic_cast(S *s, std::string const &msg = "safe_dynamic_cast") {
+T *safe_dynamic_cast(S *s, std::string_view msg = "safe_dynamic_cast") {
     auto t = dynamic_cast<T *>(s);
     if (!t) {
         throw makeError<TypeError>(typeid(T), typeid(*s), msg);
@@ -18,7 +19,7 @@ T *safe_dynamic_cast(S *s, std::string const &msg = "safe_dynamic_cast") {
 
 template <class T, class S>
 std::shared_ptr<T> safe_dynamic_cast(
-        std::shared_ptr<S> s, std::string const &msg = "safe_dynamic_cast") {
+        std::shared_ptr<S> s, std::string_view msg = "safe_dynamic_cast") {
     auto t = std::dynamic_pointer_cast<T>(s);
     if (!t) {
         throw makeError<TypeError>(typeid(T), typeid(*s), msg);
@@ -11,7 +11,14 @@
 #include <zeno/funcs/LiterialConverter.h>
 #include <zeno/extra/GlobalStatus.h>
 #include <zeno/extra/SubnetNode.h>
+#include <zeno/extra/SubgraphDefinition.h>
 #include <zeno/extra/DirtyChecker.h>
+#include <zeno/extra/ParallelExecutor.h>
+#include <zeno/extra/IncrementalCache.h>
+#include <zeno/extra/LivenessTracker.h>
+#include <zeno/extra/ExecPlan.h>
+#include <zeno/extra/Profiler.h>
+#include <zeno/utils/envconfig.h>
 #include <zeno/utils/Error.h>
 #include <zeno/utils/log.h>
 #include <iostream>
@@ -25,30 +32,60 @@ ZENO_API Context::Context(Context const &other)
     : visited(other.visited)
 {}
 
-ZENO_API Graph::Graph() = default;
+ZENO_API Graph::Graph()
+    : parallelExec(envconfig::getBool("PARALLEL_GRAPH"))
+    , releaseOutputs(envconfig::getBool("RELEASE_OUTPUTS", true))
+{}
 ZENO_API Graph::~Graph() = default;
 
 ZENO_API zany const &Graph::getNodeOutput(
     std::string const &sn, std::string const &ss) const {
-    auto node = safe_at(nodes, sn, "node name").get();
+    return getNodeOutput(safe_at(nodes, sn, "node name").get(), ss);
+}
+
+ZENO_API zany const &Graph::getNodeOutput(INode *node, std::string const &ss) const {
     if (node->muted_output)
         return node->muted_output;
-    return safe_at(node->outputs, ss, "output socket name of node " + node->myname);
+    auto it = node->outputs.find(ss);
+    if (it == node->outputs.end())
+        throw makeError<KeyError>(ss, "output socket name of node " + node->myname);
+    return it->second;
 }
 
 ZENO_API void Graph::clearNodes() {
     nodes.clear();
+    execPlan = nullptr;
 }
 
 ZENO_API void Graph::addNode(std::string const &cls, std::string const &id) {
     if (nodes.find(id) != nodes.end())
         return;  // no add twice, to prevent output object invalid
-    auto cl = safe_at(session->nodeClasses, cls, "node class name").get();
+    addNode(safe_at(session->nodeClasses, cls, "node class name").get(), id);
+}
+
+ZENO_API void Graph::addNode(INodeClass *cl, std::string const &id) {
+    if (nodes.find(id) != nodes.end())
+        return;
     auto node = cl->new_instance();
     node->graph = this;
     node->myname = id;
     node->nodeClass = cl;
     nodes[id] = std::move(node);
+    execPlanStale = true;
+}
+
+ZENO_API void Graph::removeNode(std::string const &id) {
+    nodes.erase(id);
+    execPlanStale = true;
+    nodesToExec.erase(id);
+    for (auto *lut: {&portalIns, &subInputNodes, &subOutputNodes}) {
+        for (auto it = lut->begin(); it != lut->end();) {
+            if (it->second == id)
+                it = lut->erase(it);
+            else
+                ++it;
+        }
+    }
 }
 
 ZENO_API Graph *Graph::addSubnetNode(std::string const &id) {
@@ -62,6 +99,7 @@ ZENO_API Graph *Graph::addSubnetNode(std::string const &id) {
     subnode->subnetClass = std::move(subcl);
     auto subg = subnode->subgraph.get();
     nodes[id] = std::move(node);
+    execPlanStale = true;
     return subg;
 }
 
@@ -70,19 +108,53 @@ ZENO_API Graph *Graph::getSubnetGraph(std::string const &id) const {
     return node->subgraph.get();
 }
 
+ZENO_API Graph *Graph::addSubgraphInstance(SubgraphDefinition const &def, std::string const &id, std::string const &prefix) {
+    auto subg = addSubnetNode(id);
+    def.instantiate(subg, prefix);
+    return subg;
+}
+
 ZENO_API void Graph::completeNode(std::string const &id) {
     safe_at(nodes, id, "node name")->doComplete();
 }
 
+ZENO_API std::shared_ptr<ExecPlan const> const &Graph::getExecPlan() {
+    // nodes put into the map directly, like loop bodies, are caught by the count
+    if (!execPlan || execPlanStale || execPlan->nodeCount != nodes.size()) {
+        execPlan = std::make_shared<ExecPlan>(this, execPlan.get());
+        execPlanStale = false;
+    }
+    return execPlan;
+}
+
 ZENO_API bool Graph::applyNode(std::string const &id) {
-    if (ctx->visited.find(id) != ctx->visited.end()) {
+    if (executor) {
+        return executor->applyNode(id);
+    }
+    return applyNode(safe_at(nodes, id, "node name").get());
+}
+
+ZENO_API bool Graph::applyNode(INode *node) {
+    if (executor) {
+        return executor->applyNode(node->myname);
+    }
+    if (node->execIndex < 0)  // added to the map after the plan was built, without changing the count
+        execPlan = std::make_shared<ExecPlan>(this, execPlan.get());
+    if (!ctx->markVisited(node->execIndex)) {
         return false;
     }
-    ctx->visited.insert(id);
-    auto node = safe_at(nodes, id, "node name").get();
-    GraphException::translated([&] {
-        node->doApply();
-    }, node->myname);
+    auto const &id = node->myname;
+    auto apply = [&] {
+        GraphException::translated([&] {
+            node->doApply();
+        }, node->myname);
+    };
+    if (incrementalCache) {
+        if (!incrementalCache->applyNode(node, apply))
+            return false;
+    } else {
+        apply();
+    }
     if (dirtyChecker && dirtyChecker->amIDirty(id)) {
         return true;
     }
@@ -91,11 +163,22 @@ ZENO_API bool Graph::applyNode(std::string const &id) {
 
 ZENO_API void Graph::applyNodes(std::set<std::string> const &ids) {
     ctx = std::make_unique<Context>();
+    getExecPlan();
 
-    scope_exit _{[&] {
+    // kept outputs are what the incremental cache restores from
+    std::unique_ptr<LivenessTracker> tracker;
+    if (releaseOutputs && !incrementalCache)
+        tracker = std::make_unique<LivenessTracker>(this, ids);
+    scope_exit _{[&, oldLiveness = std::exchange(liveness, tracker.get())] {
         ctx = nullptr;
+        liveness = oldLiveness;
     }};
 
+    if (parallelExec) {
+        ParallelExecutor(this).execute(ids);
+        return;
+    }
+
     for (auto const &id: ids) {
         applyNode(id);
     }
@@ -109,6 +192,7 @@ ZENO_API void Graph::applyNodesToExec() {
 ZENO_API void Graph::bindNodeInput(std::string const &dn, std::string const &ds,
         std::string const &sn, std::string const &ss) {
     safe_at(nodes, dn, "node name")->inputBounds[ds] = std::pair(sn, ss);
+    execPlanStale = true;
 }
 
 ZENO_API void Graph::setNodeInput(std::string const &id, std::string const &par,
@@ -141,7 +225,10 @@ ZENO_API std::map<std::string, zany> Graph::callTempNode(std::string const &id,
     auto se = cl->new_instance();
     se->graph = const_cast<Graph *>(this);
     se->inputs = std::move(inputs);
-    se->doOnlyApply();
+    {
+        Profiler::Span _prof("temp", id);  // included in the time of the calling node
+        se->doOnlyApply();
+    }
     return std::move(se->outputs);
 }
 
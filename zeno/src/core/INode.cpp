@@ -7,7 +7,12 @@
 #include <zeno/types/StringObject.h>
 #include <zeno/extra/GlobalState.h>
 #include <zeno/extra/DirtyChecker.h>
+#include <zeno/extra/MemoCache.h>
 #include <zeno/extra/TempNode.h>
+#include <zeno/extra/Profiler.h>
+#include <zeno/extra/LivenessTracker.h>
+#include <zeno/extra/ExecPlan.h>
+#include <zeno/extra/assetDir.h>
 #include <zeno/utils/Error.h>
 #ifdef ZENO_BENCHMARKING
 #include <zeno/utils/Timer.h>
@@ -15,10 +20,42 @@
 #include <zeno/utils/safe_at.h>
 #include <zeno/utils/logger.h>
 #include <zeno/extra/GlobalState.h>
+#include <algorithm>
+#include <mutex>
+#include <tuple>
 
 namespace zeno {
 
-ZENO_API INode::INode() = default;
+// A formula only depends on its code, on the frame when it mentions a $ symbol,
+// on the config variables a string formula expands and on what its ref(...)
+// resolve to. While none of these change, get_formula returns the last value
+// instead of running NumericEval / StringEval again, which matters for nodes
+// inside loop bodies. Keyframes are cached per curve object and frame.
+struct INode::FormulaCache {
+    struct Formula {
+        std::string code;
+        std::tuple<int, float, float> frame{};  // frameid, frame_time, frame_time_elapsed
+        std::vector<std::string> config;
+        std::vector<zany> refs;  // compared by identity, holding them keeps the addresses unique
+        zany value;
+
+        bool sameKey(Formula const &that) const {
+            return code == that.code && frame == that.frame && config == that.config && refs == that.refs;
+        }
+    };
+
+    struct Keyframe {
+        zany curves;
+        int frame = 0;
+        zany value;
+    };
+
+    std::mutex mtx;  // the parallel executor may resolve a ref() into a node that is being applied
+    std::map<std::string, Formula> formulas;
+    std::map<std::string, Keyframe> keyframes;
+};
+
+ZENO_API INode::INode() : formulaCache(std::make_shared<FormulaCache>()) {}
 ZENO_API INode::~INode() = default;
 
 ZENO_API Graph *INode::getThisGraph() const {
@@ -26,10 +63,12 @@ ZENO_API Graph *INode::getThisGraph() const {
 }
 
 ZENO_API Session *INode::getThisSession() const {
+    MemoCache::noteSessionAccess();
     return graph->session;
 }
 
 ZENO_API GlobalState *INode::getGlobalState() const {
+    MemoCache::noteSessionAccess();
     return graph->session->globalState.get();
 }
 
@@ -68,35 +107,102 @@ ZENO_API void INode::complete() {}
     return true;
 }*/
 
-ZENO_API void INode::preApply() {
-    for (auto const &[ds, bound]: inputBounds) {
-        requireInput(ds);
+// pulls an input resolved by the graph's ExecPlan, that is requireInput without the name lookups
+static void pullInput(INode *node, ExecPlan::Input const &in) {
+    auto graph = node->graph;
+    if (!in.src)
+        throw makeError<KeyError>(*in.sn, "node name");
+    if (graph->applyNode(in.src)) {
+        auto &dc = graph->getDirtyChecker();
+        dc.taintThisNode(node->myname);
     }
+    node->inputs[*in.ds] = graph->getNodeOutput(in.src, *in.ss);
+    if (graph->liveness)
+        graph->liveness->notePulled(in.src);
+}
 
-    log_debug("==> enter {}", myname);
-    {
+// calls f with the resolved inputs of node, planned ones unless it isn't part of the graph
+template <class F>
+static void withInputs(INode *node, F const &f) {
+    // held, in case a node rebuilds the plan while its inputs are pulled
+    auto plan = node->graph->getExecPlan();
+    if (auto inputs = plan->inputsOf(node)) {
+        f(*inputs);
+    } else {
+        std::vector<ExecPlan::Input> resolved;
+        ExecPlan::resolveInputs(node->graph, node, resolved);
+        f(resolved);
+    }
+}
+
+ZENO_API void INode::preApply() {
+    withInputs(this, [&] (auto const &inputs) {
+        for (auto const &in: inputs) {
+            pullInput(this, in);
+        }
+    });
+
+    auto run = [&] {
+        auto const &gs = graph->session->globalState;
+        log_fields_scope _log(myname, gs ? gs->frameid : -1);
+        log_debug("==> enter {}", myname);
+        {
 #ifdef ZENO_BENCHMARKING
-        Timer _(myname);
+            Timer _(myname);
 #endif
-        apply();
-    }
-    log_debug("==> leave {}", myname);
+            Profiler::Span _prof("node", myname);
+            apply();
+        }
+        log_debug("==> leave {}", myname);
+    };
+    if (auto memo = graph->session->memoCache.get(); memo->enabled())
+        memo->applyNode(this, run);
+    else
+        run();
+    if (graph->liveness)
+        graph->liveness->noteApplied(this);
 }
 
-ZENO_API bool INode::requireInput(std::string const &ds) {
-    auto it = inputBounds.find(ds);
-    if (it == inputBounds.end())
+ZENO_API bool INode::hasLazyInputs() const {
+    return false;
+}
+
+ZENO_API bool INode::isPure() const {
+    if (!nodeClass || !nodeClass->desc)
+        return true;
+    auto const &desc = *nodeClass->desc;
+    // nodes with no outputs to restore only run for their side effects (printing, writing files...)
+    if (std::all_of(desc.outputs.begin(), desc.outputs.end(), [] (auto const &sock) {
+        return sock.name == "DST";
+    }))
         return false;
-    auto [sn, ss] = it->second;
-    if (graph->applyNode(sn)) {
-        auto &dc = graph->getDirtyChecker();
-        dc.taintThisNode(myname);
-    }
-    auto ref = graph->getNodeOutput(sn, ss);
-    inputs[ds] = ref;
+    for (auto const &sock: desc.inputs)
+        if (sock.type == "writepath")
+            return false;
+    for (auto const &par: desc.params)
+        if (par.type == "writepath")
+            return false;
     return true;
 }
 
+ZENO_API bool INode::isMemoizable() const {
+    return false;
+}
+
+ZENO_API bool INode::requireInput(std::string const &ds) {
+    bool found = false;
+    withInputs(this, [&] (auto const &inputs) {
+        for (auto const &in: inputs) {
+            if (*in.ds == ds) {
+                pullInput(this, in);
+                found = true;
+                break;
+            }
+        }
+    });
+    return found;
+}
+
 ZENO_API void INode::doOnlyApply() {
     apply();
 }
@@ -137,7 +243,10 @@ ZENO_API zany INode::get_input(std::string const &id) const {
     } else if (has_formula(id)) {
         return get_formula(id);
     }
-    return safe_at(inputs, id, "input socket of node `" + myname + "`");
+    auto it = inputs.find(id);
+    if (it == inputs.end())
+        throw makeError<KeyError>(id, "input socket of node `" + myname + "`");
+    return it->second;
 }
 
 ZENO_API zany INode::resolveInput(std::string const& id) {
@@ -162,14 +271,8 @@ ZENO_API bool INode::has_keyframe(std::string const &id) const {
     return kframes.find(id) != kframes.end();
 }
 
-ZENO_API zany INode::get_keyframe(std::string const &id) const 
-{
-    auto value = safe_at(inputs, id, "input socket of node `" + myname + "`");
-    auto curves = dynamic_cast<zeno::CurveObject *>(value.get());
-    if (!curves) {
-        return value;
-    }
-    int frame = getGlobalState()->frameid;
+static zany evalKeyframe(CurveObject *curves, int frame) {
+    zany value;
     if (curves->keys.size() == 1) {
         auto val = curves->keys.begin()->second.eval(frame);
         value = objectFromLiterial(val);
@@ -204,10 +307,73 @@ ZENO_API zany INode::get_keyframe(std::string const &id) const
     return value;
 }
 
+ZENO_API zany INode::get_keyframe(std::string const &id) const 
+{
+    auto value = safe_at(inputs, id, "input socket of node `" + myname + "`");
+    auto curves = dynamic_cast<zeno::CurveObject *>(value.get());
+    if (!curves) {
+        return value;
+    }
+    int frame = getGlobalState()->frameid;
+    {
+        std::lock_guard lck(formulaCache->mtx);
+        if (auto it = formulaCache->keyframes.find(id); it != formulaCache->keyframes.end()
+            && it->second.curves == value && it->second.frame == frame && it->second.value)
+            return it->second.value;
+    }
+    auto result = evalKeyframe(curves, frame);
+    if (!result)  // curves of unsupported dimension are passed through as is
+        return value;
+    std::lock_guard lck(formulaCache->mtx);
+    formulaCache->keyframes[id] = {std::move(value), frame, result};
+    return result;
+}
+
 ZENO_API bool INode::has_formula(std::string const &id) const {
     return formulas.find(id) != formulas.end();
 }
 
+// fills the cache key of a formula, false when it reads something that can't be compared (portals)
+static bool formulaKey(Graph *graph, GlobalState const &gs, bool isStrFmla, INode::FormulaCache::Formula &key) {
+    auto const &code = key.code;
+    if (code.find('$') != std::string::npos) {
+        key.frame = {gs.frameid, gs.frame_time, gs.frame_time_elapsed};
+        if (isStrFmla) {
+            for (auto const *var: {"FPS", "NASLOC", "ZSG"}) {
+                if (code.find(std::string("$") + var) != std::string::npos)
+                    key.config.push_back(getConfigVariable(var));
+            }
+        }
+        // string formulas evaluate their {...} parts as numeric formulas, which may read portals
+        for (auto const &[name, _]: graph->portalIns) {
+            if (code.find('$' + name) != std::string::npos)
+                return false;
+        }
+    }
+    // same lookup as preApplyRefs in ZenoFX, resolving the referenced inputs also keeps them up to date
+    for (auto i = code.find("ref("); i != std::string::npos; i = code.find("ref(", i + 4)) {
+        auto iend = code.find(')', i);
+        if (iend == std::string::npos)
+            break;
+        auto ref = code.substr(i + 4, iend - i - 4);
+        auto itParam = ref.find('/');
+        if (itParam == std::string::npos)
+            continue;
+        auto ident = ref.substr(0, itParam);
+        auto param = ref.substr(itParam + 1, ref.find('/', itParam + 1) - itParam - 1);
+        zany input;
+        for (auto const &[ident_, node]: graph->nodes) {
+            if (ident_.length() >= ident.length() &&
+                ident_.compare(ident_.length() - ident.length(), ident.length(), ident) == 0) {
+                input = node->resolveInput(param);
+                break;
+            }
+        }
+        key.refs.push_back(std::move(input));
+    }
+    return true;
+}
+
 ZENO_API zany INode::get_formula(std::string const &id) const 
 {
     auto value = safe_at(inputs, id, "input socket of node `" + myname + "`");
@@ -240,6 +406,16 @@ ZENO_API zany INode::get_formula(std::string const &id) const
         //remove '='
         code.replace(0, 1, "");
 
+        FormulaCache::Formula key;
+        key.code = code;
+        bool cacheable = formulaKey(getThisGraph(), *getGlobalState(), isStrFmla, key);
+        if (cacheable) {
+            std::lock_guard lck(formulaCache->mtx);
+            if (auto it = formulaCache->formulas.find(id); it != formulaCache->formulas.end()
+                && it->second.sameKey(key))
+                return it->second.value;
+        }
+
         if (isStrFmla) {
             auto res = getThisGraph()->callTempNode("StringEval", { {"zfxCode", objectFromLiterial(code)} }).at("result");
             value = objectFromLiterial(std::move(res));
@@ -257,6 +433,12 @@ ZENO_API zany INode::get_formula(std::string const &id) const
             auto res = getThisGraph()->callTempNode("NumericEval", { {"zfxCode", objectFromLiterial(code)}, {"resType", objectFromLiterial(resType)} }).at("result");
             value = objectFromLiterial(std::move(res));
         }
+
+        if (cacheable) {
+            key.value = value;
+            std::lock_guard lck(formulaCache->mtx);
+            formulaCache->formulas[id] = std::move(key);
+        }
     }     
     return value;
 }
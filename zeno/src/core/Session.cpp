@@ -4,6 +4,7 @@
 #include <zeno/extra/GlobalComm.h>
 #include <zeno/extra/GlobalStatus.h>
 #include <zeno/extra/EventCallbacks.h>
+#include <zeno/extra/MemoCache.h>
 #include <zeno/types/UserData.h>
 #include <zeno/core/Graph.h>
 #include <zeno/core/INode.h>
@@ -37,6 +38,7 @@ ZENO_API Session::Session()
     , globalStatus(std::make_unique<GlobalStatus>())
     , eventCallbacks(std::make_unique<EventCallbacks>())
     , m_userData(std::make_unique<UserData>())
+    , memoCache(std::make_unique<MemoCache>())
     {
 }
 
@@ -47,6 +49,7 @@ ZENO_API void Session::defNodeClass(std::unique_ptr<INode>(*ctor)(), std::string
         log_error("node class redefined: `{}`\n", id);
     }
     auto cls = std::make_unique<ImplNodeClass>(ctor, desc);
+    cls->classname = id;
     nodeClasses.emplace(id, std::move(cls));
 }
 
@@ -4,8 +4,10 @@
 #include <zeno/funcs/LiterialConverter.h>
 #include <zeno/funcs/ParseObjectFromUi.h>
 #include <zeno/extra/GraphException.h>
+#include <zeno/extra/SubgraphDefinition.h>
 #include <zeno/extra/DirtyChecker.h>
 #include <zeno/utils/logger.h>
+#include <zeno/utils/safe_at.h>
 #include <zeno/utils/vec.h>
 #include <zeno/utils/zeno_p.h>
 #include <zeno/zeno.h>
@@ -67,66 +69,141 @@ static T generic_get(Value const &x) {
     }
 }
 
-ZENO_API void Graph::loadGraph(const char *json) {
-    Document d;
-    d.Parse(json);
+static std::string nameMangling(std::string const &prefix, std::string const &ident) {
+    return prefix.empty() ? ident : prefix + "/" + ident;
+}
+
+// literal inputs are copied into every instance, nodes may hold on to them
+static zany cloneLiterial(zany const &val) {
+    if (!val)
+        return val;
+    auto copy = val->clone();
+    return copy ? copy : val;
+}
 
+struct SubgraphDefinition::State {
+    Graph *root;
+    Graph *g;
+    std::stack<Graph *> gStack;
+    std::string const &prefix;
+
+    std::string name(const char *ident) const {
+        return nameMangling(prefix, ident);
+    }
+};
+
+static std::shared_ptr<SubgraphDefinition> compileCommands(Graph *root, Value const &d) {
     if (!d.IsArray()) {
         throw GraphException { "None", nullptr };
     }
 
-    Graph *g = this;
-    std::stack<Graph *> gStack;
-
-    for (int i = 0; i < d.Size(); i++) {
+    using State = SubgraphDefinition::State;
+    auto def = std::make_shared<SubgraphDefinition>();
+    for (SizeType i = 0; i < d.Size(); i++) {
         Value const &di = d[i];
         std::string cmd = di[0].GetString();
-        const char *maybeNodeName = cmd == "addNode" ? di[2].GetString() : (
+        const char *maybeNodeName = cmd == "addNode" || cmd == "addSubgraphInstance" ? di[2].GetString() : (
             di.Size() >= 1 && di[1].IsString() ? di[1].GetString() : "(not a node)");
-        //ZENO_P(cmd);
-        //ZENO_P(maybeNodeName);
+        std::function<void(State &, std::string const &)> apply;
         GraphException::translated([&] {
             if (0) {
             } else if (cmd == "addNode") {
-                g->addNode(di[1].GetString(), di[2].GetString());
-            } else if (cmd == "setNodeInput") {
-                g->setNodeInput(di[1].GetString(), di[2].GetString(), generic_get<zany>(di[3]));
-            } else if (cmd == "setKeyFrame") {
-                g->setKeyFrame(di[1].GetString(), di[2].GetString(), generic_get<zany>(di[3]));
-            } else if (cmd == "setFormula") {
-                g->setFormula(di[1].GetString(), di[2].GetString(), generic_get<zany>(di[3]));
+                auto cl = safe_at(root->session->nodeClasses, di[1].GetString(), "node class name").get();
+                apply = [cl] (State &s, std::string const &id) {
+                    s.g->addNode(cl, id);
+                };
+            } else if (cmd == "setNodeInput" || cmd == "setKeyFrame" || cmd == "setFormula") {
+                auto set = cmd == "setNodeInput" ? &Graph::setNodeInput : cmd == "setKeyFrame" ? &Graph::setKeyFrame : &Graph::setFormula;
+                apply = [set, par = std::string(di[2].GetString()), val = generic_get<zany>(di[3])] (State &s, std::string const &id) {
+                    (s.g->*set)(id, par, cloneLiterial(val));
+                };
             } else if (cmd == "setNodeParam") {
-                g->setNodeParam(di[1].GetString(), di[2].GetString(), generic_get<std::variant<int, float, std::string, zany>, false>(di[3]));
+                auto val = generic_get<std::variant<int, float, std::string, zany>, false>(di[3]);
+                apply = [par = std::string(di[2].GetString()), val = std::move(val)] (State &s, std::string const &id) {
+                    if (auto p = std::get_if<zany>(&val))
+                        s.g->setNodeParam(id, par, cloneLiterial(*p));
+                    else
+                        s.g->setNodeParam(id, par, val);
+                };
             } else if (cmd == "bindNodeInput") {
-                g->bindNodeInput(di[1].GetString(), di[2].GetString(), di[3].GetString(), di[4].GetString());
+                apply = [ds = std::string(di[2].GetString()), sn = std::string(di[3].GetString()),
+                         ss = std::string(di[4].GetString())] (State &s, std::string const &id) {
+                    s.g->bindNodeInput(id, ds, s.name(sn.c_str()), ss);
+                };
             } else if (cmd == "completeNode") {
-                g->completeNode(di[1].GetString());
+                apply = [] (State &s, std::string const &id) {
+                    s.g->completeNode(id);
+                };
             } else if (cmd == "addSubnetNode") {
-                auto newG = g->addSubnetNode(/*di[1].GetString(), */di[2].GetString());
+                apply = [id2 = std::string(di[2].GetString())] (State &s, std::string const &) {
+                    s.g->addSubnetNode(s.name(id2.c_str()));
+                };
+            } else if (cmd == "addSubgraphInstance") {
+                auto sub = safe_at(root->subgraphDefs, di[1].GetString(), "subgraph definition");
+                apply = [sub, scope = std::string(di[3].GetString())] (State &s, std::string const &id) {
+                    s.g->addSubgraphInstance(*sub, id, s.name(scope.c_str()));
+                };
+            } else if (cmd == "defineSubgraph") {
+                // definitions are shared by all the instances after them, nothing to do per instance
+                root->subgraphDefs[di[1].GetString()] = compileCommands(root, di[2]);
             } else if (cmd == "addNodeOutput") {
-                g->addNodeOutput(di[1].GetString(), di[2].GetString());
+                apply = [par = std::string(di[2].GetString())] (State &s, std::string const &id) {
+                    s.g->addNodeOutput(id, par);
+                };
             } else if (cmd == "pushSubnetScope") {
-                gStack.push(g);
-                g = g->getSubnetGraph(di[1].GetString());
+                apply = [] (State &s, std::string const &id) {
+                    s.gStack.push(s.g);
+                    s.g = s.g->getSubnetGraph(id);
+                };
             } else if (cmd == "popSubnetScope") {
-                g = gStack.top();
-                gStack.pop();
+                apply = [] (State &s, std::string const &) {
+                    s.g = s.gStack.top();
+                    s.gStack.pop();
+                };
             } else if (cmd == "setBeginFrameNumber") {
-                this->beginFrameNumber = di[1].GetInt();
+                apply = [n = di[1].GetInt()] (State &s, std::string const &) {
+                    s.root->beginFrameNumber = n;
+                };
             } else if (cmd == "setEndFrameNumber") {
-                this->endFrameNumber = di[1].GetInt();
+                apply = [n = di[1].GetInt()] (State &s, std::string const &) {
+                    s.root->endFrameNumber = n;
+                };
             } else if (cmd == "setNodeOption") {
                 // skip this for compatibility
             } else if (cmd == "markNodeChanged") {
-                auto ident = di[1].GetString();
-                auto &dc = g->getDirtyChecker();
-                dc.taintThisNode(ident);
-                //todo: mark node data change.
+                apply = [] (State &s, std::string const &id) {
+                    auto &dc = s.g->getDirtyChecker();
+                    dc.taintThisNode(id);
+                    //todo: mark node data change.
+                };
             } else {
                 log_warn("got unexpected command: {}", cmd);
             }
         }, maybeNodeName);
+        if (apply)
+            def->commands.push_back({maybeNodeName, std::move(apply)});
     }
+    return def;
+}
+
+ZENO_API std::shared_ptr<SubgraphDefinition> SubgraphDefinition::parse(Graph *root, const char *json) {
+    Document d;
+    d.Parse(json);
+    return compileCommands(root, d);
+}
+
+ZENO_API void SubgraphDefinition::instantiate(Graph *g, std::string const &prefix) const {
+    State s{g, g, {}, prefix};
+    for (auto const &cmd: commands) {
+        auto id = s.name(cmd.node.c_str());
+        GraphException::translated([&] {
+            cmd.apply(s, id);
+        }, id);
+    }
+}
+
+ZENO_API void Graph::loadGraph(const char *json) {
+    SubgraphDefinition::parse(this, json)->instantiate(this, "");
 }
 
 }
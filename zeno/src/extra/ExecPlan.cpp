@@ -0,0 +1,42 @@
+#include <zeno/extra/ExecPlan.h>
+#include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+
+namespace zeno {
+
+ZENO_API ExecPlan::ExecPlan(Graph *graph, ExecPlan const *previous) {
+    nodeCount = graph->nodes.size();
+    if (previous)
+        slots.resize(previous->slots.size());
+
+    // keep the slot of every node that still has one, visited bits of a running context stay valid
+    std::vector<INode *> fresh;
+    for (auto const &[id, node]: graph->nodes) {
+        auto i = node->execIndex;
+        if (i >= 0 && (std::size_t)i < slots.size() && !slots[i].node)
+            slots[i].node = node.get();
+        else
+            fresh.push_back(node.get());
+    }
+    for (auto *node: fresh) {
+        node->execIndex = slots.size();
+        slots.emplace_back().node = node;
+    }
+
+    for (auto &slot: slots) {
+        if (slot.node)
+            resolveInputs(graph, slot.node, slot.inputs);
+    }
+}
+
+ZENO_API void ExecPlan::resolveInputs(Graph *graph, INode *node, std::vector<Input> &inputs) {
+    inputs.clear();
+    inputs.reserve(node->inputBounds.size());
+    for (auto const &[ds, bound]: node->inputBounds) {
+        auto it = graph->nodes.find(bound.first);
+        inputs.push_back({&ds, &bound.first, &bound.second,
+                          it == graph->nodes.end() ? nullptr : it->second.get()});
+    }
+}
+
+}
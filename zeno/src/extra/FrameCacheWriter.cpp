@@ -0,0 +1,110 @@
+#include <zeno/extra/FrameCacheWriter.h>
+#include <zeno/extra/GlobalComm.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/log.h>
+#include <algorithm>
+#include <exception>
+
+namespace zeno {
+
+struct FrameCacheWriter::Job {
+    int frameid = 0;
+    bool cacheLightCameraOnly = false;
+    bool cacheMaterialOnly = false;
+    std::string cachedir;
+    GlobalComm::ViewObjects objs;
+    std::function<void()> onWritten;
+};
+
+ZENO_API FrameCacheWriter::FrameCacheWriter(GlobalComm *comm)
+    : m_comm(comm)
+    , m_maxPending(std::max(1, envconfig::getInt("ZENCACHE_QUEUE", 2)))
+{
+    int nthreads = std::max(1, envconfig::getInt("ZENCACHE_WRITERS", 2));
+    for (int i = 0; i < nthreads; i++) {
+        m_threads.emplace_back([this] { worker(); });
+    }
+}
+
+ZENO_API FrameCacheWriter::~FrameCacheWriter() {
+    {
+        std::lock_guard lck(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto &thr: m_threads) {
+        thr.join();
+    }
+}
+
+void FrameCacheWriter::worker() {
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock lck(m_mtx);
+            // pending frames are still written when stopping
+            m_cv.wait(lck, [&] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        try {
+            GlobalComm::writeFrameCache(job->cachedir, job->frameid, job->objs,
+                                        job->cacheLightCameraOnly, job->cacheMaterialOnly);
+        } catch (std::exception const &e) {
+            log_error("failed to dump frame {}: {}", job->frameid, e.what());
+        }
+        if (job->onWritten)
+            job->onWritten();
+        int frameid = job->frameid;
+        job = nullptr;  // release the objects before anyone is told there is room
+        {
+            std::lock_guard lck(m_mtx);
+            for (auto &[id, written]: m_order) {
+                if (id == frameid && !written) {
+                    written = true;
+                    break;
+                }
+            }
+            m_npending--;
+        }
+        m_cv.notify_all();
+    }
+}
+
+ZENO_API void FrameCacheWriter::push(int frameid, bool cacheLightCameraOnly, bool cacheMaterialOnly,
+                                     std::function<void()> onWritten) {
+    auto job = std::make_unique<Job>();
+    job->frameid = frameid;
+    job->cacheLightCameraOnly = cacheLightCameraOnly;
+    job->cacheMaterialOnly = cacheMaterialOnly;
+    job->onWritten = std::move(onWritten);
+    if (!m_comm->takeFrameCache(frameid, job->objs, job->cachedir))
+        log_warn("no frame {} to dump", frameid);
+
+    std::unique_lock lck(m_mtx);
+    m_cv.wait(lck, [&] { return m_npending < m_maxPending; });
+    m_npending++;
+    m_order.emplace_back(frameid, false);
+    m_queue.push_back(std::move(job));
+    lck.unlock();
+    m_cv.notify_all();
+}
+
+ZENO_API std::vector<int> FrameCacheWriter::takeWritten() {
+    std::lock_guard lck(m_mtx);
+    std::vector<int> res;
+    while (!m_order.empty() && m_order.front().second) {
+        res.push_back(m_order.front().first);
+        m_order.pop_front();
+    }
+    return res;
+}
+
+ZENO_API void FrameCacheWriter::wait() {
+    std::unique_lock lck(m_mtx);
+    m_cv.wait(lck, [&] { return m_npending == 0; });
+}
+
+}
@@ -1,11 +1,16 @@
 #include <zeno/extra/GlobalComm.h>
 #include <zeno/extra/GlobalState.h>
+#include <zeno/extra/Profiler.h>
 #include <zeno/funcs/ObjectCodec.h>
+#include <zeno/utils/mapped_file.h>
+#include <zeno/utils/envconfig.h>
 #include <zeno/utils/log.h>
+#include <string_view>
 #include <filesystem>
 #include <algorithm>
 #include <fstream>
 #include <cassert>
+#include <cstring>
 #include <zeno/types/UserData.h>
 #include <unordered_set>
 #include <zeno/types/MaterialObject.h>
@@ -18,13 +23,143 @@
 
 namespace zeno {
 
-std::vector<std::filesystem::path> cachepath(3);
 std::unordered_set<std::string> lightCameraNodes({
     "CameraEval", "CameraNode", "CihouMayaCameraFov", "ExtractCameraData", "GetAlembicCamera","MakeCamera",
     "LightNode", "BindLight", "ProceduralSky", "HDRSky",
     });
 std::string matlNode = "ShaderFinalize";
 
+namespace {
+
+/* zencache v2 layout, all offsets relative to the beginning of the file:
+ *   ZenCacheHeader | ZenCacheEntry[count] | keys | objects
+ * each object is aligned to ZENCACHE_ALIGN so that the file can be mmap'ed
+ * and any single object decoded in place, without reading the others. */
+constexpr size_t ZENCACHE_ALIGN = 64;
+
+struct ZenCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+};
+
+struct ZenCacheEntry {
+    uint64_t keyOffset;
+    uint64_t keySize;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct ZenCacheWriter {
+    std::vector<ZenCacheEntry> entries;
+    std::string keys;
+    std::vector<char> data;  // objects section, offsets are fixed up by finish()
+    size_t dataStart = 0;
+
+    void append(std::string const &key, IObject *obj, ObjectCodecOptions const &opts) {
+        size_t pos = data.size();
+        data.resize((pos + ZENCACHE_ALIGN - 1) / ZENCACHE_ALIGN * ZENCACHE_ALIGN);
+        size_t beg = data.size();
+        if (!encodeObject(obj, data, opts)) {
+            data.resize(pos);
+            return;
+        }
+        entries.push_back({keys.size(), key.size(), beg, data.size() - beg});
+        keys.append(key);
+    }
+
+    size_t finish() {
+        size_t headSize = sizeof(ZenCacheHeader) + entries.size() * sizeof(ZenCacheEntry) + keys.size();
+        dataStart = (headSize + ZENCACHE_ALIGN - 1) / ZENCACHE_ALIGN * ZENCACHE_ALIGN;
+        size_t keysStart = sizeof(ZenCacheHeader) + entries.size() * sizeof(ZenCacheEntry);
+        for (auto &ent: entries) {
+            ent.keyOffset += keysStart;
+            ent.dataOffset += dataStart;
+        }
+        return dataStart + data.size();
+    }
+
+    void write(std::ostream &os) const {
+        ZenCacheHeader header{{'Z', 'E', 'N', 'C', 'A', 'C', 'H', '2'}, 2, (uint32_t)entries.size()};
+        os.write((const char *)&header, sizeof(header));
+        os.write((const char *)entries.data(), entries.size() * sizeof(ZenCacheEntry));
+        os.write(keys.data(), keys.size());
+        size_t headSize = sizeof(ZenCacheHeader) + entries.size() * sizeof(ZenCacheEntry) + keys.size();
+        std::string padding(dataStart - headSize, '\0');
+        os.write(padding.data(), padding.size());
+        os.write(data.data(), data.size());
+    }
+};
+
+// parse the index of a v2 file, objects are left in the mapping
+bool readIndexV2(std::shared_ptr<mapped_file> const &file, std::map<std::string, GlobalComm::LazyObject> &lazy) {
+    const char *dat = file->data();
+    size_t size = file->size();
+    ZenCacheHeader header;
+    if (size < sizeof(header)) {
+        log_error("zeno cache file broken (1)");
+        return false;
+    }
+    std::memcpy(&header, dat, sizeof(header));
+    if (header.version != 2 || header.count > (size - sizeof(header)) / sizeof(ZenCacheEntry)) {
+        log_error("zeno cache file broken (2)");
+        return false;
+    }
+    std::vector<ZenCacheEntry> entries(header.count);
+    std::memcpy(entries.data(), dat + sizeof(header), entries.size() * sizeof(ZenCacheEntry));
+    for (size_t k = 0; k < entries.size(); k++) {
+        auto const &ent = entries[k];
+        if (ent.keyOffset > size || ent.keySize > size - ent.keyOffset
+            || ent.dataOffset > size || ent.dataSize > size - ent.dataOffset) {
+            log_error("zeno cache file broken (3.{})", k);
+            return false;
+        }
+        lazy.try_emplace(std::string(dat + ent.keyOffset, ent.keySize),
+                         GlobalComm::LazyObject{file, (size_t)ent.dataOffset, (size_t)ent.dataSize});
+    }
+    return true;
+}
+
+// files written before v2: "ZENCACHE" count '\a' key0 '\a' key1 ... '\a' poses objects
+bool readIndexV1(std::shared_ptr<mapped_file> const &file, std::map<std::string, GlobalComm::LazyObject> &lazy) {
+    const char *dat = file->data();
+    size_t size = file->size();
+    size_t pos = std::find(dat + 8, dat + size, '\a') - dat;
+    if (pos == size) {
+        log_error("zeno cache file broken (2)");
+        return false;
+    }
+    size_t keyscount = std::stoi(std::string(dat + 8, pos - 8));
+    pos = pos + 1;
+    std::vector<std::string> keys;
+    for (int k = 0; k < keyscount; k++) {
+        size_t newpos = std::find(dat + pos, dat + size, '\a') - dat;
+        if (newpos == size) {
+            log_error("zeno cache file broken (3.{})", k);
+            return false;
+        }
+        keys.emplace_back(dat + pos, newpos - pos);
+        pos = newpos + 1;
+    }
+    if ((keyscount + 1) * sizeof(size_t) > size - pos) {
+        log_error("zeno cache file broken (4)");
+        return false;
+    }
+    std::vector<size_t> poses(keyscount + 1);
+    std::memcpy(poses.data(), dat + pos, (keyscount + 1) * sizeof(size_t));
+    pos += (keyscount + 1) * sizeof(size_t);
+    for (int k = 0; k < keyscount; k++) {
+        if (poses[k + 1] > size - pos || poses[k + 1] < poses[k]) {
+            log_error("zeno cache file broken (4.{})", k);
+            return false;
+        }
+        lazy.try_emplace(keys[k], GlobalComm::LazyObject{file, pos + poses[k], poses[k + 1] - poses[k]});
+    }
+    return true;
+}
+
+}
+
 static void toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &objs, bool cacheLightCameraOnly, bool cacheMaterialOnly) {
     if (cachedir.empty()) return;
     std::filesystem::path dir = std::filesystem::u8path(cachedir + "/" + std::to_string(1000000 + frameid).substr(1));
@@ -32,74 +167,40 @@ static void toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &o
     {
         log_critical("can not create path: {}", dir);
     }
-    std::vector<std::vector<char>> bufCaches(3);
-    std::vector<std::vector<size_t>> poses(3);
-    std::vector<std::string> keys(3);
+    std::vector<ZenCacheWriter> writers(3);
+    // primitive attributes are compressed, pos and vel can be quantized with ZENO_ZENCACHE_QUANTIZE=<max error>
+    ObjectCodecOptions opts;
+    opts.compress = envconfig::getBool("ZENCACHE_COMPRESS", true);
+    if (auto quantize = envconfig::getCStr("ZENCACHE_QUANTIZE")) {
+        char *end = nullptr;
+        float error = std::strtof(quantize, &end);
+        if (*end || !(error >= 0))
+            log_warn("invalid ZENO_ZENCACHE_QUANTIZE={}, saving lossless", quantize);
+        else
+            opts.quantizeError = error;
+    }
     for (auto const &[key, obj]: objs) {
 
-        size_t bufsize =0;
         std::string nodeName = key.substr(key.find("-") + 1, key.find(":") - key.find("-") -1);
-        if (cacheLightCameraOnly && (lightCameraNodes.count(nodeName) || obj->userData().get2<int>("isL", 0) || std::dynamic_pointer_cast<CameraObject>(obj)))
-        {
-            bufsize = bufCaches[0].size();
-            if (encodeObject(obj.get(), bufCaches[0]))
-            {
-                keys[0].push_back('\a');
-                keys[0].append(key);
-                poses[0].push_back(bufsize);
-            }
-        }
-        if (cacheMaterialOnly && (matlNode == nodeName || std::dynamic_pointer_cast<MaterialObject>(obj)))
-        {
-            bufsize = bufCaches[1].size();
-            if (encodeObject(obj.get(), bufCaches[1]))
-            {
-                keys[1].push_back('\a');
-                keys[1].append(key);
-                poses[1].push_back(bufsize);
-            }
-        }
+        bool isLightCamera = lightCameraNodes.count(nodeName) || obj->userData().get2<int>("isL", 0) || std::dynamic_pointer_cast<CameraObject>(obj);
+        bool isMaterial = matlNode == nodeName || std::dynamic_pointer_cast<MaterialObject>(obj);
+        if (cacheLightCameraOnly && isLightCamera)
+            writers[0].append(key, obj.get(), opts);
+        if (cacheMaterialOnly && isMaterial)
+            writers[1].append(key, obj.get(), opts);
         if (!cacheLightCameraOnly && !cacheMaterialOnly)
-        {
-            if (lightCameraNodes.count(nodeName) || obj->userData().get2<int>("isL", 0) || std::dynamic_pointer_cast<CameraObject>(obj)) {
-                bufsize = bufCaches[0].size();
-                if (encodeObject(obj.get(), bufCaches[0]))
-                {
-                    keys[0].push_back('\a');
-                    keys[0].append(key);
-                    poses[0].push_back(bufsize);
-                }
-            } else if (matlNode == nodeName || std::dynamic_pointer_cast<MaterialObject>(obj)) {
-                bufsize = bufCaches[1].size();
-                if (encodeObject(obj.get(), bufCaches[1]))
-                {
-                    keys[1].push_back('\a');
-                    keys[1].append(key);
-                    poses[1].push_back(bufsize);
-                }
-            } else {
-                bufsize = bufCaches[2].size();
-                if (encodeObject(obj.get(), bufCaches[2]))
-                {
-                    keys[2].push_back('\a');
-                    keys[2].append(key);
-                    poses[2].push_back(bufsize);
-                }
-            }
-        }
+            writers[isLightCamera ? 0 : isMaterial ? 1 : 2].append(key, obj.get(), opts);
     }
+    std::vector<std::filesystem::path> cachepath(3);
     cachepath[0] = dir / "lightCameraObj.zencache";
     cachepath[1] = dir / "materialObj.zencache";
     cachepath[2] = dir / "normalObj.zencache";
     size_t currentFrameSize = 0;
     for (int i = 0; i < 3; i++)
     {
-        if (poses[i].size() == 0 && (cacheLightCameraOnly && i != 0 || cacheMaterialOnly && i != 1))
+        if (writers[i].entries.size() == 0 && (cacheLightCameraOnly && i != 0 || cacheMaterialOnly && i != 1))
             continue;
-        keys[i].push_back('\a');
-        keys[i] = "ZENCACHE" + std::to_string(poses[i].size()) + keys[i];
-        poses[i].push_back(bufCaches[i].size());
-        currentFrameSize += keys[i].size() + poses[i].size() * sizeof(size_t) + bufCaches[i].size();
+        currentFrameSize += writers[i].finish();
     }
     size_t freeSpace = 0;
     #ifdef __linux__
@@ -126,22 +227,37 @@ static void toDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &o
     }
     for (int i = 0; i < 3; i++)
     {
-        if (poses[i].size() == 0 && (cacheLightCameraOnly && i != 0 || cacheMaterialOnly && i != 1))
+        if (writers[i].entries.size() == 0 && (cacheLightCameraOnly && i != 0 || cacheMaterialOnly && i != 1))
             continue;
         log_critical("dump cache to disk {}", cachepath[i]);
-        std::ofstream ofs(cachepath[i], std::ios::binary);
-        std::ostreambuf_iterator<char> oit(ofs);
-        std::copy(keys[i].begin(), keys[i].end(), oit);
-        std::copy_n((const char *)poses[i].data(), poses[i].size() * sizeof(size_t), oit);
-        std::copy(bufCaches[i].begin(), bufCaches[i].end(), oit);
+        // the old file may still be mmap'ed by lazy objects of fromDisk, replace it instead of truncating
+        auto tmppath = cachepath[i];
+        tmppath += ".tmp";
+        {
+            std::ofstream ofs(tmppath, std::ios::binary);
+            writers[i].write(ofs);
+            if (!ofs.flush()) {
+                log_error("failed to write zencache {}", tmppath);
+                continue;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmppath, cachepath[i], ec);
+        if (ec) {
+            log_error("failed to replace zencache {}: {}", cachepath[i], ec.message());
+            std::filesystem::remove(tmppath, ec);
+        }
     }
     objs.clear();
 }
 
-static bool fromDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects &objs) {
+static bool fromDisk(std::string cachedir, int frameid, GlobalComm::FrameData &frame) {
+    Profiler::Span _prof("io", "zencache load " + std::to_string(frameid));
     if (cachedir.empty())
         return false;
-    objs.clear();
+    frame.view_objects.clear();
+    frame.lazy_objects.clear();
+    std::vector<std::filesystem::path> cachepath(3);
     cachepath[2] = std::filesystem::u8path(cachedir) / std::to_string(1000000 + frameid).substr(1) / "normalObj.zencache";
     cachepath[1] = std::filesystem::u8path(cachedir) / std::to_string(1000000 + frameid).substr(1) / "materialObj.zencache";
     cachepath[0] = std::filesystem::u8path(cachedir) / std::to_string(1000000 + frameid).substr(1) / "lightCameraObj.zencache";
@@ -153,53 +269,37 @@ static bool fromDisk(std::string cachedir, int frameid, GlobalComm::ViewObjects
         }
         log_critical("load cache from disk {}", path);
 
-        auto szBuffer = std::filesystem::file_size(path);
-        std::vector<char> dat(szBuffer);
-        FILE *fp = fopen(path.string().c_str(), "rb");
-        if (!fp) {
-            log_error("zeno cache file does not exist");
-            return false;
-        }
-        size_t ret = fread(&dat[0], 1, szBuffer, fp);
-        assert(ret == szBuffer);
-        fclose(fp);
-        fp = nullptr;
-
-        if (dat.size() <= 8 || std::string(dat.data(), 8) != "ZENCACHE") {
+        auto file = std::make_shared<mapped_file>(path);
+        if (!*file || file->size() <= 8) {
             log_error("zeno cache file broken (1)");
             return false;
         }
-        size_t pos = std::find(dat.begin() + 8, dat.end(), '\a') - dat.begin();
-        if (pos == dat.size()) {
-            log_error("zeno cache file broken (2)");
+        std::string_view magic(file->data(), 8);
+        bool ret = magic == "ZENCACH2" ? readIndexV2(file, frame.lazy_objects)
+                 : magic == "ZENCACHE" ? readIndexV1(file, frame.lazy_objects)
+                 : (log_error("zeno cache file broken (1)"), false);
+        if (!ret)
             return false;
-        }
-        size_t keyscount = std::stoi(std::string(dat.data() + 8, pos - 8));
-        pos = pos + 1;
-        std::vector<std::string> keys;
-        for (int k = 0; k < keyscount; k++) {
-            size_t newpos = std::find(dat.begin() + pos, dat.end(), '\a') - dat.begin();
-            if (newpos == dat.size()) {
-                log_error("zeno cache file broken (3.{})", k);
-                return false;
-            }
-            keys.emplace_back(dat.data() + pos, newpos - pos);
-            pos = newpos + 1;
-        }
-        std::vector<size_t> poses(keyscount + 1);
-        std::copy_n(dat.data() + pos, (keyscount + 1) * sizeof(size_t), (char *)poses.data());
-        pos += (keyscount + 1) * sizeof(size_t);
-        for (int k = 0; k < keyscount; k++) {
-            if (poses[k] > dat.size() - pos || poses[k + 1] < poses[k]) {
-                log_error("zeno cache file broken (4.{})", k);
-            }
-            const char *p = dat.data() + pos + poses[k];
-            objs.try_emplace(keys[k], decodeObject(p, poses[k + 1] - poses[k]));
-        }
     }
     return true;
 }
 
+// decode the lazy objects of frame for which isNeeded returns true, all of them if not given
+static void decodeLazy(GlobalComm::FrameData &frame, std::function<bool(std::string const &)> const &isNeeded) {
+    for (auto it = frame.lazy_objects.begin(); it != frame.lazy_objects.end();) {
+        if (isNeeded && !isNeeded(it->first)) {
+            ++it;
+            continue;
+        }
+        auto const &lazy = it->second;
+        if (auto obj = decodeObject(lazy.file->data() + lazy.offset, lazy.size))
+            frame.view_objects.try_emplace(it->first, std::move(obj));
+        else
+            log_error("failed to decode cached object {}", it->first);
+        it = frame.lazy_objects.erase(it);
+    }
+}
+
 ZENO_API void GlobalComm::newFrame() {
     std::lock_guard lck(m_mtx);
     log_debug("GlobalComm::newFrame {}", m_frames.size());
@@ -223,6 +323,23 @@ ZENO_API void GlobalComm::dumpFrameCache(int frameid, bool cacheLightCameraOnly,
     }
 }
 
+ZENO_API bool GlobalComm::takeFrameCache(int frameid, ViewObjects &objs, std::string &cachedir) {
+    std::lock_guard lck(m_mtx);
+    int frameIdx = frameid - beginFrameNumber;
+    if (frameIdx < 0 || frameIdx >= m_frames.size())
+        return false;
+    std::swap(objs, m_frames[frameIdx].view_objects);
+    m_frames[frameIdx].view_objects.clear();
+    cachedir = cacheFramePath;
+    return true;
+}
+
+ZENO_API void GlobalComm::writeFrameCache(std::string const &cachedir, int frameid, ViewObjects &objs, bool cacheLightCameraOnly, bool cacheMaterialOnly) {
+    log_debug("dumping frame {}", frameid);
+    Profiler::Span _prof("io", "zencache dump " + std::to_string(frameid));
+    toDisk(cachedir, frameid, objs, cacheLightCameraOnly, cacheMaterialOnly);
+}
+
 ZENO_API void GlobalComm::addViewObject(std::string const &key, std::shared_ptr<IObject> object) {
     std::lock_guard lck(m_mtx);
     log_debug("GlobalComm::addViewObject {}", m_frames.size());
@@ -285,14 +402,14 @@ ZENO_API GlobalComm::ViewObjects const *GlobalComm::getViewObjects(const int fra
     return _getViewObjects(frameid);
 }
 
-GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(const int frameid) {
+GlobalComm::FrameData *GlobalComm::_loadFrame(const int frameid) {
     int frameIdx = frameid - beginFrameNumber;
     if (frameIdx < 0 || frameIdx >= m_frames.size())
         return nullptr;
     if (maxCachedFrames != 0) {
         // load back one gc:
         if (!m_inCacheFrames.count(frameid)) {  // notinmem then cacheit
-            bool ret = fromDisk(cacheFramePath, frameid, m_frames[frameIdx].view_objects);
+            bool ret = fromDisk(cacheFramePath, frameid, m_frames[frameIdx]);
             if (!ret)
                 return nullptr;
 
@@ -305,6 +422,7 @@ GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(const int frameid) {
                         // so, there is no need to dump.
                         //toDisk(cacheFramePath, i, m_frames[i - beginFrameNumber].view_objects);
                         m_frames[i - beginFrameNumber].view_objects.clear();
+                        m_frames[i - beginFrameNumber].lazy_objects.clear();
                         m_inCacheFrames.erase(i);
                         break;
                     }
@@ -312,7 +430,15 @@ GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(const int frameid) {
             }
         }
     }
-    return &m_frames[frameIdx].view_objects;
+    return &m_frames[frameIdx];
+}
+
+GlobalComm::ViewObjects const* GlobalComm::_getViewObjects(const int frameid) {
+    auto frame = _loadFrame(frameid);
+    if (!frame)
+        return nullptr;
+    decodeLazy(*frame, {});
+    return &frame->view_objects;
 }
 
 ZENO_API GlobalComm::ViewObjects const &GlobalComm::getViewObjects() {
@@ -323,7 +449,8 @@ ZENO_API GlobalComm::ViewObjects const &GlobalComm::getViewObjects() {
 ZENO_API bool GlobalComm::load_objects(
         const int frameid,
         const std::function<bool(std::map<std::string, std::shared_ptr<zeno::IObject>> const& objs)>& callback,
-        bool& isFrameValid)
+        bool& isFrameValid,
+        const std::function<bool(std::string const& key)>& isNeeded)
 {
     if (!callback)
         return false;
@@ -340,10 +467,19 @@ ZENO_API bool GlobalComm::load_objects(
 
     isFrameValid = true;
     bool inserted = false;
-    auto const* viewObjs = _getViewObjects(frameid);
-    if (viewObjs) {
-        zeno::log_trace("load_objects: {} objects at frame {}", viewObjs->size(), frameid);
-        inserted = callback(viewObjs->m_curr);
+    auto *frameData = _loadFrame(frameid);
+    if (frameData) {
+        decodeLazy(*frameData, isNeeded);
+        auto const &viewObjs = frameData->view_objects;
+        zeno::log_trace("load_objects: {} objects at frame {}", viewObjs.size() + frameData->lazy_objects.size(), frameid);
+        if (frameData->lazy_objects.empty()) {
+            inserted = callback(viewObjs.m_curr);
+        } else {
+            auto objs = viewObjs.m_curr;
+            for (auto const &[key, lazy]: frameData->lazy_objects)
+                objs.try_emplace(key, nullptr);
+            inserted = callback(objs);
+        }
     }
     else {
         zeno::log_trace("load_objects: no objects at frame {}", frameid);
@@ -10,20 +10,39 @@ namespace zeno {
 ZENO_API void GlobalStatus::clearState() {
     nodeName = {};
     error = nullptr;
+    nodeStats.clear();
 }
 
 ZENO_API std::string GlobalStatus::toJson() const {
-    if (!failed()) return {};
+    if (!failed() && nodeStats.empty()) return {};
 
     rapidjson::Document doc(rapidjson::kObjectType);
-    rapidjson::Value nodeNameJson(rapidjson::kStringType);
-    nodeNameJson.SetString(nodeName.data(), nodeName.size());
-    doc.AddMember("nodeName", nodeNameJson, doc.GetAllocator());
+    if (failed()) {
+        rapidjson::Value nodeNameJson(rapidjson::kStringType);
+        nodeNameJson.SetString(nodeName.data(), nodeName.size());
+        doc.AddMember("nodeName", nodeNameJson, doc.GetAllocator());
 
-    auto const &errorMessage = error->message;
-    rapidjson::Value errorMessageJson(rapidjson::kStringType);
-    errorMessageJson.SetString(errorMessage.data(), errorMessage.size());
-    doc.AddMember("errorMessage", errorMessageJson, doc.GetAllocator());
+        auto const &errorMessage = error->message;
+        rapidjson::Value errorMessageJson(rapidjson::kStringType);
+        errorMessageJson.SetString(errorMessage.data(), errorMessage.size());
+        doc.AddMember("errorMessage", errorMessageJson, doc.GetAllocator());
+    }
+
+    if (!nodeStats.empty()) {
+        rapidjson::Value statsJson(rapidjson::kArrayType);
+        for (auto const &st: nodeStats) {
+            rapidjson::Value stJson(rapidjson::kObjectType);
+            rapidjson::Value nameJson(rapidjson::kStringType);
+            nameJson.SetString(st.name.data(), st.name.size(), doc.GetAllocator());
+            stJson.AddMember("name", nameJson, doc.GetAllocator());
+            stJson.AddMember("count", st.count, doc.GetAllocator());
+            stJson.AddMember("totalMs", st.totalMs, doc.GetAllocator());
+            stJson.AddMember("maxMs", st.maxMs, doc.GetAllocator());
+            stJson.AddMember("bytes", static_cast<uint64_t>(st.bytes), doc.GetAllocator());
+            statsJson.PushBack(stJson, doc.GetAllocator());
+        }
+        doc.AddMember("nodeStats", statsJson, doc.GetAllocator());
+    }
 
     rapidjson::StringBuffer buf;
     rapidjson::Writer writer(buf);
@@ -40,6 +59,24 @@ ZENO_API void GlobalStatus::fromJson(std::string_view json) {
 
     auto obj = doc.GetObject();
 
+    nodeStats.clear();
+    if (auto it = obj.FindMember("nodeStats"); it != obj.MemberEnd() && it->value.IsArray()) {
+        for (auto const &stJson: it->value.GetArray()) {
+            Profiler::NodeStat st;
+            st.name.assign(stJson["name"].GetString(), stJson["name"].GetStringLength());
+            st.count = stJson["count"].GetInt();
+            st.totalMs = stJson["totalMs"].GetDouble();
+            st.maxMs = stJson["maxMs"].GetDouble();
+            st.bytes = static_cast<std::size_t>(stJson["bytes"].GetUint64());
+            nodeStats.push_back(std::move(st));
+        }
+        if (!obj.HasMember("nodeName")) {  // a profile of a successful run
+            nodeName = {};
+            error = nullptr;
+            return;
+        }
+    }
+
     if (auto it = obj.FindMember("nodeName"); it == obj.MemberEnd()) {
         log_warn("document has no nodeName!");
         return;
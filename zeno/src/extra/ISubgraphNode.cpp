@@ -1,9 +1,12 @@
 #include <zeno/extra/ISubgraphNode.h>
+#include <zeno/extra/SubgraphDefinition.h>
 #include <zeno/core/Graph.h>
 #include <zeno/core/Session.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/DummyObject.h>
 //#include <zeno/utils/zeno_p.h>
+#include <mutex>
+#include <map>
 
 namespace zeno {
 
@@ -12,8 +15,19 @@ ZENO_API ISubgraphNode::~ISubgraphNode() = default;
 ZENO_API void ISubgraphNode::apply() {
     if (!grap) {
         grap = getThisSession()->createGraph();
+        // every instance of the same node class shares the parsed json
+        static std::mutex mtx;
+        static std::map<const char *, std::shared_ptr<SubgraphDefinition>> defs;
         auto json = get_subgraph_json();
-        grap->loadGraph(json);
+        std::shared_ptr<SubgraphDefinition> def;
+        {
+            std::lock_guard lck(mtx);
+            auto &cached = defs[json];
+            if (!cached)
+                cached = SubgraphDefinition::parse(grap.get(), json);
+            def = cached;
+        }
+        def->instantiate(grap.get(), "");
         for (auto const &[key, nodename]: grap->subOutputNodes) {
             grap->nodesToExec.insert(nodename);
         }
@@ -0,0 +1,332 @@
+#include <zeno/extra/IncrementalCache.h>
+#include <zeno/extra/GraphException.h>
+#include <zeno/extra/DirtyChecker.h>
+#include <zeno/extra/MemoCache.h>
+#include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+#include <zeno/types/DummyObject.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/StringObject.h>
+#include <zeno/utils/scope_exit.h>
+#include <zeno/utils/log.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <vector>
+
+namespace zeno {
+
+namespace {
+
+// the node being applied on this thread, used to discover hidden dependencies
+thread_local INode *tls_applying = nullptr;
+
+std::string dumpCommand(rapidjson::Value const &cmd) {
+    rapidjson::StringBuffer buf;
+    rapidjson::Writer writer(buf);
+    cmd.Accept(writer);
+    return {buf.GetString(), buf.GetLength()};
+}
+
+// small value objects that consumers replace rather than modify, kept and restored without a copy
+bool isShareable(IObject const *obj) {
+    return dynamic_cast<DummyObject const *>(obj)
+        || dynamic_cast<NumericObject const *>(obj)
+        || dynamic_cast<StringObject const *>(obj);
+}
+
+zany keepCopy(zany const &obj) {
+    if (!obj || isShareable(obj.get()))
+        return obj;
+    return obj->clone();
+}
+
+// size and mtime of the files named by the string inputs of node, 0 if none
+std::uint64_t inputFilesStamp(INode const *node) {
+    std::uint64_t stamp = 0;
+    for (auto const &[name, obj]: node->inputs) {
+        if (auto s = MemoCache::fileStamp(obj.get()))
+            stamp = stamp * 31 + s;
+    }
+    return stamp;
+}
+
+}
+
+void IncrementalCache::forget(std::string const &id) {
+    m_kept.erase(id);
+    m_hiddenDeps.erase(id);
+    m_touched.erase(id);
+    m_fileStamps.erase(id);
+}
+
+ZENO_API void IncrementalCache::loadGraph(Graph *graph, const char *json) {
+    rapidjson::Document d;
+    d.Parse(json);
+
+    if (!d.IsArray()) {
+        throw GraphException { "None", nullptr };
+    }
+
+    // group the commands by the top-level node they belong to, subnet scopes included
+    std::vector<std::string> cmds;
+    std::vector<std::size_t> globals;
+    std::map<std::string, std::vector<std::size_t>> nodeCmds;
+    std::map<std::string, std::set<std::string>> deps, consumers;
+    std::set<std::string> seeds;
+    std::string scope;
+    int depth = 0;
+
+    // an instance is only up to date if its definition, and the ones of the instances in it, are
+    std::map<std::string, std::string> defTexts, instanceDefs;
+    auto define = [&] (auto const &define, rapidjson::Value const &def) -> void {
+        std::string text = dumpCommand(def);
+        for (auto const &c: def[2].GetArray()) {
+            std::string sub = c[0].GetString();
+            if (sub == "defineSubgraph")
+                define(define, c);
+            else if (sub == "addSubgraphInstance")
+                text += defTexts[c[1].GetString()];
+        }
+        defTexts[def[1].GetString()] = std::move(text);
+    };
+
+    for (rapidjson::SizeType i = 0; i < d.Size(); i++) {
+        auto const &di = d[i];
+        cmds.push_back(dumpCommand(di));
+        std::string cmd = di[0].GetString();
+        if (cmd == "defineSubgraph") {
+            define(define, di);
+            globals.push_back(i);
+            continue;
+        }
+        if (depth) {
+            nodeCmds[scope].push_back(i);
+            if (cmd == "addSubgraphInstance")
+                instanceDefs[scope] += defTexts[di[1].GetString()];
+            if (cmd == "pushSubnetScope")
+                depth++;
+            else if (cmd == "popSubnetScope")
+                depth--;
+            continue;
+        }
+        std::string id;
+        if (cmd == "addNode" || cmd == "addSubnetNode") {
+            id = di[2].GetString();
+        } else if (cmd == "addSubgraphInstance") {
+            id = di[2].GetString();
+            instanceDefs[id] += defTexts[di[1].GetString()];
+        } else if (cmd == "pushSubnetScope") {
+            id = scope = di[1].GetString();
+            depth = 1;
+        } else if (cmd == "setBeginFrameNumber" || cmd == "setEndFrameNumber") {
+            globals.push_back(i);
+            continue;
+        } else if (di.Size() >= 2 && di[1].IsString()) {
+            id = di[1].GetString();
+        } else {
+            globals.push_back(i);
+            continue;
+        }
+        nodeCmds[id].push_back(i);
+        if (cmd == "bindNodeInput") {
+            std::string sn = di[3].GetString();
+            deps[id].insert(sn);
+            consumers[sn].insert(id);
+        } else if (cmd == "markNodeChanged") {
+            seeds.insert(id);
+        }
+    }
+
+    std::map<std::string, std::string> programs;
+    for (auto const &[id, idxs]: nodeCmds) {
+        auto &text = programs[id];
+        for (auto i: idxs) {
+            text += cmds[i];
+            text += ',';
+        }
+        if (auto it = instanceDefs.find(id); it != instanceDefs.end())
+            text += it->second;
+        if (auto it = m_programs.find(id); it == m_programs.end() || it->second != text)
+            seeds.insert(id);
+    }
+    for (auto const &[id, text]: m_programs) {
+        if (programs.count(id))
+            continue;
+        graph->removeNode(id);
+        forget(id);
+        if (auto it = consumers.find(id); it != consumers.end())
+            seeds.insert(it->second.begin(), it->second.end());
+    }
+    for (auto const &[id, node]: graph->nodes) {
+        if (!m_programs.count(id))
+            seeds.insert(id);  // nodes we don't know where they come from
+    }
+    seeds.insert(m_touched.begin(), m_touched.end());
+    m_touched.clear();
+    // file readers whose file was modified since, as MemoCache checks them
+    for (auto const &[id, stamp]: m_fileStamps) {
+        auto it = graph->nodes.find(id);
+        if (it != graph->nodes.end() && inputFilesStamp(it->second.get()) != stamp)
+            seeds.insert(id);
+    }
+    m_programs = std::move(programs);
+
+    std::set<std::string> invalid;
+    auto closure = [&] (std::string const &id, auto const &edges) {
+        std::vector<std::string> stack{id};
+        while (!stack.empty()) {
+            auto cur = std::move(stack.back());
+            stack.pop_back();
+            if (!invalid.insert(cur).second)
+                continue;
+            if (auto it = edges.find(cur); it != edges.end())
+                stack.insert(stack.end(), it->second.begin(), it->second.end());
+        }
+    };
+    for (auto const &id: seeds) {
+        closure(id, consumers);
+    }
+
+    // lazy nodes and nodes with hidden deps rely on their upstream being evaluated again
+    auto upstream = deps;
+    for (auto const &[id, hidden]: m_hiddenDeps) {
+        upstream[id].insert(hidden.begin(), hidden.end());
+    }
+    auto hasHiddenDeps = [hidden = m_hiddenDeps] (std::string const &id) {
+        return hidden.count(id) != 0;
+    };
+
+    // fresh dirty checker, just like a newly created graph would have
+    graph->dirtyChecker = nullptr;
+
+    std::set<std::string> replayed;
+    bool first = true;
+    while (true) {
+        std::vector<std::size_t> idxs;
+        if (first)
+            idxs = globals;
+        for (auto const &id: invalid) {
+            if (!replayed.insert(id).second)
+                continue;
+            graph->removeNode(id);
+            forget(id);
+            if (auto it = nodeCmds.find(id); it != nodeCmds.end())
+                idxs.insert(idxs.end(), it->second.begin(), it->second.end());
+        }
+        if (idxs.empty() && !first)
+            break;
+        first = false;
+        std::sort(idxs.begin(), idxs.end());
+        std::string partial = "[";
+        for (auto i: idxs) {
+            partial += cmds[i];
+            partial += ',';
+        }
+        if (partial.size() > 1)
+            partial.pop_back();
+        partial += ']';
+        graph->loadGraph(partial.c_str());
+
+        auto current = invalid;
+        for (auto const &id: current) {
+            auto it = graph->nodes.find(id);
+            if (it == graph->nodes.end())
+                continue;
+            if (it->second->hasLazyInputs() || hasHiddenDeps(id)) {
+                for (auto const &dep: upstream[id]) {
+                    closure(dep, upstream);
+                }
+            }
+        }
+    }
+    log_debug("incremental load: {} of {} nodes re-created", replayed.size(), graph->nodes.size());
+}
+
+ZENO_API void IncrementalCache::beginPass(int frameid) {
+    std::lock_guard lck(m_mtx);
+    if (frameid != m_frameid) {
+        m_kept.clear();
+        m_frameid = frameid;
+    }
+    m_inPass = true;
+}
+
+ZENO_API void IncrementalCache::endPass() {
+    std::lock_guard lck(m_mtx);
+    m_inPass = false;
+}
+
+ZENO_API bool IncrementalCache::isReusable(std::string const &id) const {
+    std::lock_guard lck(m_mtx);
+    return m_inPass && m_kept.count(id);
+}
+
+ZENO_API bool IncrementalCache::applyNode(INode *node, std::function<void()> const &apply) {
+    // frame dependent or stateful nodes may give something else on the next run, their consumers
+    // follow them in loadGraph(); nodes that only changed because their inputs did are re-created that way
+    auto applyAndTrack = [&] {
+        int accesses = MemoCache::sessionAccesses();
+        apply();
+        auto stamp = inputFilesStamp(node);
+        std::lock_guard lck(m_mtx);
+        if (MemoCache::sessionAccesses() != accesses || !node->isPure())
+            m_touched.insert(node->myname);
+        if (stamp)
+            m_fileStamps[node->myname] = stamp;
+        else
+            m_fileStamps.erase(node->myname);
+    };
+
+    std::unique_lock lck(m_mtx);
+    if (!m_inPass) {
+        lck.unlock();
+        applyAndTrack();
+        return true;
+    }
+
+    if (auto it = m_kept.find(node->myname); it != m_kept.end()) {
+        auto kept = it->second;
+        lck.unlock();
+        node->outputs.clear();
+        for (auto const &[key, obj]: kept) {
+            node->outputs.emplace(key, keepCopy(obj));
+        }
+        return false;
+    }
+
+    if (auto parent = tls_applying; parent && parent->graph == node->graph) {
+        bool bound = false;
+        for (auto const &[ds, bound_]: parent->inputBounds) {
+            if (bound_.first == node->myname) {
+                bound = true;
+                break;
+            }
+        }
+        if (!bound)
+            m_hiddenDeps[parent->myname].insert(node->myname);
+    }
+    m_hiddenDeps.erase(node->myname);
+    lck.unlock();
+
+    scope_exit restore{[parent = tls_applying] {
+        tls_applying = parent;
+    }};
+    tls_applying = node;
+    applyAndTrack();
+
+    std::map<std::string, zany> kept;
+    for (auto const &[key, obj]: node->outputs) {
+        auto copy = keepCopy(obj);
+        if (obj && !copy)
+            return true;  // some object can't be cloned, always re-apply this node
+        kept.emplace(key, std::move(copy));
+    }
+    lck.lock();
+    m_kept[node->myname] = std::move(kept);
+    m_touched.erase(node->myname);  // the next pass restores it rather than applying it again
+    return true;
+}
+
+}
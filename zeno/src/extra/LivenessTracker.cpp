@@ -0,0 +1,140 @@
+#include <zeno/extra/LivenessTracker.h>
+#include <zeno/types/StringObject.h>
+#include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+#include <zeno/extra/ExecPlan.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/log.h>
+#include <vector>
+#ifdef _WIN32
+#include <zeno/utils/fuck_win.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace zeno {
+
+namespace {
+
+std::atomic<bool> g_budgetWarned{false};
+
+// nodes whose name ends with ident, the way preApplyRefs in ZenoFX looks them up
+void collectRefTargets(Graph *graph, std::string const &code, std::vector<INode *> &targets) {
+    for (auto i = code.find("ref("); i != std::string::npos; i = code.find("ref(", i + 4)) {
+        auto iend = code.find('/', i);
+        if (iend == std::string::npos)
+            break;
+        auto ident = code.substr(i + 4, iend - i - 4);
+        for (auto const &[id, node]: graph->nodes) {
+            if (id.length() >= ident.length() &&
+                id.compare(id.length() - ident.length(), ident.length(), ident) == 0) {
+                targets.push_back(node.get());
+                break;
+            }
+        }
+    }
+}
+
+}
+
+ZENO_API LivenessTracker::LivenessTracker(Graph *graph, std::set<std::string> const &ids)
+    : graph(graph)
+    , m_budget(std::size_t(envconfig::getInt("MEMORY_BUDGET_MB", 0)) << 20)
+{
+    auto plan = graph->getExecPlan();
+    for (auto const &id: ids) {
+        if (auto it = graph->nodes.find(id); it != graph->nodes.end())
+            m_pinned.insert(it->second.get());
+    }
+
+    std::vector<INode *> refTargets;
+    std::vector<INode *> stack;
+    for (auto const &[id, node]: graph->nodes) {
+        if (node->hasLazyInputs())
+            stack.push_back(node.get());
+        // not only formulas: wrangles get their code as a plain string input and resolve ref() in apply()
+        for (auto const &[key, obj]: node->inputs) {
+            if (auto code = dynamic_cast<StringObject *>(obj.get()))
+                collectRefTargets(graph, code->get(), refTargets);
+        }
+    }
+
+    // a ref() to a linked input pulls it again from the producer
+    for (auto *node: refTargets) {
+        m_pinned.insert(node);
+        for (auto const &in: *plan->inputsOf(node)) {
+            if (in.src)
+                m_pinned.insert(in.src);
+        }
+    }
+
+    std::unordered_set<INode *> upstream;
+    while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        if (!upstream.insert(node).second)
+            continue;
+        m_pinned.insert(node);
+        for (auto const &in: *plan->inputsOf(node)) {
+            if (in.src)
+                stack.push_back(in.src);
+        }
+    }
+
+    for (auto const &slot: plan->slots) {
+        for (auto const &in: slot.inputs) {
+            if (in.src && !m_pinned.count(in.src))
+                m_pending.try_emplace(in.src, 0).first->second++;
+        }
+    }
+}
+
+ZENO_API LivenessTracker::~LivenessTracker() = default;
+
+ZENO_API void LivenessTracker::notePulled(INode *src) {
+    auto it = m_pending.find(src);
+    if (it == m_pending.end() || it->second.fetch_sub(1) != 1)
+        return;
+    log_trace("releasing outputs of {}", src->myname);
+    // keys stay, sockets added by Graph::addNodeOutput are what e.g. ExtractDict extracts
+    for (auto &[key, val]: src->outputs)
+        val = nullptr;
+}
+
+ZENO_API void LivenessTracker::noteApplied(INode *node) {
+    if (!m_pinned.count(node)) {
+        for (auto const &[ds, bound]: node->inputBounds) {
+            node->inputs.erase(ds);
+        }
+    }
+    if (m_budget && !g_budgetWarned.load(std::memory_order_relaxed)) {
+        auto rss = residentBytes();
+        if (rss > m_budget && !g_budgetWarned.exchange(true)) {
+            log_warn("memory budget of {} MB exceeded after applying {}: {} MB resident",
+                     m_budget >> 20, node->myname, rss >> 20);
+        }
+    }
+}
+
+ZENO_API std::size_t LivenessTracker::residentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.WorkingSetSize;
+    return 0;
+#elif defined(__linux__)
+    std::size_t size = 0, resident = 0;
+    if (FILE *fp = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(fp, "%zu %zu", &size, &resident) != 2)
+            resident = 0;
+        std::fclose(fp);
+    }
+    return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+}
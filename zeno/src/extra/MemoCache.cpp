@@ -0,0 +1,306 @@
+#include <zeno/extra/MemoCache.h>
+#include <zeno/core/INode.h>
+#include <zeno/core/Session.h>
+#include <zeno/funcs/ObjectCodec.h>
+#include <zeno/types/StringObject.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/scope_exit.h>
+#include <zeno/utils/log.h>
+#include <string_view>
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+
+namespace zeno {
+
+namespace {
+
+// number of session accesses made by the node being applied on this thread
+thread_local int tls_sessionAccess = 0;
+
+MemoCache::Key hashBytes(std::string_view bytes) {
+    return std::hash<std::string_view>{}(bytes);
+}
+
+MemoCache::Key hashCombine(MemoCache::Key seed, MemoCache::Key value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+}
+
+ZENO_API MemoCache::MemoCache()
+    : m_budget(std::size_t(envconfig::getInt("MEMOIZE_MB", 1024)) << 20)
+    , m_spillDir(envconfig::getStr("MEMOIZE_DIR"))
+    , m_enabled(envconfig::getBool("MEMOIZE"))
+{}
+
+ZENO_API MemoCache::~MemoCache() {
+    // entries still in memory are worth keeping for the next run as well
+    if (!m_spillDir.empty()) {
+        for (auto const &entry: m_lru) {
+            spill(entry);
+        }
+    }
+}
+
+ZENO_API void MemoCache::setEnabled(bool enabled) {
+    m_enabled = enabled;
+}
+
+ZENO_API void MemoCache::setBudget(std::size_t bytes) {
+    std::lock_guard lck(m_mtx);
+    m_budget = bytes;
+    evict();
+}
+
+ZENO_API void MemoCache::setSpillDir(std::string dir) {
+    std::lock_guard lck(m_mtx);
+    m_spillDir = std::move(dir);
+}
+
+ZENO_API void MemoCache::clear() {
+    std::lock_guard lck(m_mtx);
+    m_lru.clear();
+    m_lut.clear();
+    m_objKeys.clear();
+    m_bytes = 0;
+}
+
+ZENO_API void MemoCache::noteSessionAccess() {
+    tls_sessionAccess++;
+}
+
+ZENO_API int MemoCache::sessionAccesses() {
+    return tls_sessionAccess;
+}
+
+ZENO_API MemoCache::Key MemoCache::fileStamp(IObject const *obj) {
+    auto str = dynamic_cast<StringObject const *>(obj);
+    if (!str || str->get().empty())
+        return 0;
+    std::error_code ec;
+    std::filesystem::path path(str->get());
+    if (!std::filesystem::is_regular_file(path, ec))
+        return 0;
+    auto size = std::filesystem::file_size(path, ec);
+    auto mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return hashCombine(hashCombine(1, Key(size)), Key(mtime));
+}
+
+void MemoCache::remember(zany const &obj, Key hash) {
+    if (!obj)
+        return;
+    if (m_objKeys.size() >= m_objKeysPruneAt) {
+        for (auto it = m_objKeys.begin(); it != m_objKeys.end();) {
+            if (it->second.first.expired())
+                it = m_objKeys.erase(it);
+            else
+                ++it;
+        }
+        m_objKeysPruneAt = std::max<std::size_t>(1024, m_objKeys.size() * 2);
+    }
+    m_objKeys[obj.get()] = {obj, hash};
+}
+
+void MemoCache::forget(INode *node) {
+    // an unmemoized node may have modified its inputs in place, or passed them on as outputs
+    std::lock_guard lck(m_mtx);
+    for (auto const &[name, obj]: node->inputs)
+        m_objKeys.erase(obj.get());
+    for (auto const &[socket, obj]: node->outputs)
+        m_objKeys.erase(obj.get());
+}
+
+bool MemoCache::hashInput(zany const &obj, Key &hash) {
+    if (!obj) {
+        hash = 0;
+        return true;
+    }
+    {
+        std::lock_guard lck(m_mtx);
+        // a stale pointer left by a freed object fails the weak_ptr check
+        if (auto it = m_objKeys.find(obj.get()); it != m_objKeys.end() && it->second.first.lock() == obj) {
+            hash = it->second.second;
+            return true;
+        }
+    }
+    std::vector<char> buf;
+    if (!canEncodeObject(obj.get()) || !encodeObject(obj.get(), buf))
+        return false;
+    hash = hashBytes({buf.data(), buf.size()});
+    // file readers must run again when the file they read is modified
+    if (auto stamp = fileStamp(obj.get()))
+        hash = hashCombine(hash, stamp);
+    return true;
+}
+
+bool MemoCache::makeKey(INode *node, Key &key) {
+    if (!node->isMemoizable() || node->hasLazyInputs() || !node->kframes.empty() || !node->formulas.empty())
+        return false;
+    auto const &clsname = node->nodeClass ? node->nodeClass->classname : std::string();
+    if (clsname.empty())
+        return false;  // e.g. subnet nodes, whose behavior is not told by their class
+    key = hashBytes(clsname);
+    for (auto const &[name, obj]: node->inputs) {
+        Key hash;
+        if (!hashInput(obj, hash))
+            return false;
+        key = hashCombine(hashCombine(key, hashBytes(name)), hash);
+    }
+    return true;
+}
+
+bool MemoCache::loadSpilled(Key key, Entry &entry) const {
+    if (m_spillDir.empty())
+        return false;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.zmemo", (unsigned long long)key);
+    std::ifstream fin(std::filesystem::path(m_spillDir) / name, std::ios::binary);
+    if (!fin)
+        return false;
+    std::size_t count = 0;
+    fin.read((char *)&count, sizeof(count));
+    for (std::size_t i = 0; i < count && fin; i++) {
+        std::size_t namelen = 0, buflen = 0;
+        fin.read((char *)&namelen, sizeof(namelen));
+        std::string socket(namelen, '\0');
+        fin.read(socket.data(), namelen);
+        fin.read((char *)&buflen, sizeof(buflen));
+        std::vector<char> buf(buflen);
+        fin.read(buf.data(), buflen);
+        entry.bytes += buflen;
+        entry.outputs.emplace(std::move(socket), std::move(buf));
+    }
+    if (!fin) {
+        log_warn("corrupted memo cache file {}, ignored", name);
+        return false;
+    }
+    entry.key = key;
+    return true;
+}
+
+void MemoCache::spill(Entry const &entry) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.zmemo", (unsigned long long)entry.key);
+    std::error_code ec;
+    std::filesystem::create_directories(m_spillDir, ec);
+    auto path = std::filesystem::path(m_spillDir) / name;
+    if (std::filesystem::exists(path, ec))
+        return;  // same key, same content
+    std::ofstream fout(path, std::ios::binary);
+    std::size_t count = entry.outputs.size();
+    fout.write((char const *)&count, sizeof(count));
+    for (auto const &[socket, buf]: entry.outputs) {
+        std::size_t namelen = socket.size(), buflen = buf.size();
+        fout.write((char const *)&namelen, sizeof(namelen));
+        fout.write(socket.data(), namelen);
+        fout.write((char const *)&buflen, sizeof(buflen));
+        fout.write(buf.data(), buflen);
+    }
+    if (!fout)
+        log_warn("failed to write memo cache file {}", path.string());
+}
+
+void MemoCache::evict() {
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        auto &entry = m_lru.back();
+        if (!m_spillDir.empty())
+            spill(entry);
+        m_bytes -= entry.bytes;
+        m_lut.erase(entry.key);
+        m_lru.pop_back();
+    }
+}
+
+void MemoCache::store(Entry entry) {
+    if (entry.bytes > m_budget) {
+        if (!m_spillDir.empty())
+            spill(entry);
+        return;
+    }
+    if (auto it = m_lut.find(entry.key); it != m_lut.end()) {
+        m_bytes -= it->second->bytes;
+        m_lru.erase(it->second);
+    }
+    m_bytes += entry.bytes;
+    m_lru.push_front(std::move(entry));
+    m_lut[m_lru.front().key] = m_lru.begin();
+    evict();
+}
+
+bool MemoCache::restore(INode *node, Key key) {
+    Entry spilled;
+    std::map<std::string, std::vector<char>> const *outputs = nullptr;
+    std::unique_lock lck(m_mtx);
+    if (auto it = m_lut.find(key); it != m_lut.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        outputs = &it->second->outputs;
+    } else {
+        lck.unlock();
+        if (!loadSpilled(key, spilled))
+            return false;
+        lck.lock();
+        outputs = &spilled.outputs;
+    }
+
+    // decode everything first, the node must be left untouched on failure
+    std::map<std::string, zany> decoded;
+    for (auto const &[socket, buf]: *outputs) {
+        zany obj;
+        if (!buf.empty() && !(obj = decodeObject(buf.data(), buf.size())))
+            return false;
+        decoded.emplace(socket, std::move(obj));
+    }
+    for (auto const &[socket, obj]: decoded) {
+        remember(obj, hashCombine(key, hashBytes(socket)));
+    }
+    if (outputs == &spilled.outputs)
+        store(std::move(spilled));
+    lck.unlock();
+
+    node->outputs = std::move(decoded);
+    return true;
+}
+
+ZENO_API bool MemoCache::applyNode(INode *node, std::function<void()> const &apply) {
+    Key key;
+    if (!makeKey(node, key)) {
+        apply();
+        forget(node);
+        return true;
+    }
+    if (restore(node, key)) {
+        log_debug("==> reuse {}", node->myname);
+        return false;
+    }
+
+    auto saved = std::exchange(tls_sessionAccess, 0);
+    scope_exit restoreAccess{[&] {
+        tls_sessionAccess += saved;  // an impure child taints its caller as well
+    }};
+    apply();
+    if (tls_sessionAccess) {
+        forget(node);
+        return true;
+    }
+
+    Entry entry;
+    entry.key = key;
+    for (auto const &[socket, obj]: node->outputs) {
+        std::vector<char> buf;
+        if (obj && (!canEncodeObject(obj.get()) || !encodeObject(obj.get(), buf))) {
+            forget(node);
+            return true;  // some object can't be encoded, always re-apply this node
+        }
+        entry.bytes += buf.size();
+        entry.outputs.emplace(socket, std::move(buf));
+    }
+    std::lock_guard lck(m_mtx);
+    for (auto const &[socket, obj]: node->outputs) {
+        remember(obj, hashCombine(key, hashBytes(socket)));
+    }
+    store(std::move(entry));
+    return true;
+}
+
+}
@@ -0,0 +1,241 @@
+#include <zeno/extra/ParallelExecutor.h>
+#include <zeno/extra/DirtyChecker.h>
+#include <zeno/extra/IncrementalCache.h>
+#include <zeno/extra/ContextManaged.h>
+#include <zeno/para/thread_pool.h>
+#include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+#include <zeno/utils/scope_exit.h>
+#include <zeno/utils/safe_at.h>
+#include <zeno/utils/log.h>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+
+namespace zeno {
+
+ZENO_API ParallelExecutor::ParallelExecutor(Graph *graph)
+    : graph(graph), pool(thread_pool::global())
+{}
+
+ZENO_API ParallelExecutor::~ParallelExecutor() = default;
+
+bool ParallelExecutor::isDirty(std::string const &id) const {
+    return graph->dirtyChecker && graph->dirtyChecker->amIDirty(id);
+}
+
+void ParallelExecutor::runSlot(Slot &slot) {
+    try {
+        auto apply = [&] {
+            GraphException::translated([&] {
+                slot.node->doApply();
+            }, slot.node->myname);
+        };
+        if (graph->incrementalCache)
+            graph->incrementalCache->applyNode(slot.node, apply);
+        else
+            apply();
+    } catch (GraphException const &ge) {
+        slot.error = std::make_unique<GraphException>(ge);
+    }
+    slot.state.store(Done);
+    pool.notify_waiters();
+}
+
+bool ParallelExecutor::claimAndRun(Slot &slot) {
+    int expected = Pending;
+    if (slot.state.compare_exchange_strong(expected, Running)) {
+        runSlot(slot);
+        return true;
+    }
+    // someone else is evaluating it, help the pool instead of blocking
+    pool.wait_until([&] {
+        return slot.state.load() == Done;
+    });
+    return false;
+}
+
+void ParallelExecutor::markFailed(std::size_t order) {
+    std::size_t old = m_failorder.load();
+    while (order < old && !m_failorder.compare_exchange_weak(old, order));
+}
+
+void ParallelExecutor::schedule(Slot *slot) {
+    pool.submit([this, slot] {
+        // nodes after a failed one in serial order would never have been reached
+        if (slot->order < m_failorder.load()) {
+            claimAndRun(*slot);
+            if (slot->error) {
+                markFailed(slot->order);
+            } else if (isDirty(slot->node->myname)) {
+                for (auto *cons: slot->consumers) {
+                    graph->dirtyChecker->taintThisNode(cons->node->myname);
+                }
+            }
+        }
+        for (auto *cons: slot->consumers) {
+            if (cons->npending.fetch_sub(1) == 1)
+                schedule(cons);
+        }
+        // execute() may return and destroy *this as soon as the count drops to zero
+        auto &pool = this->pool;
+        if (m_nremain.fetch_sub(1) == 1)
+            pool.notify_waiters();
+    });
+}
+
+ZENO_API bool ParallelExecutor::applyNode(std::string const &id) {
+    Slot *slot = nullptr;
+    if (auto it = m_lut.find(id); it != m_lut.end()) {
+        slot = it->second;
+    } else {
+        // evaluated in the serial phase, or only reachable via hidden deps (e.g. PortalOut)
+        std::lock_guard lck(m_mtx);
+        auto node = safe_at(graph->nodes, id, "node name").get();
+        if (node->execIndex >= 0 && graph->ctx->isVisited(node->execIndex))
+            return false;
+        auto [uit, inserted] = m_unplanned.try_emplace(id);
+        slot = &uit->second;
+        if (inserted) {
+            slot->node = node;
+            slot->order = static_cast<std::size_t>(-1);
+        }
+    }
+    bool ran = claimAndRun(*slot);
+    if (slot->error)
+        throw *slot->error;
+    return ran && isDirty(id);
+}
+
+ZENO_API void ParallelExecutor::execute(std::set<std::string> const &ids) {
+    // serial depth-first order, visiting inputBounds the way INode::preApply does
+    std::vector<INode *> order;
+    std::vector<std::vector<std::size_t>> deps;
+    std::unordered_map<INode *, std::size_t> index;
+    std::unordered_set<INode *> onstack;
+
+    std::function<void(INode *)> visit = [&] (INode *node) {
+        if (index.count(node) || onstack.count(node))
+            return;
+        onstack.insert(node);
+        std::vector<std::size_t> nodeDeps;
+        for (auto const &[ds, bound]: node->inputBounds) {
+            // kept outputs are restored without pulling any input
+            if (graph->incrementalCache && graph->incrementalCache->isReusable(node->myname))
+                break;
+            auto it = graph->nodes.find(bound.first);
+            if (it == graph->nodes.end())
+                continue;  // requireInput will report it when the node runs
+            visit(it->second.get());
+            // back edges of a cycle are dropped, just like the visited check does
+            if (auto dit = index.find(it->second.get()); dit != index.end())
+                nodeDeps.push_back(dit->second);
+        }
+        std::sort(nodeDeps.begin(), nodeDeps.end());
+        nodeDeps.erase(std::unique(nodeDeps.begin(), nodeDeps.end()), nodeDeps.end());
+        onstack.erase(node);
+        index.emplace(node, order.size());
+        order.push_back(node);
+        deps.push_back(std::move(nodeDeps));
+    };
+    std::vector<std::size_t> targets;
+    for (auto const &id: ids) {
+        auto node = safe_at(graph->nodes, id, "node name").get();
+        visit(node);
+        targets.push_back(index.at(node));
+    }
+
+    // functions evaluate their body again with push_context on each call, so whatever may
+    // call one (directly or through objects derived from it) must run serial as well
+    std::vector<char> serial(order.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        for (auto d: deps[i]) {
+            auto cm = dynamic_cast<ContextManagedNode *>(order[d]);
+            if (serial[d] || (cm && cm->hasReentrantOutputs())) {
+                serial[i] = 1;
+                break;
+            }
+        }
+    }
+
+    // lazy nodes decide themselves which inputs to pull, keep them and their upstream serial
+    for (std::size_t i = order.size(); i-- > 0;) {
+        if (serial[i] || order[i]->hasLazyInputs()) {
+            serial[i] = 1;
+            for (auto d: deps[i])
+                serial[d] = 1;
+        }
+    }
+
+    std::vector<char> root(order.size());
+    for (auto i: targets) {
+        if (serial[i])
+            root[i] = 1;
+    }
+    for (std::size_t i = 0; i < order.size(); i++) {
+        if (serial[i])
+            continue;
+        for (auto d: deps[i]) {
+            if (serial[d])
+                root[d] = 1;
+        }
+    }
+    for (std::size_t i = 0; i < order.size(); i++) {
+        if (root[i])
+            graph->applyNode(order[i]->myname);
+    }
+
+    std::vector<Slot *> slotOf(order.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        if (serial[i])
+            continue;
+        auto &slot = m_slots.emplace_back();
+        slot.node = order[i];
+        slot.order = i;
+        slotOf[i] = &slot;
+        m_lut.emplace(order[i]->myname, &slot);
+    }
+    if (m_slots.empty())
+        return;
+    log_debug("parallel executor: {} serial nodes, {} scheduled nodes",
+              order.size() - m_slots.size(), m_slots.size());
+
+    for (std::size_t i = 0; i < order.size(); i++) {
+        auto *slot = slotOf[i];
+        if (!slot)
+            continue;
+        for (auto d: deps[i]) {
+            if (auto *dep = slotOf[d]) {
+                dep->consumers.push_back(slot);
+                slot->npending.fetch_add(1);
+            } else if (isDirty(order[d]->myname)) {
+                graph->dirtyChecker->taintThisNode(slot->node->myname);
+            }
+        }
+    }
+
+    graph->executor = this;
+    scope_exit _{[&] {
+        graph->executor = nullptr;
+    }};
+
+    // collect the ready slots first, workers start decrementing npending right away
+    std::vector<Slot *> ready;
+    for (auto &slot: m_slots) {
+        if (!slot.npending.load())
+            ready.push_back(&slot);
+    }
+    m_nremain.store(m_slots.size());
+    for (auto *slot: ready) {
+        schedule(slot);
+    }
+    pool.wait_until([&] {
+        return m_nremain.load() == 0;
+    });
+
+    if (auto failorder = m_failorder.load(); failorder != static_cast<std::size_t>(-1)) {
+        throw *slotOf[failorder]->error;
+    }
+}
+
+}
@@ -0,0 +1,239 @@
+#include <zeno/extra/Profiler.h>
+#include <zeno/utils/envconfig.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#ifdef ZENO_PROFILE_ALLOC
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace zeno {
+
+namespace {
+
+struct Event {
+    const char *cat;
+    std::string name;
+    std::int64_t beg;
+    std::int64_t dur;
+    std::size_t bytes;
+};
+
+struct ThreadBuffer {
+    std::mutex mtx;  // only contended while exporting
+    std::vector<Event> events;
+    std::uint32_t tid = 0;
+};
+
+struct Registry {
+    std::mutex mtx;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;  // kept after their thread exits
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+Registry &registry() {
+    static auto reg = new Registry;  // leaked, threads may still record during static destruction
+    return *reg;
+}
+
+std::atomic<bool> g_enabled{envconfig::getBool("PROFILE")};
+
+thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+thread_local Profiler::Span *t_current = nullptr;
+
+#ifdef ZENO_PROFILE_ALLOC
+thread_local std::size_t t_allocated = 0;  // trivial, so usable from operator new at any time
+#endif
+
+std::size_t allocatedBytes() {
+#ifdef ZENO_PROFILE_ALLOC
+    return t_allocated;
+#else
+    return 0;
+#endif
+}
+
+std::int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+ThreadBuffer &threadBuffer() {
+    if (!t_buffer) {
+        t_buffer = std::make_shared<ThreadBuffer>();
+        auto &reg = registry();
+        std::lock_guard lck(reg.mtx);
+        t_buffer->tid = static_cast<std::uint32_t>(reg.buffers.size());
+        reg.buffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+}
+
+// copy of every event, so that no thread buffer is locked while formatting
+std::vector<std::pair<std::uint32_t, Event>> snapshot() {
+    std::vector<std::pair<std::uint32_t, Event>> res;
+    auto &reg = registry();
+    std::lock_guard lck(reg.mtx);
+    for (auto const &buf: reg.buffers) {
+        std::lock_guard blck(buf->mtx);
+        for (auto const &ev: buf->events)
+            res.emplace_back(buf->tid, ev);
+    }
+    return res;
+}
+
+}
+
+ZENO_API Profiler::Span::Span(const char *cat, std::string_view name) : m_cat(cat) {
+    if (!g_enabled.load(std::memory_order_relaxed))
+        return;
+    m_name = name;
+    m_parent = t_current;
+    t_current = this;
+    m_bytes = allocatedBytes();
+    m_beg = now();
+}
+
+ZENO_API Profiler::Span::~Span() {
+    if (m_beg < 0)
+        return;
+    auto end = now();
+    t_current = m_parent;
+    auto bytes = allocatedBytes() - m_bytes;
+    auto &buf = threadBuffer();
+    std::lock_guard lck(buf.mtx);
+    buf.events.push_back({m_cat, std::move(m_name), m_beg, end - m_beg, bytes});
+}
+
+ZENO_API bool Profiler::enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+ZENO_API void Profiler::setEnabled(bool on) {
+    g_enabled.store(on, std::memory_order_relaxed);
+}
+
+ZENO_API void Profiler::clear() {
+    auto &reg = registry();
+    std::lock_guard lck(reg.mtx);
+    for (auto const &buf: reg.buffers) {
+        std::lock_guard blck(buf->mtx);
+        buf->events.clear();
+    }
+}
+
+ZENO_API std::string Profiler::currentSpan() {
+    return t_current ? t_current->m_name : std::string();
+}
+
+ZENO_API std::string Profiler::traceJson() {
+    auto events = snapshot();
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartObject();
+    writer.Key("traceEvents");
+    writer.StartArray();
+    for (auto const &[tid, ev]: events) {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(ev.name.data(), static_cast<rapidjson::SizeType>(ev.name.size()));
+        writer.Key("cat");
+        writer.String(ev.cat);
+        writer.Key("ph");
+        writer.String("X");
+        writer.Key("pid");
+        writer.Int(0);
+        writer.Key("tid");
+        writer.Uint(tid);
+        writer.Key("ts");  // microseconds
+        writer.Double(ev.beg * 1e-3);
+        writer.Key("dur");
+        writer.Double(ev.dur * 1e-3);
+        if (ev.bytes) {
+            writer.Key("args");
+            writer.StartObject();
+            writer.Key("bytes");
+            writer.Uint64(ev.bytes);
+            writer.EndObject();
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.Key("displayTimeUnit");
+    writer.String("ms");
+    writer.EndObject();
+    return {sb.GetString(), sb.GetSize()};
+}
+
+ZENO_API bool Profiler::writeTrace(std::string const &path) {
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout)
+        return false;
+    auto json = traceJson();
+    fout.write(json.data(), json.size());
+    return !!fout;
+}
+
+ZENO_API std::vector<Profiler::NodeStat> Profiler::nodeStats() {
+    std::unordered_map<std::string, NodeStat> stats;
+    for (auto const &[tid, ev]: snapshot()) {
+        if (std::string_view(ev.cat) != "node")
+            continue;
+        auto &st = stats[ev.name];
+        double ms = ev.dur * 1e-6;
+        st.count++;
+        st.totalMs += ms;
+        st.maxMs = std::max(st.maxMs, ms);
+        st.bytes += ev.bytes;
+    }
+    std::vector<NodeStat> res;
+    res.reserve(stats.size());
+    for (auto &[name, st]: stats) {
+        st.name = name;
+        res.push_back(std::move(st));
+    }
+    std::sort(res.begin(), res.end(), [] (NodeStat const &lhs, NodeStat const &rhs) {
+        return lhs.totalMs > rhs.totalMs;
+    });
+    return res;
+}
+
+}
+
+#ifdef ZENO_PROFILE_ALLOC
+// only counts, the aligned forms are left alone (and uncounted); on Windows this
+// replacement is local to the zeno DLL
+void *operator new(std::size_t n) {
+    zeno::t_allocated += n;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t n) {
+    return ::operator new(n);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
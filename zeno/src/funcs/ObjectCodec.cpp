@@ -11,6 +11,7 @@
 #include <zeno/types/UserData.h>
 #include <zeno/utils/log.h>
 #include <algorithm>
+#include <typeinfo>
 #include <cstring>
 
 namespace zeno {
@@ -39,7 +40,7 @@ namespace _implObjectCodec {
 
 #define _PER_OBJECT_TYPE(TypeName, ...) \
 std::shared_ptr<TypeName> decode##TypeName(const char *it); \
-bool encode##TypeName(TypeName const *obj, std::back_insert_iterator<std::vector<char>> it);
+bool encode##TypeName(TypeName const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &opts);
 ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
 #undef _PER_OBJECT_TYPE
 
@@ -77,6 +78,8 @@ std::shared_ptr<IObject> decodeObject(const char *buf, size_t len) {
     }
 
     auto object = _decodeObjectImpl(buf, len);
+    if (!object)
+        return nullptr;
 
     auto ptr = buf + header.beginUserData;
     for (int i = 0; i < header.numUserData; i++) {
@@ -100,7 +103,7 @@ std::shared_ptr<IObject> decodeObject(const char *buf, size_t len) {
     return object;
 }
 
-static bool _encodeObjectImpl(IObject const *object, std::vector<char> &buf) {
+static bool _encodeObjectImpl(IObject const *object, std::vector<char> &buf, ObjectCodecOptions const &opts) {
     auto it = std::back_inserter(buf);
     ObjectHeader header;
     header.magicNumber = ObjectHeader::kMagicNumber;
@@ -111,7 +114,7 @@ static bool _encodeObjectImpl(IObject const *object, std::vector<char> &buf) {
     } else if (auto obj = dynamic_cast<TypeName const *>(object)) { \
         header.type = ObjectType::TypeName; \
         it = std::copy_n((char *)&header, sizeof(ObjectHeader), it); \
-        return encode##TypeName(obj, it);
+        return encode##TypeName(obj, it, opts);
 ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
 #undef _PER_OBJECT_TYPE
 
@@ -121,9 +124,36 @@ ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
     }
 }
 
-bool encodeObject(IObject const *object, std::vector<char> &buf) {
+bool canEncodeObject(IObject const *object) {
+    if (!object)
+        return false;
+    // a subclass would be decoded as its base, losing its own members
+    bool known = false;
+#define _PER_OBJECT_TYPE(TypeName, ...) \
+    known = known || typeid(*object) == typeid(TypeName);
+ZENO_XMACRO_IObject(_PER_OBJECT_TYPE)
+#undef _PER_OBJECT_TYPE
+    if (!known)
+        return false;
+    if (auto lst = dynamic_cast<ListObject const *>(object)) {
+        for (auto const &elm: lst->arr) {
+            if (!canEncodeObject(elm.get()))
+                return false;
+        }
+    } else if (auto prim = dynamic_cast<PrimitiveObject const *>(object)) {
+        if (prim->inst)
+            return false;  // not encoded by encodePrimitiveObject
+    }
+    for (auto const &[key, val]: object->userData()) {
+        if (!canEncodeObject(val.get()))
+            return false;
+    }
+    return true;
+}
+
+bool encodeObject(IObject const *object, std::vector<char> &buf, ObjectCodecOptions const &opts) {
     auto oldsize = buf.size();
-    if (!_encodeObjectImpl(object, buf))
+    if (!_encodeObjectImpl(object, buf, opts))
         return false;
 
     std::vector<std::vector<char>> valbufs;
@@ -132,7 +162,7 @@ bool encodeObject(IObject const *object, std::vector<char> &buf) {
         size_t keysize = key.size();
         valbuf.insert(valbuf.end(), (char *)&keysize, (char *)(&keysize + 1));
         valbuf.insert(valbuf.end(), key.begin(), key.end());
-        if (encodeObject(val.get(), valbuf))
+        if (encodeObject(val.get(), valbuf, opts))
             valbufs.push_back(std::move(valbuf));
     }
     auto &header = *(ObjectHeader *)(buf.data() + oldsize);
@@ -29,8 +29,8 @@ std::shared_ptr<ListObject> decodeListObject(const char *it) {
     return obj;
 }
 
-bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
+bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &opts);
+bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &opts) {
     size_t size = obj->arr.size();
     std::copy_n((char const *)&size, sizeof(size), it);
 
@@ -40,7 +40,7 @@ bool encodeListObject(ListObject const *obj, std::back_insert_iterator<std::vect
     size_t base = 0;
     for (size_t i = 0; i < size; i++) {
         auto const *elm = obj->arr[i].get();
-        if (!encodeObject(elm, buf))
+        if (!encodeObject(elm, buf, opts))
             return false;
         size_t len = buf.size();
         fin.insert(fin.end(), buf.begin(), buf.end());
@@ -4,8 +4,12 @@
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/log.h>
 //#include <zeno/utils/zeno_p.h>
+#include <zeno/para/parallel_for.h>
+#include <functional>
 #include <algorithm>
 #include <cstring>
+#include <atomic>
+#include <cmath>
 namespace zeno {
 
 namespace _implObjectCodec {
@@ -20,15 +24,292 @@ struct AttributeHeader {
 };
 
 struct AttrVectorHeader {
+    // set in nattrs when every array below is written as a compressed stream
+    static constexpr size_t kCompressed = size_t(1) << (sizeof(size_t) * 8 - 1);
+
     size_t size;
     size_t nattrs;
 };
 
+/* All attribute types are made of 4-byte ints or floats, so a compressed stream
+ * is a sequence of 4-byte words, ncomps of them per element. */
+enum class StreamCodec : uint32_t {
+    Raw,
+    ShuffleLZ,    // byte planes of each word, then LZ77, for floats
+    DeltaVarint,  // delta to previous element, zigzag varint, for indices
+    Quantize,     // rounded to multiples of step, then as DeltaVarint, lossy
+};
+
+struct StreamHeader {
+    StreamCodec codec;
+    uint32_t ncomps;
+    size_t nbytes;
+    double step;
+};
+
+struct StreamJob {
+    char *data;
+    size_t nwords;
+    StreamHeader header;
+    const char *src;
+};
+
+// LZ77 with 64 KiB window, sequences laid out like LZ4 blocks (token, literals, offset, match)
+void lzCompress(const uint8_t *src, size_t n, std::vector<char> &out) {
+    constexpr int kHashBits = 14;
+    std::vector<uint32_t> table(1 << kHashBits);  // position + 1 of the last occurrence
+    auto read32 = [&] (size_t i) {
+        uint32_t v;
+        std::memcpy(&v, src + i, 4);
+        return v;
+    };
+    auto putLength = [&] (size_t len) {
+        for (; len >= 255; len -= 255)
+            out.push_back((char)255);
+        out.push_back((char)len);
+    };
+    auto putSequence = [&] (size_t anchor, size_t litlen, size_t offset, size_t mlen) {
+        size_t mcode = mlen ? mlen - 4 : 0;
+        out.push_back((char)((std::min<size_t>(litlen, 15) << 4) | std::min<size_t>(mcode, 15)));
+        if (litlen >= 15)
+            putLength(litlen - 15);
+        out.insert(out.end(), src + anchor, src + anchor + litlen);
+        if (!mlen)
+            return;
+        out.push_back((char)(offset & 0xff));
+        out.push_back((char)(offset >> 8));
+        if (mcode >= 15)
+            putLength(mcode - 15);
+    };
+
+    size_t anchor = 0, i = 0, misses = 0;
+    while (n >= 4 && i <= n - 4) {
+        uint32_t h = (read32(i) * 2654435761u) >> (32 - kHashBits);
+        size_t ref = table[h];
+        table[h] = uint32_t(i + 1);
+        if (ref-- && i - ref <= 65535 && read32(ref) == read32(i)) {
+            size_t mlen = 4;
+            while (i + mlen < n && src[ref + mlen] == src[i + mlen])
+                mlen++;
+            putSequence(anchor, i - anchor, i - ref, mlen);
+            i += mlen;
+            anchor = i;
+            misses = 0;
+        } else {
+            i += 1 + (misses++ >> 6);  // skip faster over incompressible data
+        }
+    }
+    putSequence(anchor, n - anchor, 0, 0);
+}
+
+bool lzDecompress(const uint8_t *ip, size_t nbytes, uint8_t *op, size_t n) {
+    const uint8_t *iend = ip + nbytes;
+    uint8_t *obeg = op, *oend = op + n;
+    auto getLength = [&] (size_t &len) {
+        uint8_t b;
+        do {
+            if (ip == iend)
+                return false;
+            len += b = *ip++;
+        } while (b == 255);
+        return true;
+    };
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t litlen = token >> 4;
+        if (litlen == 15 && !getLength(litlen))
+            return false;
+        if (litlen > size_t(iend - ip) || litlen > size_t(oend - op))
+            return false;
+        std::memcpy(op, ip, litlen);
+        ip += litlen;
+        op += litlen;
+        if (ip == iend)
+            break;
+        if (iend - ip < 2)
+            return false;
+        size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !getLength(mlen))
+            return false;
+        mlen += 4;
+        if (!offset || offset > size_t(op - obeg) || mlen > size_t(oend - op))
+            return false;
+        for (size_t k = 0; k < mlen; k++, op++)  // may overlap itself
+            *op = op[-(std::ptrdiff_t)offset];
+    }
+    return op == oend;
+}
+
+void putVarint(uint32_t v, std::vector<char> &out) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+void encodeDeltaVarint(const int32_t *src, size_t nwords, uint32_t ncomps, std::vector<char> &out) {
+    for (size_t i = 0; i < nwords; i++) {
+        int32_t prev = i >= ncomps ? src[i - ncomps] : 0;
+        uint32_t d = uint32_t(src[i]) - uint32_t(prev);  // wraps around on purpose
+        putVarint((d << 1) ^ uint32_t(-int32_t(d >> 31)), out);
+    }
+}
+
+bool decodeDeltaVarint(const uint8_t *ip, size_t nbytes, int32_t *dst, size_t nwords, uint32_t ncomps) {
+    const uint8_t *iend = ip + nbytes;
+    for (size_t i = 0; i < nwords; i++) {
+        uint32_t v = 0;
+        for (int shift = 0;; shift += 7) {
+            if (ip == iend || shift > 28)
+                return false;
+            uint8_t b = *ip++;
+            v |= uint32_t(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                break;
+        }
+        uint32_t d = (v >> 1) ^ uint32_t(-int32_t(v & 1));
+        uint32_t prev = i >= ncomps ? uint32_t(dst[i - ncomps]) : 0;
+        dst[i] = int32_t(prev + d);
+    }
+    return ip == iend;
+}
+
+void encodeStream(const char *data, size_t nwords, uint32_t ncomps, bool isInt, float quantizeError, std::vector<char> &out) {
+    StreamHeader header{StreamCodec::Raw, ncomps, 0, 0};
+    std::vector<char> body;
+    if (isInt) {
+        header.codec = StreamCodec::DeltaVarint;
+        encodeDeltaVarint((const int32_t *)data, nwords, ncomps, body);
+    } else {
+        bool quantized = false;
+        if (quantizeError > 0) {
+            double step = 2.0 * quantizeError * 0.99;  // leaves room for rounding back to float
+            std::vector<int32_t> q(nwords);
+            quantized = true;
+            for (size_t i = 0; i < nwords; i++) {
+                float x;
+                std::memcpy(&x, data + i * 4, 4);
+                double r = std::round(x / step);
+                if (!(std::abs(r) < double(1 << 30))) {  // also catches NaN and inf
+                    quantized = false;
+                    break;
+                }
+                q[i] = int32_t(r);
+            }
+            if (quantized) {
+                header.codec = StreamCodec::Quantize;
+                header.step = step;
+                encodeDeltaVarint(q.data(), nwords, ncomps, body);
+            }
+        }
+        if (!quantized) {
+            std::vector<uint8_t> planes(nwords * 4);
+            for (size_t i = 0; i < nwords; i++) {
+                for (int b = 0; b < 4; b++)
+                    planes[b * nwords + i] = data[i * 4 + b];
+            }
+            header.codec = StreamCodec::ShuffleLZ;
+            lzCompress(planes.data(), planes.size(), body);
+        }
+    }
+    if (body.size() >= nwords * 4) {
+        header.codec = StreamCodec::Raw;
+        body.assign(data, data + nwords * 4);
+    }
+    header.nbytes = body.size();
+    out.insert(out.end(), (char const *)&header, (char const *)(&header + 1));
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+bool decodeStream(StreamJob const &job) {
+    auto const &header = job.header;
+    auto src = (const uint8_t *)job.src;
+    switch (header.codec) {
+    case StreamCodec::Raw:
+        if (header.nbytes != job.nwords * 4)
+            return false;
+        std::memcpy(job.data, src, header.nbytes);
+        return true;
+    case StreamCodec::ShuffleLZ: {
+        std::vector<uint8_t> planes(job.nwords * 4);
+        if (!lzDecompress(src, header.nbytes, planes.data(), planes.size()))
+            return false;
+        for (size_t i = 0; i < job.nwords; i++) {
+            for (int b = 0; b < 4; b++)
+                job.data[i * 4 + b] = planes[b * job.nwords + i];
+        }
+        return true;
+    }
+    case StreamCodec::DeltaVarint:
+        return decodeDeltaVarint(src, header.nbytes, (int32_t *)job.data, job.nwords, header.ncomps);
+    case StreamCodec::Quantize: {
+        std::vector<int32_t> q(job.nwords);
+        if (!decodeDeltaVarint(src, header.nbytes, q.data(), job.nwords, header.ncomps))
+            return false;
+        for (size_t i = 0; i < job.nwords; i++) {
+            float x = float(q[i] * header.step);
+            std::memcpy(job.data + i * 4, &x, 4);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+template <class T>
+struct StreamTraits {
+    static constexpr uint32_t ncomps = 1;
+    static constexpr bool isInt = std::is_integral_v<T>;
+};
+
+template <size_t N, class T>
+struct StreamTraits<vec<N, T>> {
+    static constexpr uint32_t ncomps = N;
+    static constexpr bool isInt = std::is_integral_v<T>;
+};
+
+template <class T>
+void addStreamJob(std::vector<T> &arr, const char *&it, std::vector<StreamJob> &jobs) {
+    StreamJob job;
+    std::memcpy(&job.header, it, sizeof(StreamHeader));
+    it += sizeof(StreamHeader);
+    job.src = it;
+    it += job.header.nbytes;
+    job.data = (char *)arr.data();
+    job.nwords = arr.size() * StreamTraits<T>::ncomps;
+    jobs.push_back(job);
+}
+
 template <class T0, class It>
-void decodeAttrVector(AttrVector<T0> &arr, It &it) {
+void decodeAttrVector(AttrVector<T0> &arr, It &it, std::vector<StreamJob> &jobs) {
     AttrVectorHeader header;
     std::copy_n(it, sizeof(header), (char *)&header);
     it += sizeof(header);
+
+    if (header.nattrs & AttrVectorHeader::kCompressed) {
+        // streams are only located here, they get decoded later in parallel
+        header.nattrs &= ~AttrVectorHeader::kCompressed;
+        arr.values.resize(header.size);
+        addStreamJob(arr.values, it, jobs);
+        for (int a = 0; a < header.nattrs; a++) {
+            AttributeHeader h;
+            std::copy_n(it, sizeof(h), (char *)&h);
+            it += sizeof(h);
+            std::string key{h.name, h.namelen};
+            index_switch<std::variant_size_v<AttrAcceptAll>>((size_t)h.type, [&] (auto type) {
+                using T = std::variant_alternative_t<type.value, AttrAcceptAll>;
+                auto &attr = arr.template add_attr<T>(key);
+                attr.resize(h.size);
+                addStreamJob(attr, it, jobs);
+            });
+        }
+        return;
+    }
+
     arr.values.reserve(header.size);
     std::copy_n((T0 const *)it, header.size, std::back_inserter(arr.values));
     it += sizeof(T0) * header.size;
@@ -51,10 +332,48 @@ void decodeAttrVector(AttrVector<T0> &arr, It &it) {
 }
 
 template <class T0, class It>
-void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
+void encodeAttrVector(AttrVector<T0> const &arr, It &it, ObjectCodecOptions const &opts, bool isVerts = false) {
     AttrVectorHeader header;
     header.size = arr.size();
     header.nattrs = arr.template num_attrs<AttrAcceptAll>();
+
+    if (opts.compress) {
+        std::vector<std::vector<char>> chunks;  // attribute header (if any) and stream of each array
+        chunks.reserve(header.nattrs + 1);  // tasks refer to them
+        std::vector<std::function<void()>> tasks;
+        auto addArray = [&] (std::string const &key, auto const &vals, bool withHeader, bool lossy) {
+            using T = std::decay_t<decltype(vals[0])>;
+            auto &chunk = chunks.emplace_back();
+            if (withHeader) {
+                AttributeHeader h;
+                h.type = variant_index<AttrAcceptAll, T>::value;
+                h.size = vals.size();
+                h.namelen = key.size();
+                std::strncpy(h.name, key.c_str(), sizeof(h.name));
+                chunk.insert(chunk.end(), (char const *)&h, (char const *)(&h + 1));
+            }
+            float quantizeError = lossy ? opts.quantizeError : 0;
+            tasks.push_back([&chunk, &vals, quantizeError] {
+                encodeStream((const char *)vals.data(), vals.size() * StreamTraits<T>::ncomps,
+                             StreamTraits<T>::ncomps, StreamTraits<T>::isInt, quantizeError, chunk);
+            });
+        };
+        // only positions and velocities may be quantized, indices and uvs must stay exact
+        addArray("pos", arr.values, false, isVerts);
+        arr.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &attr) {
+            addArray(key, attr, true, isVerts && key == "vel");
+        });
+        parallel_for(tasks.size(), [&] (size_t i) {
+            tasks[i]();
+        });
+
+        header.nattrs |= AttrVectorHeader::kCompressed;
+        it = std::copy_n((char const *)&header, sizeof(header), it);
+        for (auto const &chunk: chunks)
+            it = std::copy(chunk.begin(), chunk.end(), it);
+        return;
+    }
+
     it = std::copy_n((char const *)&header, sizeof(header), it);
     it = std::copy_n((char const *)arr.data(), sizeof(T0) * arr.size(), it);
 
@@ -75,15 +394,36 @@ void encodeAttrVector(AttrVector<T0> const &arr, It &it) {
 std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it);
 std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it) {
     auto obj = std::make_shared<PrimitiveObject>();
-    decodeAttrVector(obj->verts, it);
-    decodeAttrVector(obj->points, it);
-    decodeAttrVector(obj->lines, it);
-    decodeAttrVector(obj->tris, it);
-    decodeAttrVector(obj->quads, it);
-    decodeAttrVector(obj->loops, it);
-    decodeAttrVector(obj->polys, it);
-    decodeAttrVector(obj->edges, it);
-    decodeAttrVector(obj->uvs, it);
+    std::vector<StreamJob> jobs;
+    decodeAttrVector(obj->verts, it, jobs);
+    decodeAttrVector(obj->points, it, jobs);
+    decodeAttrVector(obj->lines, it, jobs);
+    decodeAttrVector(obj->tris, it, jobs);
+    decodeAttrVector(obj->quads, it, jobs);
+    decodeAttrVector(obj->loops, it, jobs);
+    decodeAttrVector(obj->polys, it, jobs);
+    decodeAttrVector(obj->edges, it, jobs);
+    decodeAttrVector(obj->uvs, it, jobs);
+    if (!jobs.empty()) {
+        std::atomic<bool> ok{true};
+        parallel_for(jobs.size(), [&] (size_t i) {
+            if (!decodeStream(jobs[i]))
+                ok.store(false);
+        });
+        if (!ok.load()) {
+            log_error("corrupted primitive attribute stream");
+            return nullptr;
+        }
+        obj->verts.update();
+        obj->points.update();
+        obj->lines.update();
+        obj->tris.update();
+        obj->quads.update();
+        obj->loops.update();
+        obj->polys.update();
+        obj->edges.update();
+        obj->uvs.update();
+    }
     if (*it++ == '1') {
         obj->mtl = std::make_shared<MaterialObject>();
         obj->mtl->deserialize(it);
@@ -91,17 +431,17 @@ std::shared_ptr<PrimitiveObject> decodePrimitiveObject(const char *it) {
     return obj;
 }
 
-bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
-    encodeAttrVector(obj->verts, it);
-    encodeAttrVector(obj->points, it);
-    encodeAttrVector(obj->lines, it);
-    encodeAttrVector(obj->tris, it);
-    encodeAttrVector(obj->quads, it);
-    encodeAttrVector(obj->loops, it);
-    encodeAttrVector(obj->polys, it);
-    encodeAttrVector(obj->edges, it);
-    encodeAttrVector(obj->uvs, it);
+bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &opts);
+bool encodePrimitiveObject(PrimitiveObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &opts) {
+    encodeAttrVector(obj->verts, it, opts, true);
+    encodeAttrVector(obj->points, it, opts);
+    encodeAttrVector(obj->lines, it, opts);
+    encodeAttrVector(obj->tris, it, opts);
+    encodeAttrVector(obj->quads, it, opts);
+    encodeAttrVector(obj->loops, it, opts);
+    encodeAttrVector(obj->polys, it, opts);
+    encodeAttrVector(obj->edges, it, opts);
+    encodeAttrVector(obj->uvs, it, opts);
     if (obj->mtl) {
         *it++ = '1';
         for (char c: obj->mtl->serialize())
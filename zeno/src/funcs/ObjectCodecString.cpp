@@ -16,8 +16,8 @@ std::shared_ptr<MaterialObject> decodeMaterialObject(const char *it) {
     return mtl;
 }
 
-bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
+bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &);
+bool encodeMaterialObject(MaterialObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &) {
     auto v = obj->serialize();
     std::copy(v.begin(), v.end(), it);
     return true;
@@ -28,8 +28,8 @@ std::shared_ptr<DummyObject> decodeDummyObject(const char *it) {
     return std::make_shared<DummyObject>();
 }
 
-bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it);
-bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it) {
+bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &);
+bool encodeDummyObject(DummyObject const *obj, std::back_insert_iterator<std::vector<char>> it, ObjectCodecOptions const &) {
     return true;
 }
 
@@ -0,0 +1,249 @@
+#include <zeno/funcs/PrimitiveAdjacency.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/thread_pool.h>
+#include <zeno/utils/Error.h>
+#include <algorithm>
+#include <atomic>
+
+namespace zeno {
+
+namespace {
+
+constexpr std::size_t kHashBlock = 1 << 14;
+
+std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+// blocks hashed in parallel with four lanes each, then combined in order
+std::uint64_t hashInts(int const *p, std::size_t n, std::uint64_t seed) {
+    std::size_t nblocks = (n + kHashBlock - 1) / kHashBlock;
+    std::vector<std::uint64_t> blocks(nblocks);
+    parallel_for(nblocks, [&] (std::size_t b) {
+        std::size_t i = b * kHashBlock, end = std::min(n, i + kHashBlock);
+        std::uint64_t h[4] = {1, 2, 3, 4};
+        for (; i + 4 <= end; i += 4) {
+            for (int k = 0; k < 4; k++)
+                h[k] = (h[k] ^ static_cast<std::uint32_t>(p[i + k])) * 0x100000001b3ull;
+        }
+        for (; i < end; i++)
+            h[0] = (h[0] ^ static_cast<std::uint32_t>(p[i])) * 0x100000001b3ull;
+        blocks[b] = mix(h[0] ^ mix(h[1] ^ mix(h[2] ^ mix(h[3]))));
+    });
+    std::uint64_t h = mix(seed ^ n);
+    for (auto x: blocks)
+        h = mix(h ^ x);
+    return h;
+}
+
+template <class T>
+std::uint64_t hashArray(std::vector<T> const &arr, std::uint64_t seed) {
+    static_assert(sizeof(T) % sizeof(int) == 0);
+    return hashInts(reinterpret_cast<int const *>(arr.data()), arr.size() * (sizeof(T) / sizeof(int)), seed);
+}
+
+// offsets of n + 1 entries from the size of each item
+template <class F>
+std::vector<int> makeOffsets(int n, F const &sizeOf) {
+    std::vector<int> offs(n + 1);
+    offs[n] = parallel_exclusive_scan(0, n, offs.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, sizeOf);
+    return offs;
+}
+
+// CSR from a collect(i, out) filling out with the items of i, once per i, into
+// per-chunk buffers that are copied in place when all the offsets are known
+template <class F>
+void buildCSR(int n, std::vector<int> &offs, std::vector<int> &items, F const &collect) {
+    auto &pool = thread_pool::global();
+    std::size_t nchunks = pool.chunk_count(n);
+    std::vector<std::vector<int>> chunkItems(nchunks);
+    std::vector<int> counts(n);
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t ch, std::size_t b, std::size_t e) {
+        std::vector<int> tmp;
+        for (std::size_t i = b; i < e; i++) {
+            tmp.clear();
+            collect((int)i, tmp);
+            counts[i] = (int)tmp.size();
+            chunkItems[ch].insert(chunkItems[ch].end(), tmp.begin(), tmp.end());
+        }
+    });
+    offs = makeOffsets(n, [&] (int i) {
+        return counts[i];
+    });
+    items.resize(offs[n]);
+    pool.for_each_chunk(n, nchunks, [&] (std::size_t ch, std::size_t b, std::size_t e) {
+        std::copy(chunkItems[ch].begin(), chunkItems[ch].end(), items.begin() + offs[b]);
+        std::vector<int>().swap(chunkItems[ch]);
+    });
+}
+
+}
+
+ZENO_API int PrimAdjacency::findEdge(int a, int b) const {
+    if (a > b)
+        std::swap(a, b);
+    auto beg = edges.begin() + vertEdgeOffs[a];
+    auto end = edges.begin() + vertEdgeOffs[a + 1];
+    auto it = std::lower_bound(beg, end, b, [] (vec2i const &e, int b) {
+        return e[1] < b;
+    });
+    if (it == end || (*it)[1] != b)
+        return -1;
+    return (int)(it - edges.begin());
+}
+
+ZENO_API std::uint64_t PrimAdjacency::hashTopology(PrimitiveObject const *prim) {
+    std::uint64_t h = mix(prim->verts.size());
+    h = hashArray(prim->lines.values, h);
+    h = hashArray(prim->tris.values, h);
+    h = hashArray(prim->quads.values, h);
+    h = hashArray(prim->polys.values, h);
+    h = hashArray(prim->loops.values, h);
+    return h;
+}
+
+ZENO_API std::shared_ptr<PrimAdjacency> PrimAdjacency::build(PrimitiveObject const *prim) {
+    auto adj = std::make_shared<PrimAdjacency>();
+
+    int nverts = (int)prim->verts.size();
+    int counts[4] = {(int)prim->lines.size(), (int)prim->tris.size(), (int)prim->quads.size(), (int)prim->polys.size()};
+    for (int t = 0; t < 4; t++)
+        adj->faceBegin[t + 1] = adj->faceBegin[t] + counts[t];
+    int nfaces = adj->faceBegin[4];
+    auto const &fb = adj->faceBegin;
+
+    adj->faceCornerOffs = makeOffsets(nfaces, [&] (int f) -> int {
+        if (f < fb[Tris]) return 2;
+        if (f < fb[Quads]) return 3;
+        if (f < fb[Polys]) return 4;
+        return prim->polys[f - fb[Polys]][1];
+    });
+    int ncorners = adj->faceCornerOffs[nfaces];
+    adj->cornerVert.resize(ncorners);
+    adj->cornerFace.resize(ncorners);
+    std::atomic<bool> outOfRange{false};
+    parallel_for(nfaces, [&] (int f) {
+        int c = adj->faceCornerOffs[f];
+        auto put = [&] (int v) {
+            if (v < 0 || v >= nverts)
+                outOfRange.store(true, std::memory_order_relaxed);
+            adj->cornerVert[c] = v;
+            adj->cornerFace[c] = f;
+            c++;
+        };
+        if (f < fb[Tris]) {
+            auto ind = prim->lines[f];
+            put(ind[0]), put(ind[1]);
+        } else if (f < fb[Quads]) {
+            auto ind = prim->tris[f - fb[Tris]];
+            put(ind[0]), put(ind[1]), put(ind[2]);
+        } else if (f < fb[Polys]) {
+            auto ind = prim->quads[f - fb[Quads]];
+            put(ind[0]), put(ind[1]), put(ind[2]), put(ind[3]);
+        } else {
+            auto [base, len] = prim->polys[f - fb[Polys]];
+            for (int l = base; l < base + len; l++)
+                put(prim->loops[l]);
+        }
+    });
+    if (outOfRange.load())
+        throw makeError("primitive refers to a vertex out of range");
+
+    // vert -> corners, bucketed with atomic cursors then sorted to be deterministic
+    {
+        std::vector<std::atomic<int>> cursor(nverts);
+        parallel_for(nverts, [&] (int v) {
+            cursor[v].store(0, std::memory_order_relaxed);
+        });
+        parallel_for(ncorners, [&] (int c) {
+            cursor[adj->cornerVert[c]].fetch_add(1, std::memory_order_relaxed);
+        });
+        adj->vertCornerOffs = makeOffsets(nverts, [&] (int v) {
+            return cursor[v].load(std::memory_order_relaxed);
+        });
+        parallel_for(nverts, [&] (int v) {
+            cursor[v].store(adj->vertCornerOffs[v], std::memory_order_relaxed);
+        });
+        adj->vertCorners.resize(ncorners);
+        parallel_for(ncorners, [&] (int c) {
+            adj->vertCorners[cursor[adj->cornerVert[c]].fetch_add(1, std::memory_order_relaxed)] = c;
+        });
+        parallel_for(nverts, [&] (int v) {
+            std::sort(adj->vertCorners.begin() + adj->vertCornerOffs[v],
+                      adj->vertCorners.begin() + adj->vertCornerOffs[v + 1]);
+        });
+    }
+
+    buildCSR(nverts, adj->vertVertOffs, adj->vertVerts, [&] (int v, std::vector<int> &out) {
+        adj->foreach_vert_corner(v, [&] (int c) {
+            out.push_back(adj->cornerVert[adj->nextCorner(c)]);
+            out.push_back(adj->cornerVert[adj->prevCorner(c)]);
+        });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        out.erase(std::remove(out.begin(), out.end(), v), out.end());
+    });
+
+    // edges start from their lower vert, so numbering them by vert keeps them sorted
+    adj->vertEdgeOffs = makeOffsets(nverts, [&] (int v) {
+        auto beg = adj->vertVerts.begin() + adj->vertVertOffs[v];
+        auto end = adj->vertVerts.begin() + adj->vertVertOffs[v + 1];
+        return (int)(end - std::upper_bound(beg, end, v));
+    });
+    int nedges = adj->vertEdgeOffs[nverts];
+    adj->edges.resize(nedges);
+    parallel_for(nverts, [&] (int v) {
+        int e = adj->vertEdgeOffs[v];
+        adj->foreach_vert_vert(v, [&] (int w) {
+            if (w > v)
+                adj->edges[e++] = vec2i(v, w);
+        });
+    });
+
+    buildCSR(nedges, adj->edgeFaceOffs, adj->edgeFaces, [&] (int e, std::vector<int> &out) {
+        auto [a, b] = adj->edges[e];
+        adj->foreach_vert_corner(a, [&] (int c) {
+            if (adj->cornerVert[adj->nextCorner(c)] == b || adj->cornerVert[adj->prevCorner(c)] == b)
+                out.push_back(adj->cornerFace[c]);
+        });
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    });
+
+    adj->cornerEdge.resize(ncorners);
+    adj->cornerOpposite.resize(ncorners);
+    parallel_for(ncorners, [&] (int c) {
+        int a = adj->cornerVert[c];
+        int b = adj->cornerVert[adj->nextCorner(c)];
+        adj->cornerEdge[c] = a == b ? -1 : adj->findEdge(a, b);
+        int opposite = -1;
+        adj->foreach_vert_corner(b, [&] (int d) {
+            if (opposite == -1 && d != c && adj->cornerVert[adj->nextCorner(d)] == a)
+                opposite = d;
+        });
+        adj->cornerOpposite[c] = opposite;
+    });
+
+    return adj;
+}
+
+ZENO_API std::shared_ptr<PrimAdjacency const> primAdjacency(PrimitiveObject const *prim) {
+    auto hash = PrimAdjacency::hashTopology(prim);
+    auto adj = std::atomic_load(&prim->adjacency);
+    if (adj && adj->topologyHash == hash)
+        return adj;
+    auto nadj = PrimAdjacency::build(prim);
+    nadj->topologyHash = hash;
+    std::atomic_store(&prim->adjacency, std::shared_ptr<PrimAdjacency const>(nadj));
+    return nadj;
+}
+
+}
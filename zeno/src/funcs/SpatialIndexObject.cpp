@@ -0,0 +1,594 @@
+#include <zeno/types/SpatialIndexObject.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveAdjacency.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
+#include <zeno/para/parallel_reduce.h>
+#include <zeno/utils/morton.h>
+#include <zeno/utils/Error.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace zeno {
+
+namespace {
+
+constexpr int kMaxCell = (1 << 21) - 1;  // per axis, for 63-bit morton codes
+constexpr int kStackSize = 128;          // a karras tree is at most as deep as its 64 + 32 key bits
+
+using Hit = SpatialIndexObject::Hit;
+
+float boxDist2(vec3f const &bmin, vec3f const &bmax, vec3f const &p) {
+    float d2 = 0;
+    for (int d = 0; d < 3; d++) {
+        float e = std::max(std::max(bmin[d] - p[d], p[d] - bmax[d]), 0.f);
+        d2 += e * e;
+    }
+    return d2;
+}
+
+// entry and exit distances of the ray through the box, clipped to [0, tmax]
+bool rayBox(vec3f const &bmin, vec3f const &bmax, vec3f const &ro, vec3f const &invd, float tmax, float &tenter) {
+    float t0 = 0, t1 = tmax;
+    for (int d = 0; d < 3; d++) {
+        float ta = (bmin[d] - ro[d]) * invd[d];
+        float tb = (bmax[d] - ro[d]) * invd[d];
+        if (ta > tb)
+            std::swap(ta, tb);
+        t0 = ta > t0 ? ta : t0;  // written so that a NaN from 0 * inf leaves the bound alone
+        t1 = tb < t1 ? tb : t1;
+        if (t0 > t1)
+            return false;
+    }
+    tenter = t0;
+    return true;
+}
+
+// Möller-Trumbore, t is the distance in units of rd
+bool rayTri(vec3f const &ro, vec3f const &rd, vec3f const &a, vec3f const &b, vec3f const &c, float &t, vec3f &bary) {
+    vec3f e1 = b - a, e2 = c - a;
+    vec3f p = cross(rd, e2);
+    float det = dot(e1, p);
+    if (std::abs(det) < 1e-12f)
+        return false;
+    float inv = 1 / det;
+    vec3f s = ro - a;
+    float u = dot(s, p) * inv;
+    if (u < 0 || u > 1)
+        return false;
+    vec3f q = cross(s, e1);
+    float v = dot(rd, q) * inv;
+    if (v < 0 || u + v > 1)
+        return false;
+    t = dot(e2, q) * inv;
+    bary = vec3f(1 - u - v, u, v);
+    return true;
+}
+
+// Ericson, Real-Time Collision Detection 5.1.5
+vec3f closestOnTri(vec3f const &p, vec3f const &a, vec3f const &b, vec3f const &c, vec3f &bary) {
+    vec3f ab = b - a, ac = c - a, ap = p - a;
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0 && d2 <= 0) {
+        bary = vec3f(1, 0, 0);
+        return a;
+    }
+    vec3f bp = p - b;
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0 && d4 <= d3) {
+        bary = vec3f(0, 1, 0);
+        return b;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        float v = d1 / (d1 - d3);
+        bary = vec3f(1 - v, v, 0);
+        return a + v * ab;
+    }
+    vec3f cp = p - c;
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0 && d5 <= d6) {
+        bary = vec3f(0, 0, 1);
+        return c;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        float w = d2 / (d2 - d6);
+        bary = vec3f(1 - w, 0, w);
+        return a + w * ac;
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        bary = vec3f(0, 1 - w, w);
+        return b + w * (c - b);
+    }
+    float denom = 1 / (va + vb + vc);
+    float v = vb * denom, w = vc * denom;
+    bary = vec3f(1 - v - w, v, w);
+    return a + ab * v + ac * w;
+}
+
+// ids 0..n-1 sorted by the morton code of the cell of posOf(id), cells being (pos - origin) * invCell
+// clamped to [0, cmax], ties broken by id
+template <class F>
+std::vector<std::pair<std::uint64_t, int>> mortonSorted(int n, vec3f origin, vec3f invCell, vec3i cmax, F const &posOf) {
+    std::vector<std::pair<std::uint64_t, int>> sorted(n);
+    parallel_for(n, [&] (int i) {
+        vec3f q = (posOf(i) - origin) * invCell;
+        sorted[i] = {morton3d::encode(
+            std::min((int)q[0], cmax[0]), std::min((int)q[1], cmax[1]), std::min((int)q[2], cmax[2])), i};
+    });
+    parallel_sort(sorted.begin(), sorted.end(), [] (auto const &a, auto const &b) {
+        return a < b;
+    });
+    return sorted;
+}
+
+// cells of at most kMaxCell per axis over the box
+vec3f invCellOver(vec3f const &bmin, vec3f const &bmax) {
+    vec3f scale = bmax - bmin;
+    for (int d = 0; d < 3; d++)
+        scale[d] = scale[d] > 0 ? kMaxCell / scale[d] : 0;
+    return scale;
+}
+
+// keeps the k nearest hits seen so far as a max-heap on dist
+struct KnnHeap {
+    std::vector<Hit> &hits;
+    std::size_t k;
+    float maxDist;
+
+    static bool farther(Hit const &a, Hit const &b) {
+        return a.dist < b.dist || (a.dist == b.dist && a.id < b.id);
+    }
+
+    float bound() const {
+        return hits.size() < k ? maxDist : hits.front().dist;
+    }
+
+    void push(Hit const &hit) {
+        if (hit.dist > maxDist)
+            return;
+        if (hits.size() < k) {
+            hits.push_back(hit);
+            std::push_heap(hits.begin(), hits.end(), farther);
+        } else if (farther(hit, hits.front())) {
+            std::pop_heap(hits.begin(), hits.end(), farther);
+            hits.back() = hit;
+            std::push_heap(hits.begin(), hits.end(), farther);
+        }
+    }
+
+    void finish() {
+        std::sort_heap(hits.begin(), hits.end(), farther);
+    }
+};
+
+}
+
+ZENO_API vec3f SpatialIndexObject::closestOnElement(int e, vec3f const &pos, vec3f &bary) const {
+    auto ind = elems[e];
+    if (elementType == Points) {
+        bary = vec3f(1, 0, 0);
+        return verts[ind[0]];
+    } else if (elementType == Lines) {
+        vec3f a = verts[ind[0]], ab = verts[ind[1]] - a;
+        float len2 = dot(ab, ab);
+        float t = len2 > 0 ? std::clamp(dot(pos - a, ab) / len2, 0.f, 1.f) : 0.f;
+        bary = vec3f(1 - t, t, 0);
+        return a + t * ab;
+    } else {
+        return closestOnTri(pos, verts[ind[0]], verts[ind[1]], verts[ind[2]], bary);
+    }
+}
+
+ZENO_API std::shared_ptr<SpatialIndexObject> SpatialIndexObject::build(PrimitiveObject const *prim, ElementType type,
+                                                                       Structure structure, float cellSize) {
+    if (structure == HashGrid && type != Points)
+        throw makeError("hash grid spatial index only holds points");
+
+    auto idx = std::make_shared<SpatialIndexObject>();
+    idx->elementType = type;
+    idx->structure = structure;
+    idx->topologyHash = PrimAdjacency::hashTopology(prim);
+    idx->verts = prim->verts.values;
+    int nverts = idx->verts.size();
+    if (type == Points) {
+        idx->elems.resize(nverts);
+        parallel_for(nverts, [&] (int i) {
+            idx->elems[i] = vec3i(i, i, i);
+        });
+    } else if (type == Lines) {
+        idx->elems.resize(prim->lines.size());
+        parallel_for(prim->lines.size(), [&] (size_t i) {
+            auto ind = prim->lines[i];
+            idx->elems[i] = vec3i(ind[0], ind[1], ind[0]);
+        });
+    } else {
+        idx->elems = prim->tris.values;
+    }
+    std::atomic<bool> outOfRange{false};
+    parallel_for(idx->elems.size(), [&] (size_t e) {
+        auto ind = idx->elems[e];
+        for (int k = 0; k < 3; k++) {
+            if (ind[k] < 0 || ind[k] >= nverts)
+                outOfRange.store(true, std::memory_order_relaxed);
+        }
+    });
+    if (outOfRange.load())
+        throw makeError("primitive refers to a vertex out of range");
+
+    if (structure == HashGrid) {
+        idx->cellSize = cellSize;
+        idx->refit(prim);
+        return idx;
+    }
+
+    int n = idx->elems.size();
+    idx->parents.assign(std::max(n - 1, 0) + n, -1);
+    if (n < 2) {
+        idx->refit(prim);
+        return idx;
+    }
+
+    // morton codes of the element centers, ties broken by element id
+    auto center = [&] (int e) {
+        auto ind = idx->elems[e];
+        return (idx->verts[ind[0]] + idx->verts[ind[1]] + idx->verts[ind[2]]) * (1.f / 3);
+    };
+    std::vector<vec3f> centers(n);
+    parallel_for(n, [&] (int e) {
+        centers[e] = center(e);
+    });
+    auto [cmin, cmax] = parallel_reduce_minmax(centers.begin(), centers.end());
+    auto sorted = mortonSorted(n, cmin, invCellOver(cmin, cmax), vec3i(kMaxCell), [&] (int e) {
+        return centers[e];
+    });
+    std::vector<vec3f>().swap(centers);
+
+    // length of the common prefix of the keys at i and j, -1 out of range
+    auto delta = [&] (int i, int j) -> int {
+        if (j < 0 || j >= n)
+            return -1;
+        auto ci = sorted[i].first, cj = sorted[j].first;
+        if (ci == cj)
+            return 64 + __builtin_clz((unsigned)(i ^ j));
+        return __builtin_clzll(ci ^ cj);
+    };
+    idx->nodes.resize(n - 1);
+    parallel_for(n - 1, [&] (int i) {
+        int d = delta(i, i + 1) > delta(i, i - 1) ? 1 : -1;
+        int dmin = delta(i, i - d);
+        int lmax = 2;
+        while (delta(i, i + lmax * d) > dmin)
+            lmax *= 2;
+        int l = 0;
+        for (int t = lmax / 2; t >= 1; t /= 2) {
+            if (delta(i, i + (l + t) * d) > dmin)
+                l += t;
+        }
+        int j = i + l * d;
+        int dnode = delta(i, j);
+        int s = 0;
+        for (int div = 2;; div *= 2) {
+            int t = (l + div - 1) / div;
+            if (delta(i, i + (s + t) * d) > dnode)
+                s += t;
+            if (t <= 1)
+                break;
+        }
+        int gamma = i + s * d + std::min(d, 0);
+        auto &node = idx->nodes[i];
+        node.child[0] = std::min(i, j) == gamma ? ~sorted[gamma].second : gamma;
+        node.child[1] = std::max(i, j) == gamma + 1 ? ~sorted[gamma + 1].second : gamma + 1;
+        for (int c: node.child)
+            idx->parents[c < 0 ? n - 1 + ~c : c] = i;
+    });
+
+    idx->refit(prim);
+    return idx;
+}
+
+ZENO_API bool SpatialIndexObject::refit(PrimitiveObject const *prim) {
+    if (prim->verts.size() != verts.size() || PrimAdjacency::hashTopology(prim) != topologyHash)
+        return false;
+    verts = prim->verts.values;
+
+    if (structure == HashGrid) {
+        int n = verts.size();
+        cellPoints.clear();
+        cellCodes.clear();
+        cellBegin.assign(1, 0);
+        if (!n)
+            return true;
+        auto [bmin, bmax] = parallel_reduce_minmax(verts.begin(), verts.end());
+        float extent = zeno::max(bmax[0] - bmin[0], zeno::max(bmax[1] - bmin[1], bmax[2] - bmin[2]));
+        float cell = cellSize > 0 ? cellSize : extent / std::cbrt((float)n);  // about one point per cell
+        cell = std::max(cell, extent / float(1 << 20));
+        if (!(cell > 0))
+            cell = 1;
+        cellSize = cell;
+        gridOrigin = bmin;
+        for (int d = 0; d < 3; d++)
+            gridMax[d] = std::min((int)((bmax[d] - bmin[d]) / cell), kMaxCell);
+        auto sorted = mortonSorted(n, gridOrigin, vec3f(1 / cellSize), gridMax, [&] (int i) {
+            return verts[i];
+        });
+        std::vector<int> cellIdx(n);
+        int ncells = parallel_exclusive_scan(0, n, cellIdx.begin(), 0, [] (int x, int y) {
+            return x + y;
+        }, [&] (int i) {
+            return (int)(i == 0 || sorted[i].first != sorted[i - 1].first);
+        });
+        cellPoints.resize(n);
+        cellCodes.resize(ncells);
+        cellBegin.resize(ncells + 1);
+        cellBegin[ncells] = n;
+        parallel_for(n, [&] (int i) {
+            cellPoints[i] = sorted[i].second;
+            if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+                cellCodes[cellIdx[i]] = sorted[i].first;
+                cellBegin[cellIdx[i]] = i;
+            }
+        });
+        return true;
+    }
+
+    int n = elems.size();
+    if (n < 2)
+        return true;
+
+    // bottom-up, each child stores its box in its parent, and the second one to arrive
+    // there goes on with the union of both
+    std::vector<std::atomic<int>> arrived(n - 1);
+    parallel_for(n - 1, [&] (int i) {
+        arrived[i].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(n, [&] (int e) {
+        auto ind = elems[e];
+        vec3f bmin = verts[ind[0]], bmax = bmin;
+        for (int k = 1; k < 3; k++) {
+            bmin = zeno::min(bmin, verts[ind[k]]);
+            bmax = zeno::max(bmax, verts[ind[k]]);
+        }
+        int c = ~e;
+        int p = parents[n - 1 + e];
+        while (true) {
+            auto &node = nodes[p];
+            int slot = node.child[1] == c;
+            node.bmin[slot] = bmin;
+            node.bmax[slot] = bmax;
+            if (arrived[p].fetch_add(1, std::memory_order_acq_rel) == 0)
+                break;
+            bmin = zeno::min(node.bmin[0], node.bmin[1]);
+            bmax = zeno::max(node.bmax[0], node.bmax[1]);
+            c = p;
+            p = parents[p];
+            if (p == -1)
+                break;
+        }
+    });
+    return true;
+}
+
+ZENO_API std::vector<int> SpatialIndexObject::batchOrder(std::vector<vec3f> const &pos) const {
+    int n = pos.size();
+    std::vector<int> order(n);
+    if (!n)
+        return order;
+    auto [bmin, bmax] = parallel_reduce_minmax(pos.begin(), pos.end());
+    auto sorted = mortonSorted(n, bmin, invCellOver(bmin, bmax), vec3i(kMaxCell), [&] (int i) {
+        return pos[i];
+    });
+    parallel_for(n, [&] (int i) {
+        order[i] = sorted[i].second;
+    });
+    return order;
+}
+
+ZENO_API void SpatialIndexObject::knn(vec3f const &pos, int k, float maxDist, std::vector<Hit> &out) const {
+    out.clear();
+    if (k <= 0 || elems.empty())
+        return;
+    KnnHeap heap{out, (std::size_t)k, maxDist};
+    auto visit = [&] (int e) {
+        Hit hit;
+        hit.id = e;
+        hit.pos = closestOnElement(e, pos, hit.bary);
+        hit.dist = length(hit.pos - pos);
+        heap.push(hit);
+    };
+
+    if (structure == HashGrid) {
+        // rings of cells around the one of pos, points in ring r + 1 being farther than r cells
+        vec3f q = clamp((pos - gridOrigin) / cellSize, -1e9f, 1e9f);
+        vec3i c(std::floor(q[0]), std::floor(q[1]), std::floor(q[2]));
+        int rmin = 0, rmax = 0;
+        for (int d = 0; d < 3; d++) {
+            rmin = std::max(rmin, std::max(-c[d], c[d] - gridMax[d]));
+            rmax = std::max(rmax, std::max(c[d], gridMax[d] - c[d]));
+        }
+        for (int r = rmin; r <= rmax; r++) {
+            if (r > 0 && (r - 1) * cellSize > heap.bound())
+                break;
+            int z0 = std::max(c[2] - r, 0), z1 = std::min(c[2] + r, gridMax[2]);
+            int y0 = std::max(c[1] - r, 0), y1 = std::min(c[1] + r, gridMax[1]);
+            for (int z = z0; z <= z1; z++) for (int y = y0; y <= y1; y++) {
+                bool face = std::abs(z - c[2]) == r || std::abs(y - c[1]) == r;
+                for (int x = std::max(c[0] - r, 0); x <= std::min(c[0] + r, gridMax[0]);
+                     x += face || x != c[0] - r ? 1 : 2 * r) {
+                    if (!face && std::abs(x - c[0]) != r)
+                        continue;
+                    auto code = morton3d::encode(x, y, z);
+                    auto it = std::lower_bound(cellCodes.begin(), cellCodes.end(), code);
+                    if (it == cellCodes.end() || *it != code)
+                        continue;
+                    int cell = it - cellCodes.begin();
+                    for (int i = cellBegin[cell]; i < cellBegin[cell + 1]; i++)
+                        visit(cellPoints[i]);
+                }
+            }
+        }
+        heap.finish();
+        return;
+    }
+
+    if (nodes.empty()) {
+        visit(0);
+        heap.finish();
+        return;
+    }
+    std::pair<float, int> stack[kStackSize];
+    int top = 0;
+    stack[top++] = {0.f, 0};
+    while (top) {
+        auto [d2, node] = stack[--top];
+        float bound = heap.bound();
+        if (d2 > bound * bound)
+            continue;
+        if (node < 0) {
+            visit(~node);
+            continue;
+        }
+        auto const &nd = nodes[node];
+        float cd2[2];
+        for (int i = 0; i < 2; i++)
+            cd2[i] = boxDist2(nd.bmin[i], nd.bmax[i], pos);
+        int nearer = cd2[1] < cd2[0];
+        for (int i: {1 - nearer, nearer}) {  // the nearer one is popped first
+            if (cd2[i] <= bound * bound)
+                stack[top++] = {cd2[i], nd.child[i]};
+        }
+    }
+    heap.finish();
+}
+
+ZENO_API Hit SpatialIndexObject::closest(vec3f const &pos, float maxDist) const {
+    thread_local std::vector<Hit> hits;
+    knn(pos, 1, maxDist, hits);
+    return hits.empty() ? Hit{} : hits[0];
+}
+
+ZENO_API void SpatialIndexObject::radius(vec3f const &pos, float radius, std::vector<Hit> &out) const {
+    out.clear();
+    if (elems.empty() || !(radius >= 0))
+        return;
+    auto visit = [&] (int e) {
+        Hit hit;
+        hit.id = e;
+        hit.pos = closestOnElement(e, pos, hit.bary);
+        hit.dist = length(hit.pos - pos);
+        if (hit.dist <= radius)
+            out.push_back(hit);
+    };
+
+    if (structure == HashGrid) {
+        vec3f lo = (pos - radius - gridOrigin) / cellSize;
+        vec3f hi = (pos + radius - gridOrigin) / cellSize;
+        vec3i c0, c1;
+        double volume = 1;
+        for (int d = 0; d < 3; d++) {
+            c0[d] = (int)std::max(std::floor(lo[d]), 0.f);
+            c1[d] = (int)std::min(std::floor(hi[d]), (float)gridMax[d]);
+            if (c0[d] > c1[d])
+                return;
+            volume *= c1[d] - c0[d] + 1;
+        }
+        if (volume > cellCodes.size()) {  // a huge radius, cheaper to go through the occupied cells
+            for (int i = 0; i < (int)cellPoints.size(); i++)
+                visit(cellPoints[i]);
+            return;
+        }
+        for (int z = c0[2]; z <= c1[2]; z++) for (int y = c0[1]; y <= c1[1]; y++) for (int x = c0[0]; x <= c1[0]; x++) {
+            auto code = morton3d::encode(x, y, z);
+            auto it = std::lower_bound(cellCodes.begin(), cellCodes.end(), code);
+            if (it == cellCodes.end() || *it != code)
+                continue;
+            int cell = it - cellCodes.begin();
+            for (int i = cellBegin[cell]; i < cellBegin[cell + 1]; i++)
+                visit(cellPoints[i]);
+        }
+        return;
+    }
+
+    if (nodes.empty()) {
+        visit(0);
+        return;
+    }
+    float r2 = radius * radius;
+    int stack[kStackSize];
+    int top = 0;
+    stack[top++] = 0;
+    while (top) {
+        int node = stack[--top];
+        if (node < 0) {
+            visit(~node);
+            continue;
+        }
+        auto const &nd = nodes[node];
+        for (int i = 0; i < 2; i++) {
+            if (boxDist2(nd.bmin[i], nd.bmax[i], pos) <= r2)
+                stack[top++] = nd.child[i];
+        }
+    }
+}
+
+ZENO_API Hit SpatialIndexObject::raycast(vec3f const &ro, vec3f const &rd, float maxDist) const {
+    Hit best;
+    if (elementType != Tris || elems.empty())
+        return best;
+    float rlen = length(rd);
+    if (!(rlen > 0))
+        return best;
+    vec3f dir = rd / rlen;
+    vec3f invd(1 / dir[0], 1 / dir[1], 1 / dir[2]);
+    float tbest = maxDist;
+
+    auto visit = [&] (int e) {
+        auto ind = elems[e];
+        float t;
+        vec3f bary;
+        if (rayTri(ro, dir, verts[ind[0]], verts[ind[1]], verts[ind[2]], t, bary) && t >= 0 && t <= tbest) {
+            if (t < tbest || best.id == -1 || e < best.id) {
+                tbest = t;
+                best.id = e;
+                best.dist = t;
+                best.pos = ro + t * dir;
+                best.bary = bary;
+            }
+        }
+    };
+
+    if (nodes.empty()) {
+        visit(0);
+        return best;
+    }
+    std::pair<float, int> stack[kStackSize];
+    int top = 0;
+    stack[top++] = {0.f, 0};
+    while (top) {
+        auto [tenter, node] = stack[--top];
+        if (tenter > tbest)
+            continue;
+        if (node < 0) {
+            visit(~node);
+            continue;
+        }
+        auto const &nd = nodes[node];
+        float ct[2];
+        bool hit[2];
+        for (int i = 0; i < 2; i++)
+            hit[i] = rayBox(nd.bmin[i], nd.bmax[i], ro, invd, tbest, ct[i]);
+        int nearer = hit[1] && (!hit[0] || ct[1] < ct[0]);
+        for (int i: {1 - nearer, nearer}) {
+            if (hit[i])
+                stack[top++] = {ct[i], nd.child[i]};
+        }
+    }
+    return best;
+}
+
+}
@@ -12,6 +12,10 @@ namespace zeno {
 struct CachedByKey : zeno::INode {
     std::map<std::string, std::shared_ptr<IObject>> cache;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         requireInput("key");
         auto key = get_input<zeno::StringObject>("key")->get();
@@ -40,6 +44,10 @@ ZENDEFNODE(CachedByKey, {
 struct CachedIf : zeno::INode {
     bool m_done = false;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         if (has_input("keepCache")) {
             requireInput("keepCache");
@@ -71,6 +79,10 @@ ZENDEFNODE(CachedIf, {
 struct CachedOnce : zeno::INode {
     bool m_done = false;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         if (!m_done) {
             INode::preApply();
@@ -94,6 +106,10 @@ ZENDEFNODE(CachedOnce, {
 struct CacheLastFrameBegin : zeno::INode {
     std::shared_ptr<IObject> m_lastFrameCache = nullptr;
 
+    virtual bool isPure() const override {
+        return false;
+    }
+
     virtual void apply() override { 
         if (m_lastFrameCache == nullptr) {
             m_lastFrameCache = (*get_input("input")).clone();            
@@ -120,6 +136,10 @@ ZENO_DEFNODE(CacheLastFrameBegin)(
 struct CacheLastFrameEnd : zeno::INode {
     CacheLastFrameBegin* m_CacheLastFrameBegin;
 
+    virtual bool isPure() const override {
+        return false;
+    }
+
     virtual void apply() override {
         if (auto it = inputBounds.find("linkTo"); it != inputBounds.end()) {
             auto [sn, ss] = it->second;
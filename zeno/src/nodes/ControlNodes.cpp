@@ -2,9 +2,15 @@
 #include <zeno/types/ListObject.h>
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/DummyObject.h>
+#include <zeno/types/StringObject.h>
 #include <zeno/extra/ContextManaged.h>
 #include <zeno/extra/evaluate_condition.h>
+#include <zeno/extra/SubnetNode.h>
+#include <zeno/para/thread_pool.h>
 #include <zeno/utils/safe_at.h>
+#include <functional>
+#include <algorithm>
+#include <mutex>
 
 namespace zeno {
 
@@ -209,8 +215,188 @@ struct EndForEach : EndFor {
         }
     }
 
+    // stands in for a node outside of the loop body in a worker graph, keeping what it computed
+    struct LoopProxyNode : INode {
+        virtual void preApply() override {}
+        virtual void apply() override {}
+    };
+
+    // immutable in practice, workers may share these instead of cloning them
+    static bool isShareable(IObject const *obj) {
+        return dynamic_cast<DummyObject const *>(obj)
+            || dynamic_cast<NumericObject const *>(obj)
+            || dynamic_cast<StringObject const *>(obj);
+    }
+
+    // runs the iterations concurrently, each worker on its own copy of the loop body, with
+    // results gathered in index order; returns false to fall back to the serial loop when
+    // accumate is used, the body has lazy nodes (nested loops), subnets or a BreakFor, or
+    // reads a loop-invariant object that can't be cloned
+    bool parallelApply() {
+        auto [sn, ss] = safe_at(inputBounds, "FOR", "input socket of EndForEach");
+        auto fore = dynamic_cast<BeginForEach *>(graph->nodes.at(sn).get());
+        if (!fore || inputBounds.count("accumate") || fore->inputBounds.count("accumate"))
+            return false;
+
+        // the body is what lies between fore and us, the rest is evaluated once beforehand
+        std::map<std::string, bool> depends;
+        std::function<bool(std::string const &)> visit = [&] (std::string const &id) {
+            if (auto it = depends.find(id); it != depends.end())
+                return it->second;
+            depends[id] = id == sn;
+            if (id == sn)
+                return true;
+            bool dep = false;
+            for (auto const &[ds, bound]: safe_at(graph->nodes, id, "node name")->inputBounds) {
+                dep = visit(bound.first) || dep;
+            }
+            return depends[id] = dep;
+        };
+        for (auto const &[ds, bound]: inputBounds) {
+            if (ds != "FOR")
+                visit(bound.first);
+        }
+        std::set<std::string> body;
+        for (auto const &[id, dep]: depends) {
+            if (!dep || id == sn)
+                continue;
+            auto node = graph->nodes.at(id).get();
+            if (node->hasLazyInputs() || dynamic_cast<SubnetNode *>(node))
+                return false;
+            for (auto const &[ds, bound]: node->inputBounds) {
+                if (bound.first == sn && bound.second == "FOR")
+                    return false;
+            }
+            body.insert(id);
+        }
+
+        graph->applyNode(sn);
+        auto const &list = fore->m_list->arr;
+        if (list.size() < 2)
+            return false;
+        for (auto const &[id, dep]: depends) {
+            if (!dep)
+                graph->applyNode(id);
+        }
+
+        // loop-invariant outputs read by the body, which may modify them in place
+        std::set<std::pair<std::string, std::string>> invariants;
+        for (auto const &id: body) {
+            for (auto const &[ds, bound]: graph->nodes.at(id)->inputBounds) {
+                if (bound.first != sn && !body.count(bound.first))
+                    invariants.insert(bound);
+            }
+        }
+
+        // a copy of the body with its own clones of the invariants, null when some can't be cloned
+        auto makeWorker = [&] () -> std::unique_ptr<Graph> {
+            auto wg = std::make_unique<Graph>();
+            wg->session = graph->session;
+            wg->subgraphNode = graph->subgraphNode;
+            wg->portalIns = graph->portalIns;
+            wg->portals = graph->portals;
+            for (auto const &[id, node]: graph->nodes) {
+                std::unique_ptr<INode> copy;
+                if (body.count(id)) {
+                    copy = node->nodeClass->new_instance();
+                    copy->inputBounds = node->inputBounds;
+                } else {
+                    copy = std::make_unique<LoopProxyNode>();
+                    for (auto const &[socket, obj]: node->outputs) {
+                        if (!obj || !invariants.count({id, socket}) || isShareable(obj.get())) {
+                            copy->outputs.emplace(socket, obj);
+                        } else if (auto clone = obj->clone()) {
+                            copy->outputs.emplace(socket, std::move(clone));
+                        } else {
+                            return nullptr;
+                        }
+                    }
+                }
+                copy->graph = wg.get();
+                copy->myname = id;
+                copy->nodeClass = node->nodeClass;
+                copy->inputs = node->inputs;
+                copy->kframes = node->kframes;
+                copy->formulas = node->formulas;
+                copy->formulaCache = node->formulaCache;
+                wg->nodes.emplace(id, std::move(copy));
+            }
+            for (auto const &id: body) {
+                wg->nodes.at(id)->doComplete();
+            }
+            return wg;
+        };
+
+        std::vector<std::unique_ptr<Graph>> idle;
+        if (auto wg = makeWorker())
+            idle.push_back(std::move(wg));
+        else
+            return false;
+        std::mutex idleMtx;
+
+        struct Iteration {
+            bool accept = true;
+            zany object;
+            zany list;
+        };
+        std::vector<Iteration> iters(list.size());
+        auto &pool = thread_pool::global();
+        pool.for_each_chunk(list.size(), pool.chunk_count(list.size()),
+                            [&] (std::size_t, std::size_t ibegin, std::size_t iend) {
+            // chunks outnumber threads for balance, a worker graph is only built per thread
+            std::unique_ptr<Graph> wg;
+            {
+                std::lock_guard lck(idleMtx);
+                if (!idle.empty()) {
+                    wg = std::move(idle.back());
+                    idle.pop_back();
+                }
+            }
+            if (!wg && !(wg = makeWorker()))
+                throw Exception("EndForEach: loop-invariant object can not be cloned\n");
+
+            auto pull = [&] (const char *ds) -> zany {
+                auto it = inputBounds.find(ds);
+                if (it == inputBounds.end())
+                    return nullptr;
+                wg->applyNode(it->second.first);
+                return wg->getNodeOutput(it->second.first, it->second.second);
+            };
+            auto begin = wg->nodes.at(sn).get();
+            for (auto i = ibegin; i < iend; i++) {
+                wg->ctx = std::make_unique<Context>();
+                auto index = std::make_shared<NumericObject>();
+                index->set((int)i);
+                begin->outputs["index"] = std::move(index);
+                begin->outputs["object"] = list[i];
+                auto &iter = iters[i];
+                if (auto accept = pull("accept"))
+                    iter.accept = evaluate_condition(accept.get());
+                iter.object = pull("object");
+                iter.list = pull("list");
+            }
+
+            std::lock_guard lck(idleMtx);
+            idle.push_back(std::move(wg));
+        });
+        fore->m_index = list.size();
+
+        bool hasObject = inputBounds.count("object");
+        for (auto &iter: iters) {
+            auto &res = iter.accept ? result : dropped_result;
+            if (hasObject)
+                res.push_back(std::move(iter.object));
+            if (iter.list) {
+                for (auto const &obj: safe_dynamic_cast<ListObject>(iter.list, "list of EndForEach ")->arr)
+                    res.push_back(obj);
+            }
+        }
+        return true;
+    }
+
     virtual void preApply() override {
-        EndFor::preApply();
+        if (!(has_input("parallel:") && get_param<bool>("parallel")) || !parallelApply())
+            EndFor::preApply();
         if (get_param<bool>("doConcat")) {
             decltype(result) newres;
             for (auto &xs: result) {
@@ -243,7 +429,7 @@ struct EndForEach : EndFor {
 ZENDEFNODE(EndForEach, {
     {"object", "list", "accumate", {"bool", "accept", "1"}, "FOR"},
     {"list", "droppedList", "accumate"},
-    {{"bool", "doConcat", "0"}},
+    {{"bool", "doConcat", "0"}, {"bool", "parallel", "0"}},
     {"control"},
 });
 
@@ -323,6 +509,10 @@ ZENDEFNODE(SubstepDt, {
 
 
 struct IfElse : zeno::INode {
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         requireInput("cond");
         auto cond = get_input("cond");
@@ -15,6 +15,10 @@ namespace zeno {
 namespace {
 
 struct CacheToDisk : zeno::INode {
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         if (auto it = inputBounds.find("object"); it != inputBounds.end()) {
             auto snid = it->second.first;
@@ -36,6 +36,10 @@ ZENDEFNODE(FuncBegin, {
 
 
 struct FuncEnd : zeno::ContextManagedNode {
+    virtual bool hasReentrantOutputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         FuncBegin *fore = nullptr;
         if (auto it = inputBounds.find("FUNC"); it != inputBounds.end()) {
@@ -102,6 +106,10 @@ ZENDEFNODE(FuncSimpleBegin, {
 
 
 struct FuncSimpleEnd : zeno::ContextManagedNode {
+    virtual bool hasReentrantOutputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         FuncSimpleBegin *fore = nullptr;
         if (auto it = inputBounds.find("FUNC"); it != inputBounds.end()) {
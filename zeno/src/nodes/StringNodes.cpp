@@ -41,6 +41,10 @@ ZENDEFNODE(MakeReadPath, {
 });
 
 struct MakeString : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::StringObject>();
         obj->set(get_param<std::string>("value"));
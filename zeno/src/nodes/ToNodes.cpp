@@ -95,6 +95,10 @@ ZENDEFNODE(HelperMute, {
 struct HelperOnce : zeno::INode {
     bool m_done = false;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         if (!m_done) {
             INode::preApply();
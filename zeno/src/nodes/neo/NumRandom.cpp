@@ -183,6 +183,10 @@ static NumericValue numRandom(vec3f dir, std::string randType, float base, float
 namespace {
 
 struct NumRandom : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         auto dir = get_input2<vec3f>("dir");
         auto base = get_input2<float>("base");
@@ -237,6 +241,10 @@ ZENDEFNODE(NumRandomSeedCombine, {
 });
 
 struct NumRandomInt : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         int valmin = get_input2<int>("valmin");
         int valmax = get_input2<int>("valmax");
@@ -264,6 +272,10 @@ ZENDEFNODE(NumRandomInt, {
 });
 
 struct NumRandomFloat : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         float valmin = get_input2<float>("valmin");
         float valmax = get_input2<float>("valmax");
@@ -0,0 +1,393 @@
+#include <zeno/zeno.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
+#include <zeno/para/parallel_reduce.h>
+#include <zeno/utils/variantswitch.h>
+#include <zeno/utils/arrayindex.h>
+#include <zeno/utils/morton.h>
+#include <zeno/utils/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace zeno {
+namespace {
+
+template <class T>
+struct meth_oneof {
+    T value{};
+    bool any{false};
+
+    void add(T x) {
+        if (!any)
+            value = x;
+        any = true;
+    }
+
+    T get() {
+        return value;
+    }
+};
+
+template <class T>
+struct meth_sum {
+    T value{0};
+
+    void add(T x) {
+        value += x;
+    }
+
+    T get() {
+        return value;
+    }
+};
+
+template <class T>
+struct meth_average {
+    T value{0};
+    int count{0};
+
+    void add(T x) {
+        value += x;
+        ++count;
+    }
+
+    T get() {
+        return value / (T)count;
+    }
+};
+
+template <class T>
+struct meth_min {
+    T value{std::numeric_limits<decay_vec_t<T>>::max()};
+
+    void add(T x) {
+        value = zeno::min(value, x);
+    }
+
+    T get() {
+        return value;
+    }
+};
+
+template <class T>
+struct meth_max {
+    T value{std::numeric_limits<decay_vec_t<T>>::lowest()};
+
+    void add(T x) {
+        value = zeno::max(value, x);
+    }
+
+    T get() {
+        return value;
+    }
+};
+
+// drop the elements of arr, attributes included, whose keep[i] is 0
+template <class T>
+void compactAttrVector(AttrVector<T> &arr, std::vector<int> const &keep) {
+    std::vector<int> newIdx(keep.size());
+    int n = parallel_exclusive_scan(0, (int)keep.size(), newIdx.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, [&] (int i) {
+        return keep[i];
+    });
+    if (n == (int)keep.size())
+        return;
+    auto compact = [&] (auto &vals) {
+        std::decay_t<decltype(vals)> newVals(n);
+        parallel_for(keep.size(), [&] (size_t i) {
+            if (keep[i])
+                newVals[newIdx[i]] = vals[i];
+        });
+        vals = std::move(newVals);
+    };
+    compact(arr.values);
+    arr.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &vals) {
+        compact(vals);
+    });
+}
+
+}
+
+ZENO_API int primFuse(PrimitiveObject *prim, float distance, std::string method) {
+    int n = prim->verts.size();
+    if (!n)
+        return 0;
+
+    // cells at least as wide as the distance, so that close pairs are in neighbouring cells,
+    // and at most 2^20 of them per axis to fit a 64-bit morton code
+    auto [bmin, bmax] = parallel_reduce_minmax(prim->verts.begin(), prim->verts.end());
+    float extent = zeno::max(bmax[0] - bmin[0], zeno::max(bmax[1] - bmin[1], bmax[2] - bmin[2]));
+    float cellSize = std::max(distance, extent / float(1 << 20));
+    if (!(cellSize > 0))
+        cellSize = 1;
+    float invCell = 1 / cellSize;
+    int const maxCell = (1 << 21) - 1;
+    auto cellOf = [&] (vec3f const &p) {
+        vec3f c = (p - bmin) * invCell;
+        return vec3i(std::min((int)c[0], maxCell), std::min((int)c[1], maxCell), std::min((int)c[2], maxCell));
+    };
+    auto codeOf = [] (vec3i const &c) -> std::uint64_t {
+        return morton3d::encode(c[0], c[1], c[2]);
+    };
+
+    std::vector<std::pair<std::uint64_t, int>> sorted(n);
+    parallel_for(n, [&] (int i) {
+        sorted[i] = {codeOf(cellOf(prim->verts[i])), i};
+    });
+    parallel_sort(sorted.begin(), sorted.end(), [] (auto const &a, auto const &b) {
+        return a < b;
+    });
+
+    // cellBegin[k] is where the k-th occupied cell starts in sorted
+    std::vector<int> cellIdx(n);
+    int ncells = parallel_exclusive_scan(0, n, cellIdx.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, [&] (int i) {
+        return (int)(i == 0 || sorted[i].first != sorted[i - 1].first);
+    });
+    std::vector<std::uint64_t> cellCode(ncells);
+    std::vector<int> cellBegin(ncells + 1);
+    cellBegin[ncells] = n;
+    parallel_for(n, [&] (int i) {
+        if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+            cellCode[cellIdx[i]] = sorted[i].first;
+            cellBegin[cellIdx[i]] = i;
+        }
+    });
+
+    // same lock-free union-find as primMarkIsland, so clusters are rooted at their lowest vert
+    std::vector<std::atomic<int>> found(n);
+    parallel_for(n, [&] (int i) {
+        found[i].store(i, std::memory_order_relaxed);
+    });
+    auto find = [&] (int i) {
+        int p = found[i].load(std::memory_order_relaxed);
+        while (p != i) {
+            int gp = found[p].load(std::memory_order_relaxed);
+            if (gp != p)
+                found[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+            p = found[i].load(std::memory_order_relaxed);
+        }
+        return i;
+    };
+    auto unite = [&] (int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            int expected = a;
+            if (found[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                return;
+        }
+    };
+
+    // each pair of cells is visited once, from the one with the lower code
+    float dist2 = distance * distance;
+    parallel_for(ncells, [&] (int k) {
+        vec3i c = cellOf(prim->verts[sorted[cellBegin[k]].second]);
+        for (int dz = -1; dz <= 1; dz++) for (int dy = -1; dy <= 1; dy++) for (int dx = -1; dx <= 1; dx++) {
+            vec3i nc = c + vec3i(dx, dy, dz);
+            if (nc[0] < 0 || nc[1] < 0 || nc[2] < 0 || nc[0] > maxCell || nc[1] > maxCell || nc[2] > maxCell)
+                continue;
+            auto code = codeOf(nc);
+            if (code < cellCode[k])
+                continue;
+            auto it = std::lower_bound(cellCode.begin() + k, cellCode.end(), code);
+            if (it == cellCode.end() || *it != code)
+                continue;
+            int l = it - cellCode.begin();
+            for (int a = cellBegin[k]; a < cellBegin[k + 1]; a++) {
+                int i = sorted[a].second;
+                vec3f p = prim->verts[i];
+                for (int b = l == k ? a + 1 : cellBegin[l]; b < cellBegin[l + 1]; b++) {
+                    int j = sorted[b].second;
+                    if (lengthSquared(prim->verts[j] - p) <= dist2)
+                        unite(i, j);
+                }
+            }
+        }
+    });
+
+    // clusters numbered in order of their lowest vert, with their verts ascending
+    std::vector<int> rootId(n);
+    int nclusters = parallel_exclusive_scan(0, n, rootId.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, [&] (int i) {
+        return (int)(find(i) == i);
+    });
+    if (nclusters == n)
+        return n;
+    std::vector<int> unrevamp(n);
+    parallel_for(n, [&] (int i) {
+        unrevamp[i] = rootId[find(i)];
+    });
+    std::vector<std::atomic<int>> cursor(nclusters);
+    parallel_for(nclusters, [&] (int k) {
+        cursor[k].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(n, [&] (int i) {
+        cursor[unrevamp[i]].fetch_add(1, std::memory_order_relaxed);
+    });
+    std::vector<int> clusterBegin(nclusters + 1);
+    clusterBegin[nclusters] = parallel_exclusive_scan(0, nclusters, clusterBegin.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, [&] (int k) {
+        return cursor[k].load(std::memory_order_relaxed);
+    });
+    parallel_for(nclusters, [&] (int k) {
+        cursor[k].store(clusterBegin[k], std::memory_order_relaxed);
+    });
+    std::vector<int> members(n);
+    parallel_for(n, [&] (int i) {
+        members[cursor[unrevamp[i]].fetch_add(1, std::memory_order_relaxed)] = i;
+    });
+    parallel_for(nclusters, [&] (int k) {
+        std::sort(members.begin() + clusterBegin[k], members.begin() + clusterBegin[k + 1]);
+    });
+
+    auto reduce = [&] (auto &arr, auto reducerTy) {
+        using T = std::decay_t<decltype(arr[0])>;
+        std::vector<T> newArr(nclusters);
+        parallel_for(nclusters, [&] (int k) {
+            decltype(reducerTy) reducer;
+            for (int m = clusterBegin[k]; m < clusterBegin[k + 1]; m++)
+                reducer.add(arr[members[m]]);
+            newArr[k] = reducer.get();
+        });
+        arr = std::move(newArr);
+    };
+    // positions are averaged unless picked, summing or bounding them makes no sense
+    if (method == "oneof")
+        reduce(prim->verts.values, meth_oneof<vec3f>{});
+    else
+        reduce(prim->verts.values, meth_average<vec3f>{});
+    prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        std::visit([&] (auto reducerTy) {
+            reduce(arr, reducerTy);
+        }, enum_variant<std::variant<
+            meth_oneof<T>, meth_sum<T>, meth_average<T>, meth_min<T>, meth_max<T>
+        >>(array_index({
+            "oneof", "sum", "average", "min", "max"
+        }, method)));
+    });
+
+    auto repair = [&] (int &x) {
+        if (x >= 0 && x < n)
+            x = unrevamp[x];
+    };
+
+    parallel_for(prim->points.size(), [&] (size_t i) {
+        repair(prim->points[i]);
+    });
+
+    // faces left with fewer distinct verts than a face of their kind needs are dropped
+    auto fixFaces = [&] (auto &faces, int minVerts) {
+        std::vector<int> keep(faces.size());
+        parallel_for(faces.size(), [&] (size_t i) {
+            auto &ind = faces[i];
+            constexpr int N = std::tuple_size_v<std::decay_t<decltype(ind)>>;
+            for (int j = 0; j < N; j++)
+                repair(ind[j]);
+            int ndistinct = 0;
+            for (int j = 0; j < N; j++)
+                ndistinct += std::find(&ind[0], &ind[0] + j, ind[j]) == &ind[0] + j;
+            keep[i] = ndistinct >= minVerts;
+        });
+        compactAttrVector(faces, keep);
+    };
+    fixFaces(prim->lines, 2);
+    fixFaces(prim->edges, 2);
+    fixFaces(prim->tris, 3);
+    fixFaces(prim->quads, 3);
+
+    // polygons lose the loops repeating the one before them, cyclically
+    if (prim->polys.size()) {
+        parallel_for(prim->loops.size(), [&] (size_t i) {
+            repair(prim->loops[i]);
+        });
+        std::vector<int> keepLoop(prim->loops.size());
+        std::vector<int> keepPoly(prim->polys.size());
+        parallel_for(prim->polys.size(), [&] (size_t i) {
+            auto [base, len] = prim->polys[i];
+            if (len <= 0)
+                return;
+            int last = base;
+            keepLoop[base] = 1;
+            for (int l = base + 1; l < base + len; l++) {
+                if (prim->loops[l] != prim->loops[last]) {
+                    keepLoop[l] = 1;
+                    last = l;
+                }
+            }
+            int cnt = 0;
+            for (int l = base; l < base + len; l++)
+                cnt += keepLoop[l];
+            if (cnt > 1 && prim->loops[last] == prim->loops[base]) {
+                keepLoop[last] = 0;
+                --cnt;
+            }
+            keepPoly[i] = cnt >= 3;
+            if (!keepPoly[i]) {
+                for (int l = base; l < base + len; l++)
+                    keepLoop[l] = 0;
+            } else {
+                prim->polys[i][1] = cnt;
+            }
+        });
+        compactAttrVector(prim->loops, keepLoop);
+        compactAttrVector(prim->polys, keepPoly);
+        std::vector<int> bases(prim->polys.size());
+        parallel_exclusive_scan(0, (int)prim->polys.size(), bases.begin(), 0, [] (int x, int y) {
+            return x + y;
+        }, [&] (int i) {
+            return prim->polys[i][1];
+        });
+        parallel_for(prim->polys.size(), [&] (size_t i) {
+            prim->polys[i][0] = bases[i];
+        });
+    }
+
+    prim->verts.resize(nclusters);
+    return nclusters;
+}
+
+namespace {
+
+struct PrimFuse : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto distance = get_input2<float>("distance");
+        auto method = get_input2<std::string>("method");
+        int oldSize = prim->verts.size();
+        int newSize = primFuse(prim.get(), distance, method);
+        zeno::log_info("PrimFuse: collapse from {} to {}", oldSize, newSize);
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(PrimFuse, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"float", "distance", "0.001"},
+    {"enum oneof average sum min max", "method", "average"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+}
+}
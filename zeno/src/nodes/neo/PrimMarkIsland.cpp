@@ -3,60 +3,86 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/NumericObject.h>
-#include <zeno/utils/tuple_hash.h>
-#include <unordered_map>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <atomic>
 
 namespace zeno {
 
-ZENO_API void primMarkIsland(PrimitiveObject *prim, std::string tagAttr) {
+ZENO_API std::vector<int> primMarkIsland(PrimitiveObject *prim, std::string tagAttr) {
     // Oh, I mean, Tesla was a great DJ
     auto &tagVert = prim->add_attr<int>(tagAttr);
-    auto m = tagVert.size();
-    std::vector<int> found(m);
-    for (int i = 0; i < m; i++) {
-        found[i] = i;
-    }
+    int m = tagVert.size();
+
+    // lock-free union-find, always linking the higher root under the lower one, so
+    // that every island ends up rooted at its lowest vert whatever the thread timing
+    std::vector<std::atomic<int>> found(m);
+    parallel_for(m, [&] (int i) {
+        found[i].store(i, std::memory_order_relaxed);
+    });
     auto find = [&] (int i) {
-        while (i != found[i])
-            i = found[i];
+        int p = found[i].load(std::memory_order_relaxed);
+        while (p != i) {
+            int gp = found[p].load(std::memory_order_relaxed);
+            if (gp != p)  // path halving, losing this race to another thread is harmless
+                found[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+            p = found[i].load(std::memory_order_relaxed);
+        }
         return i;
     };
-    for (int i = 0; i < prim->lines.size(); i++) {
+    auto unite = [&] (int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            int expected = a;
+            if (found[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                return;
+        }
+    };
+
+    parallel_for(prim->lines.size(), [&] (size_t i) {
         auto ind = prim->lines[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        found[e1] = e0;
-    }
-    for (int i = 0; i < prim->tris.size(); i++) {
+        unite(ind[0], ind[1]);
+    });
+    parallel_for(prim->tris.size(), [&] (size_t i) {
         auto ind = prim->tris[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        found[e1] = e0;
-        found[e2] = e0;
-    }
-    for (int i = 0; i < prim->quads.size(); i++) {
+        unite(ind[0], ind[1]);
+        unite(ind[0], ind[2]);
+    });
+    parallel_for(prim->quads.size(), [&] (size_t i) {
         auto ind = prim->quads[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        int e3 = find(ind[3]);
-        found[e1] = e0;
-        found[e2] = e0;
-        found[e3] = e0;
-    }
-    for (int i = 0; i < prim->polys.size(); i++) {
+        unite(ind[0], ind[1]);
+        unite(ind[0], ind[2]);
+        unite(ind[0], ind[3]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
         auto [base, len] = prim->polys[i];
-        if (len <= 1) continue;
-        int e0 = find(prim->loops[base]);
-        for (int j = base + 1; j < base + len; j++) {
-            int ej = find(prim->loops[j]);
-            found[ej] = e0;
-        }
-    }
-    for (int i = 0; i < m; i++) {
-        tagVert[i] = find(i);
-    }
+        for (int j = base + 1; j < base + len; j++)
+            unite(prim->loops[base], prim->loops[j]);
+    });
+
+    // roots numbered in vert order give compact ids, counted in the same pass as tagging
+    std::vector<int> rootId(m);
+    int nislands = parallel_exclusive_scan(0, m, rootId.begin(), 0, [] (int x, int y) {
+        return x + y;
+    }, [&] (int i) {
+        return (int)(found[i].load(std::memory_order_relaxed) == i);
+    });
+    std::vector<std::atomic<int>> counts(nislands);
+    parallel_for(nislands, [&] (int k) {
+        counts[k].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(m, [&] (int i) {
+        int id = rootId[find(i)];
+        tagVert[i] = id;
+        counts[id].fetch_add(1, std::memory_order_relaxed);
+    });
+    return std::vector<int>(counts.begin(), counts.end());
 }
 
 namespace {
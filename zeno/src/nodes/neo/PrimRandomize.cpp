@@ -200,6 +200,10 @@ ZENO_API void primRandomize(PrimitiveObject *prim, std::string attr, std::string
 namespace {
 
 struct PrimRandomize : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         auto base = get_input2<float>("base");
@@ -209,6 +209,10 @@ ZENO_API std::shared_ptr<PrimitiveObject> primScatter(
 namespace {
 
 struct PrimScatter : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         auto type = get_input2<std::string>("type");
@@ -73,6 +73,10 @@ ZENDEFNODE(PrimSimplifyTag, {
 });
 
 struct PrimColorByTag : INode {
+    virtual bool isPure() const override {
+        return get_input2<int>("seed") != -1;  // -1 picks a random seed
+    }
+
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         auto tagAttr = get_input<StringObject>("tagAttr")->get();
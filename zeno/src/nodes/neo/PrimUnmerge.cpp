@@ -3,152 +3,147 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/ListObject.h>
 #include <zeno/types/StringObject.h>
-#include <zeno/para/parallel_reduce.h>
 #include <zeno/para/parallel_for.h>
+#include <type_traits>
 
 namespace zeno {
 
-ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
-    if (!prim->verts.size()) return {};
+namespace {
 
-    auto const &tagArr = prim->verts.attr<int>(tagAttr);
-    int tagMax = parallel_reduce_max(tagArr.begin(), tagArr.end()) + 1;
+// where each element of an AttrVector goes: the island, or -1 to drop it, and its index there
+struct Placement {
+    std::vector<int> island;
+    std::vector<int> local;
+    std::vector<int> counts;
+
+    void place(size_t i, int k) {
+        island[i] = k;
+        if (k < 0)
+            return;
+        if (k >= (int)counts.size())
+            counts.resize(k + 1);
+        local[i] = counts[k]++;
+    }
+
+    explicit Placement(size_t n) : island(n, -1), local(n) {}
+};
 
-    std::vector<std::shared_ptr<PrimitiveObject>> primList(tagMax);
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag] = std::make_shared<PrimitiveObject>();
+// copies the elements of src and their attributes into the islands, values go through remap(i, value)
+template <class T, class Remap>
+void scatterToIslands(AttrVector<T> const &src, AttrVector<T> PrimitiveObject::*member,
+                      std::vector<std::shared_ptr<PrimitiveObject>> const &primList,
+                      Placement const &place, Remap const &remap) {
+    int nislands = primList.size();
+    std::vector<T *> dsts(nislands);
+    for (int k = 0; k < nislands; k++) {
+        auto &dst = primList[k].get()->*member;
+        dst.resize(k < (int)place.counts.size() ? place.counts[k] : 0);
+        dsts[k] = dst.values.data();
     }
+    parallel_for(src.size(), [&] (size_t i) {
+        if (int k = place.island[i]; k >= 0)
+            dsts[k][place.local[i]] = remap(i, src[i]);
+    });
+    src.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using U = std::decay_t<decltype(arr[0])>;
+        std::vector<U *> adsts(nislands);
+        for (int k = 0; k < nislands; k++) {
+            adsts[k] = (primList[k].get()->*member).template add_attr<U>(key).data();
+        }
+        parallel_for(src.size(), [&] (size_t i) {
+            if (int k = place.island[i]; k >= 0)
+                adsts[k][place.local[i]] = arr[i];
+        });
+    });
+}
 
-#if 1
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag]->assign(prim);
-        primFilterVerts(primList[tag].get(), tagAttr, tag);
+// island shared by all the verts of a face, -1 if they differ
+template <class T>
+int faceIsland(T const &ind, std::vector<int> const &vertIsland) {
+    if constexpr (std::is_same_v<T, int>) {
+        return vertIsland[ind];
+    } else {
+        int k = vertIsland[ind[0]];
+        for (int j = 1; j < is_vec_n<T>; j++) {
+            if (vertIsland[ind[j]] != k)
+                return -1;
+        }
+        return k;
     }
+}
 
-#else
-    std::vector<std::vector<int>> vert_revamp(tagMax);
-    std::vector<int> vert_unrevamp(prim->verts.size());
+}
+
+ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
+    if (!prim->verts.size()) return {};
 
+    // one pass over the verts finds the island count, their sizes and where each vert goes,
+    // verts with a negative tag are dropped
+    auto const &tagArr = prim->verts.attr<int>(tagAttr);
+    Placement vertPlace(prim->verts.size());
     for (size_t i = 0; i < prim->verts.size(); i++) {
-        int tag = tagArr[i];
-        vert_revamp[tag].push_back(i);
-        vert_unrevamp[i] = tag;
+        vertPlace.place(i, tagArr[i] < 0 ? -1 : tagArr[i]);
     }
-
-    for (int tag = 0; tag < tagMax; tag++) {
-        auto &revamp = vert_revamp[tag];
-        auto const &outprim = primList[tag];
-
-        outprim->verts.resize(revamp.size());
-        parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-            outprim->verts[i] = prim->verts[revamp[i]];
-        });
-        prim->verts.foreach_attr([&] (auto const &key, auto const &inarr) {
-            using T = std::decay_t<decltype(inarr[0])>;
-            auto &outarr = outprim->verts.add_attr<T>(key);
-            parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                outarr[i] = inarr[revamp[i]];
-            });
-        });
+    int nislands = vertPlace.counts.size();
+
+    // what is not split by vert is shared by all the islands
+    PrimitiveObject shell;
+    static_cast<IObject &>(shell) = static_cast<IObject const &>(*prim);
+    shell.uvs = prim->uvs;
+    shell.mtl = prim->mtl;
+    shell.inst = prim->inst;
+    std::vector<std::shared_ptr<PrimitiveObject>> primList(nislands);
+    for (int k = 0; k < nislands; k++) {
+        primList[k] = std::make_shared<PrimitiveObject>(shell);
     }
 
-    std::vector<std::vector<int>> face_revamp;
-
-    auto mock = [&] (auto getter) {
-        auto &prim_tris = getter(prim);
-        if (prim_tris.size()) {
-            face_revamp.clear();
-            face_revamp.resize(tagMax);
-            using T = std::decay_t<decltype(prim_tris[0])>;
-
-            for (size_t i = 0; i < prim_tris.size(); i++) {
-                auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[i]);
-                int tag = vert_unrevamp[ind[0]];
-                bool bad = false;
-                for (int j = 1; j < is_vec_n<T>; j++) {
-                    int new_tag = vert_unrevamp[ind[j]];
-                    if (tag != new_tag) {
-                        bad = true;
-                        break;
-                    }
-                }
-                if (!bad) face_revamp[tag].push_back(i);
-            }
-
-            for (int tag = 0; tag < tagMax; tag++) {
-                auto &revamp = face_revamp[tag];
-                auto &v_revamp = vert_revamp[tag];
-                auto *outprim = primList[tag].get();
-                auto &outprim_tris = getter(outprim);
-
-                outprim_tris.resize(revamp.size());
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[revamp[i]]);
-                    auto outind = reinterpret_cast<decay_vec_t<T> *>(&outprim_tris[i]);
-                    for (int j = 0; j < is_vec_n<T>; j++) {
-                        outind[j] = v_revamp[ind[j]];
-                    }
-                });
-
-                prim_tris.foreach_attr([&] (auto const &key, auto const &inarr) {
-                    using T = std::decay_t<decltype(inarr[0])>;
-                    auto &outarr = outprim_tris.template add_attr<T>(key);
-                    parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                        outarr[i] = inarr[revamp[i]];
-                    });
-                });
-            }
+    scatterToIslands(prim->verts, &PrimitiveObject::verts, primList, vertPlace, [&] (size_t, vec3f const &pos) {
+        return pos;
+    });
+
+    // a face goes to the island of its verts, if they are all in the same one
+    auto remapInd = [&] (size_t, auto ind) {
+        if constexpr (std::is_same_v<decltype(ind), int>) {
+            return vertPlace.local[ind];
+        } else {
+            for (int j = 0; j < is_vec_n<decltype(ind)>; j++)
+                ind[j] = vertPlace.local[ind[j]];
+            return ind;
         }
     };
-    mock([] (auto &&p) -> auto & { return p->points; });
-    mock([] (auto &&p) -> auto & { return p->lines; });
-    mock([] (auto &&p) -> auto & { return p->tris; });
-    mock([] (auto &&p) -> auto & { return p->quads; });
-
-    if (prim->polys.size()) {
-        face_revamp.clear();
-        face_revamp.resize(tagMax);
-
-        for (size_t i = 0; i < prim->polys.size(); i++) {
-            auto &[base, len] = prim->polys[i];
-            if (len <= 0) continue;
-            int tag = vert_unrevamp[prim->loops[base]];
-            bool bad = false;
-            for (int j = base + 1; j < base + len; i++) {
-                int new_tag = vert_unrevamp[prim->loops[j]];
-                if (tag != new_tag) {
-                    bad = true;
-                    break;
-                }
-            }
-            if (!bad) face_revamp[tag].push_back(i);
+    auto splitFaces = [&] (auto member) {
+        auto const &faces = prim->*member;
+        Placement place(faces.size());
+        for (size_t i = 0; i < faces.size(); i++) {
+            place.place(i, faceIsland(faces[i], vertPlace.island));
         }
-
-        for (int tag = 0; tag < tagMax; tag++) {
-            auto &revamp = face_revamp[tag];
-            auto &v_revamp = vert_revamp[tag];
-            auto *outprim = primList[tag].get();
-
-            outprim->polys.resize(revamp.size());
-            for (size_t i = 0; i < revamp.size(); i++) {
-                auto const &[base, len] = prim->polys[revamp[i]];
-                int new_base = outprim->loops.size();
-                for (int j = base; j < base + len; j++) {
-                    outprim->loops.push_back(prim->loops[j]);
-                }
-                outprim->polys[i] = {new_base, len};
-            }
-
-            prim->polys.foreach_attr([&] (auto const &key, auto const &inarr) {
-                using T = std::decay_t<decltype(inarr[0])>;
-                auto &outarr = outprim->polys.add_attr<T>(key);
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    outarr[i] = inarr[revamp[i]];
-                });
-            });
+        scatterToIslands(faces, member, primList, place, remapInd);
+    };
+    splitFaces(&PrimitiveObject::points);
+    splitFaces(&PrimitiveObject::lines);
+    splitFaces(&PrimitiveObject::tris);
+    splitFaces(&PrimitiveObject::quads);
+    splitFaces(&PrimitiveObject::edges);
+
+    // polys take their loops along, which are packed again in each island
+    Placement polyPlace(prim->polys.size());
+    Placement loopPlace(prim->loops.size());
+    for (size_t i = 0; i < prim->polys.size(); i++) {
+        auto [base, len] = prim->polys[i];
+        int k = len > 0 ? vertPlace.island[prim->loops[base]] : -1;
+        for (int l = base + 1; l < base + len && k >= 0; l++) {
+            if (vertPlace.island[prim->loops[l]] != k)
+                k = -1;
+        }
+        polyPlace.place(i, k);
+        for (int l = base; l < base + len; l++) {
+            loopPlace.place(l, k);
         }
     }
-#endif
+    scatterToIslands(prim->loops, &PrimitiveObject::loops, primList, loopPlace, remapInd);
+    scatterToIslands(prim->polys, &PrimitiveObject::polys, primList, polyPlace, [&] (size_t i, vec2i const &poly) {
+        return vec2i(poly[1] > 0 ? loopPlace.local[poly[0]] : 0, poly[1]);
+    });
 
     return primList;
 }
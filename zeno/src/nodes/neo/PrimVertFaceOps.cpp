@@ -2,6 +2,8 @@
 #include <zeno/types/StringObject.h>
 #include <zeno/types/PrimitiveObject.h>
 #include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/funcs/PrimitiveAdjacency.h>
+#include <zeno/para/parallel_for.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/arrayindex.h>
 #include <cmath>
@@ -64,6 +66,8 @@ struct meth_max {
 };
 
 struct face_lines {
+    static constexpr int type = PrimAdjacency::Lines;
+
     static auto &from_prim(PrimitiveObject *prim) {
         return prim->lines;
     }
@@ -76,6 +80,8 @@ struct face_lines {
 };
 
 struct face_tris {
+    static constexpr int type = PrimAdjacency::Tris;
+
     static auto &from_prim(PrimitiveObject *prim) {
         return prim->tris;
     }
@@ -89,6 +95,8 @@ struct face_tris {
 };
 
 struct face_quads {
+    static constexpr int type = PrimAdjacency::Quads;
+
     static auto &from_prim(PrimitiveObject *prim) {
         return prim->quads;
     }
@@ -103,6 +111,8 @@ struct face_quads {
 };
 
 struct face_polys {
+    static constexpr int type = PrimAdjacency::Polys;
+
     static auto &from_prim(PrimitiveObject *prim) {
         return prim->polys;
     }
@@ -187,26 +197,24 @@ struct PrimFacesAttrToVerts : INode {
                 using T = std::decay_t<decltype(facesArr[0])>;
                 auto &vertsArr = prim->verts.add_attr<T>(attrOut);
 
-                std::vector<std::vector<int>> v2f(prim->verts.size());
-                for (int i = 0; i < prim_faces.size(); i++) { // todo: parallel_push_back_multi
-                    faceTy.foreach_ind(prim.get(), prim_faces[i], [&] (int ind) {
-                        v2f[ind].push_back(i);
-                    });
-                }
+                auto adj = primAdjacency(prim.get());
+                int faceBase = adj->faceBegin[faceTy.type];
+                int faceEnd = adj->faceBegin[faceTy.type + 1];
 
                 auto deflVal = deflValPtr->get<T>();
                 std::visit([&] (auto reducerTy) {
-                    for (int i = 0; i < prim->verts.size(); i++) {
-                        if (v2f[i].empty()) {
-                            vertsArr[i] = deflVal;
-                        } else {
-                            decltype(reducerTy) reducer;
-                            for (auto l: v2f[i]) {
-                                reducer.add(facesArr[l]);
+                    parallel_for(prim->verts.size(), [&] (size_t i) {
+                        decltype(reducerTy) reducer;
+                        bool any = false;
+                        adj->foreach_vert_corner(i, [&] (int c) {
+                            int f = adj->cornerFace[c];
+                            if (f >= faceBase && f < faceEnd) {
+                                reducer.add(facesArr[f - faceBase]);
+                                any = true;
                             }
-                            vertsArr[i] = reducer.get();
-                        }
-                    }
+                        });
+                        vertsArr[i] = any ? reducer.get() : deflVal;
+                    });
                 }, enum_variant<std::variant<
                     meth_sum<T>, meth_average<T>, meth_min<T>, meth_max<T>
                 >>(array_index({
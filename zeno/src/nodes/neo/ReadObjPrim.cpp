@@ -3,23 +3,24 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/string.h>
-#include <zeno/utils/fileio.h>
+#include <zeno/utils/mapped_file.h>
 #include <zeno/utils/logger.h>
 #include <zeno/utils/vec.h>
+#include <zeno/para/thread_pool.h>
+#include <filesystem>
 #include <string_view>
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <cassert>
 #include <cstdio>
-#include <fstream>
 
 namespace zeno {
 namespace {
 
 template <std::size_t ...Is>
-static bool match_helper(char const *&it, char const *arr, std::index_sequence<Is...>) {
-    if (((it[Is] == arr[Is]) && ...)) {
+static bool match_helper(char const *&it, char const *eit, char const *arr, std::index_sequence<Is...>) {
+    if (eit - it >= (std::ptrdiff_t)sizeof...(Is) && ((it[Is] == arr[Is]) && ...)) {
         it += sizeof...(Is);
         return true;
     } else {
@@ -28,109 +29,255 @@ static bool match_helper(char const *&it, char const *arr, std::index_sequence<I
 }
 
 template <std::size_t N>
-static bool match(char const *&it, char const (&arr)[N]) {
-    return match_helper(it, arr, std::make_index_sequence<N - 1>{});
+static bool match(char const *&it, char const *eit, char const (&arr)[N]) {
+    return match_helper(it, eit, arr, std::make_index_sequence<N - 1>{});
 }
 
-static float takef(char const *&it) {
-    char *eptr;
-    float val = std::strtof(it, &eptr);
-    it = eptr;
-    return val;
+static bool isblank(char c) {
+    return c == ' ' || c == '\t';
 }
 
-static int takeu(char const *&it) {
+static void skipblank(char const *&it, char const *eit) {
+    while (it != eit && isblank(*it))
+        ++it;
+}
+
+// Clinger's fast path: exact whenever the significant digits and the power of ten are exact
+// in float (or double, rounded once more to float), which is what exporters write; the rest
+// (long mantissas, huge exponents, inf, nan) goes through strtof
+static float takef(char const *&it, char const *eit) {
+    skipblank(it, eit);
+    char const *p = it;
+    bool neg = false;
+    if (p != eit && (*p == '-' || *p == '+'))
+        neg = *p++ == '-';
+    std::uint64_t mant = 0;
+    int digits = 0, exp10 = 0;
+    bool any = false, exact = true;
+    auto digit = [&] (int d, bool frac) {
+        any = true;
+        if (mant == 0 && d == 0) {
+            exp10 -= frac;
+        } else if (digits < 19) {
+            mant = mant * 10 + d;
+            digits++;
+            exp10 -= frac;
+        } else {
+            exact = false;
+        }
+    };
+    for (; p != eit && *p >= '0' && *p <= '9'; ++p)
+        digit(*p - '0', false);
+    if (p != eit && *p == '.') {
+        for (++p; p != eit && *p >= '0' && *p <= '9'; ++p)
+            digit(*p - '0', true);
+    }
+    if (any && p != eit && (*p == 'e' || *p == 'E')) {
+        char const *q = p + 1;
+        bool eneg = false;
+        if (q != eit && (*q == '-' || *q == '+'))
+            eneg = *q++ == '-';
+        if (q != eit && *q >= '0' && *q <= '9') {
+            int e = 0;
+            for (; q != eit && *q >= '0' && *q <= '9'; ++q)
+                e = std::min(e * 10 + (*q - '0'), 100000);
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+
+    static constexpr float fpow10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    static constexpr double dpow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (any && exact && mant <= (1u << 24) && exp10 >= -10 && exp10 <= 10) {
+        float v = (float)mant;
+        v = exp10 < 0 ? v / fpow10[-exp10] : v * fpow10[exp10];
+        it = p;
+        return neg ? -v : v;
+    }
+    if (any && exact && mant <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+        double v = (double)mant;
+        v = exp10 < 0 ? v / dpow10[-exp10] : v * dpow10[exp10];
+        it = p;
+        return (float)(neg ? -v : v);
+    }
+
+    // the mapped file isn't null-terminated, so strtof gets a copy of the token
+    char const *tend = std::find_if(it, eit, [] (char c) { return isblank(c) || c == '\n' || c == '\r'; });
+    std::string token(it, tend);
     char *eptr;
-    int val(std::strtoul(it, &eptr, 10));
-    it = eptr;
+    float val = std::strtof(token.c_str(), &eptr);
+    it += eptr - token.c_str();
     return val;
 }
 
-std::shared_ptr<PrimitiveObject> parse_obj(std::vector<char> &&bin) {
-    /*bin.resize(bin.size() + 8, '\0');*/
-
-    char const *it = bin.data();
-    char const *eit = bin.data() + bin.size();// - 8;
+static int takei(char const *&it, char const *eit) {
+    skipblank(it, eit);
+    bool neg = false;
+    if (it != eit && (*it == '-' || *it == '+'))
+        neg = *it++ == '-';
+    int val = 0;
+    for (; it != eit && *it >= '0' && *it <= '9'; ++it)
+        val = val * 10 + (*it - '0');
+    return neg ? -val : val;
+}
 
-    auto prim = std::make_shared<PrimitiveObject>();
+// what one line-aligned piece of the file holds; indices are absolute (0-based), except
+// the negative ones which count back from the verts or uvs read so far by the piece, and
+// are offset by what the pieces before it read when stitched
+struct ObjChunk {
+    std::vector<vec3f> verts;
+    std::vector<vec2f> uvs;
+    std::vector<int> loops;
     std::vector<int> loop_uvs;
+    std::vector<int> poly_sizes;
+    std::vector<vec2i> lines;
+    std::vector<int> rel_loops, rel_loop_uvs, rel_lines;  // where the relative indices are, lines[i / 2][i % 2]
+
+    void parse(char const *it, char const *eit) {
+        while (it < eit) {
+            auto nit = std::find(it, eit, '\n');
+            auto nnit = nit == eit ? eit : nit + 1;
+            if (nit != it && nit[-1] == '\r')
+                --nit;
+
+            if (match(it, nit, "v ")) {
+                float x = takef(it, nit);
+                float y = takef(it, nit);
+                float z = takef(it, nit);
+                verts.emplace_back(x, y, z);
 
-    while (it < eit) {
-        auto nit = std::find(it, eit, '\n');
-        auto nnit = nit + 1;
-        if (nit[-1] == '\r')
-            --nit;
-
-        if (match(it, "v ")) {
-            float x = takef(it);
-            float y = takef(it);
-            float z = takef(it);
-            prim->verts.emplace_back(x, y, z);
-
-        } else if (match(it, "vt ")) {
-            float x = takef(it);
-            float y = takef(it);
-            prim->uvs.emplace_back(x, y);
-
-        } else if (match(it, "f ")) {
-            int beg = prim->loops.size();
-            int cnt{};
-            while (it != nit) {
-                int x = takeu(it) - 1;
-                if (*it == '/' && it[1] != '/') {
-                    ++it;
-                    int xt = takeu(it) - 1;
-                    loop_uvs.push_back(xt);
+            } else if (match(it, nit, "vt ")) {
+                float x = takef(it, nit);
+                float y = takef(it, nit);
+                uvs.emplace_back(x, y);
+
+            } else if (match(it, nit, "f ")) {
+                int cnt{};
+                skipblank(it, nit);
+                while (it != nit) {
+                    index(takei(it, nit), verts.size(), loops, rel_loops);
+                    if (it != nit && *it == '/' && it + 1 != nit && it[1] != '/') {
+                        ++it;
+                        index(takei(it, nit), uvs.size(), loop_uvs, rel_loop_uvs);
+                    }
+                    it = std::find_if(it, nit, isblank);
+                    ++cnt;
+                    skipblank(it, nit);
                 }
-                it = std::find(it, nit, ' ');
-                prim->loops.push_back(x);
-                ++cnt;
-                it = std::find_if(it, nit, [] (char c) { return c != ' '; });
-            }
-            prim->polys.emplace_back(beg, cnt);
+                poly_sizes.push_back(cnt);
 
-        } else if (match(it, "l ")) {
-            int x = takeu(it) - 1;
-            int y = takeu(it) - 1;
-            prim->lines.emplace_back(x, y);
+            } else if (match(it, nit, "l ")) {
+                int x = takei(it, nit);
+                int y = takei(it, nit);
+                if (x < 0)
+                    rel_lines.push_back(lines.size() * 2);
+                if (y < 0)
+                    rel_lines.push_back(lines.size() * 2 + 1);
+                lines.emplace_back(x < 0 ? x + (int)verts.size() : x - 1,
+                                   y < 0 ? y + (int)verts.size() : y - 1);
 
-        //} else if (match(it, "o ")) {
-            // todo: support tag verts to be multi components of primitive
-            //std::string_view o_name(it, nit - it);
+            //} else if (match(it, nit, "o ")) {
+                // todo: support tag verts to be multi components of primitive
+                //std::string_view o_name(it, nit - it);
 
+            }
+            it = nnit;
         }
-        it = nnit;
     }
 
-    {
-        int vert_count = prim->verts.size();
-        for (auto &i : prim->loops) {
-            if (i < 0) {
-                i += vert_count + 1;
-            }
-        }
-        for (auto &i : loop_uvs) {
-            if (i < 0) {
-                i += vert_count + 1;
-            }
+    static void index(int x, std::size_t count, std::vector<int> &out, std::vector<int> &rel) {
+        if (x < 0) {
+            rel.push_back(out.size());
+            out.push_back(x + (int)count);
+        } else {
+            out.push_back(x - 1);
         }
     }
+};
+
+std::shared_ptr<PrimitiveObject> parse_obj(char const *data, std::size_t size) {
+    // pieces end right after a newline, so no line is split between two of them
+    auto &pool = thread_pool::global();
+    std::size_t nchunks = std::max<std::size_t>(pool.chunk_count(size, 1 << 20), 1);
+    auto boundary = [&] (std::size_t c) -> char const * {
+        if (c >= nchunks)
+            return data + size;
+        auto p = data + size * c / nchunks;
+        if (c == 0)
+            return p;
+        auto nl = std::find(p - 1, data + size, '\n');
+        return nl == data + size ? nl : nl + 1;
+    };
+    std::vector<ObjChunk> chunks(nchunks);
+    pool.for_each_chunk(nchunks, nchunks, [&] (std::size_t c, std::size_t, std::size_t) {
+        chunks[c].parse(boundary(c), boundary(c + 1));
+    });
 
-    if (loop_uvs.size() == prim->loops.size()) {
-        prim->loops.add_attr<int>("uvs") = std::move(loop_uvs);
+    struct Offsets {
+        int verts = 0, uvs = 0, loops = 0, polys = 0, lines = 0;
+    };
+    std::vector<Offsets> offs(nchunks + 1);
+    bool has_uvs = true;
+    for (std::size_t c = 0; c < nchunks; c++) {
+        auto const &ch = chunks[c];
+        offs[c + 1].verts = offs[c].verts + ch.verts.size();
+        offs[c + 1].uvs = offs[c].uvs + ch.uvs.size();
+        offs[c + 1].loops = offs[c].loops + ch.loops.size();
+        offs[c + 1].polys = offs[c].polys + ch.poly_sizes.size();
+        offs[c + 1].lines = offs[c].lines + ch.lines.size();
+        has_uvs = has_uvs && ch.loop_uvs.size() == ch.loops.size();
     }
 
+    auto prim = std::make_shared<PrimitiveObject>();
+    auto const &total = offs[nchunks];
+    prim->verts.resize(total.verts);
+    prim->uvs.resize(total.uvs);
+    prim->loops.resize(total.loops);
+    prim->polys.resize(total.polys);
+    prim->lines.resize(total.lines);
+    auto &loop_uvs = has_uvs ? prim->loops.add_attr<int>("uvs") : prim->loops.values;
+
+    pool.for_each_chunk(nchunks, nchunks, [&] (std::size_t c, std::size_t, std::size_t) {
+        auto &ch = chunks[c];
+        auto const &off = offs[c];
+        for (auto i: ch.rel_loops)
+            ch.loops[i] += off.verts;
+        for (auto i: ch.rel_loop_uvs)
+            ch.loop_uvs[i] += off.uvs;
+        for (auto i: ch.rel_lines)
+            ch.lines[i / 2][i % 2] += off.verts;
+        std::copy(ch.verts.begin(), ch.verts.end(), prim->verts.begin() + off.verts);
+        std::copy(ch.uvs.begin(), ch.uvs.end(), prim->uvs.begin() + off.uvs);
+        std::copy(ch.loops.begin(), ch.loops.end(), prim->loops.begin() + off.loops);
+        if (has_uvs)
+            std::copy(ch.loop_uvs.begin(), ch.loop_uvs.end(), loop_uvs.begin() + off.loops);
+        std::copy(ch.lines.begin(), ch.lines.end(), prim->lines.begin() + off.lines);
+        int base = off.loops;
+        for (std::size_t i = 0; i < ch.poly_sizes.size(); i++) {
+            prim->polys[off.polys + i] = {base, ch.poly_sizes[i]};
+            base += ch.poly_sizes[i];
+        }
+        ch = ObjChunk();
+    });
+
     return prim;
 }
 
+std::shared_ptr<PrimitiveObject> read_obj(std::string const &path, bool must_exist) {
+    mapped_file file(std::filesystem::u8path(path));
+    if (!file) {
+        if (must_exist)
+            throw makeError(zeno::format("can not find {}", path));
+        return std::make_shared<PrimitiveObject>();
+    }
+    return parse_obj(file.data(), file.size());
+}
+
 struct ReadObjPrim : INode {
     virtual void apply() override {
         auto path = get_input2<std::string>("path");
-        std::string native_path = std::filesystem::u8path(path).string();
-        std::ifstream file(native_path, std::ios::binary);
-        auto binary = std::vector<char>((std::istreambuf_iterator<char>(file)),
-                              std::istreambuf_iterator<char>());
-        auto prim = parse_obj(std::move(binary));
+        auto prim = read_obj(path, false);
         if (get_param<bool>("triangulate")) {
             primTriangulate(prim.get());
         }
@@ -152,12 +299,7 @@ ZENDEFNODE(ReadObjPrim,
 struct MustReadObjPrim : INode {
     virtual void apply() override {
         auto path = get_input2<std::string>("path");
-        auto binary = file_get_binary<std::vector<char>>(path);
-        if (binary.empty()) {
-            auto s = zeno::format("can not find {}", path);
-            throw zeno::makeError(s);
-        }
-        auto prim = parse_obj(std::move(binary));
+        auto prim = read_obj(path, true);
         if (get_param<bool>("triangulate")) {
             primTriangulate(prim.get());
         }
@@ -0,0 +1,249 @@
+#include <zeno/zeno.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/SpatialIndexObject.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/utils/arrayindex.h>
+#include <zeno/utils/string.h>
+#include <zeno/utils/log.h>
+#include <limits>
+
+namespace zeno {
+namespace {
+
+float maxDistOrInf(float maxDist) {
+    return maxDist > 0 ? maxDist : std::numeric_limits<float>::infinity();
+}
+
+struct BuildSpatialIndex : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto type = (SpatialIndexObject::ElementType)array_index_safe({"points", "lines", "tris"}, get_input2<std::string>("elementType"), "elementType");
+        auto structure = (SpatialIndexObject::Structure)array_index_safe({"bvh", "hashgrid"}, get_input2<std::string>("structure"), "structure");
+        auto cellSize = get_input2<float>("cellSize");
+
+        // an index from the previous frame is only refit when the topology is the same
+        if (has_input("prevIndex")) {
+            auto prev = std::make_shared<SpatialIndexObject>(*get_input<SpatialIndexObject>("prevIndex"));
+            if (prev->elementType == type && prev->structure == structure && prev->refit(prim.get())) {
+                set_output("index", std::move(prev));
+                return;
+            }
+        }
+        set_output("index", SpatialIndexObject::build(prim.get(), type, structure, cellSize));
+    }
+};
+
+ZENDEFNODE(BuildSpatialIndex, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"SpatialIndexObject", "prevIndex"},
+    {"enum points lines tris", "elementType", "tris"},
+    {"enum bvh hashgrid", "structure", "bvh"},
+    {"float", "cellSize", "0"},
+    },
+    {
+    {"SpatialIndexObject", "index"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+// closest element to every vert, optionally interpolating vert attributes of srcPrim there
+struct QuerySpatialClosest : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto index = get_input<SpatialIndexObject>("index");
+        auto maxDist = maxDistOrInf(get_input2<float>("maxDist"));
+        auto &ids = prim->verts.add_attr<int>(get_input2<std::string>("idAttr"));
+        auto &dists = prim->verts.add_attr<float>(get_input2<std::string>("distAttr"));
+        auto &barys = prim->verts.add_attr<vec3f>(get_input2<std::string>("baryAttr"));
+        auto snap = get_input2<bool>("snapToClosest");
+
+        std::vector<vec3f> closest(prim->verts.size());
+        auto order = index->batchOrder(prim->verts.values);
+        parallel_for(order.size(), [&] (size_t o) {
+            int i = order[o];
+            auto hit = index->closest(prim->verts[i], maxDist);
+            ids[i] = hit.id;
+            dists[i] = hit.id == -1 ? -1.f : hit.dist;
+            barys[i] = hit.bary;
+            closest[i] = hit.id == -1 ? prim->verts[i] : hit.pos;
+        });
+
+        if (has_input("srcPrim")) {
+            auto srcPrim = get_input<PrimitiveObject>("srcPrim");
+            if (srcPrim->verts.size() != index->verts.size())
+                throw makeError("srcPrim doesn't match the primitive the index was built from");
+            for (auto const &key: zeno::split_str(get_input2<std::string>("attrs"), ' ')) {
+                if (key.empty() || key == "pos")
+                    continue;
+                srcPrim->verts.attr_visit(key, [&] (auto const &srcArr) {
+                    using T = std::decay_t<decltype(srcArr[0])>;
+                    auto &arr = prim->verts.add_attr<T>(key);
+                    parallel_for(prim->verts.size(), [&] (size_t i) {
+                        if (ids[i] == -1)
+                            return;
+                        auto ind = index->elems[ids[i]];
+                        auto w = barys[i];
+                        if constexpr (std::is_same_v<T, int>) {
+                            int k = w[1] > w[0] ? (w[2] > w[1] ? 2 : 1) : (w[2] > w[0] ? 2 : 0);
+                            arr[i] = srcArr[ind[k]];
+                        } else {
+                            arr[i] = w[0] * srcArr[ind[0]] + w[1] * srcArr[ind[1]] + w[2] * srcArr[ind[2]];
+                        }
+                    });
+                });
+            }
+        }
+        if (snap)
+            prim->verts.values = std::move(closest);
+
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(QuerySpatialClosest, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"SpatialIndexObject", "index"},
+    {"float", "maxDist", "0"},
+    {"string", "idAttr", "closest_id"},
+    {"string", "distAttr", "closest_dist"},
+    {"string", "baryAttr", "closest_bary"},
+    {"bool", "snapToClosest", "0"},
+    {"PrimitiveObject", "srcPrim"},
+    {"string", "attrs", ""},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+// ids of the k nearest elements to every vert, in attributes idAttr0, idAttr1... (-1 past the count)
+struct QuerySpatialKNN : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto index = get_input<SpatialIndexObject>("index");
+        auto maxDist = maxDistOrInf(get_input2<float>("maxDist"));
+        auto k = get_input2<int>("k");
+        auto idAttr = get_input2<std::string>("idAttr");
+        auto &counts = prim->verts.add_attr<int>(get_input2<std::string>("countAttr"));
+
+        std::vector<std::vector<int> *> idArrs;
+        for (int j = 0; j < k; j++)
+            idArrs.push_back(&prim->verts.add_attr<int>(idAttr + std::to_string(j)));
+        auto order = index->batchOrder(prim->verts.values);
+        parallel_for(order.size(), [&] (size_t o) {
+            int i = order[o];
+            thread_local std::vector<SpatialIndexObject::Hit> hits;
+            index->knn(prim->verts[i], k, maxDist, hits);
+            counts[i] = hits.size();
+            for (int j = 0; j < k; j++)
+                (*idArrs[j])[i] = j < (int)hits.size() ? hits[j].id : -1;
+        });
+
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(QuerySpatialKNN, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"SpatialIndexObject", "index"},
+    {"int", "k", "4"},
+    {"float", "maxDist", "0"},
+    {"string", "idAttr", "knn_id"},
+    {"string", "countAttr", "knn_count"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+struct QuerySpatialRadius : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto index = get_input<SpatialIndexObject>("index");
+        auto radius = get_input2<float>("radius");
+        auto &counts = prim->verts.add_attr<int>(get_input2<std::string>("countAttr"));
+
+        auto order = index->batchOrder(prim->verts.values);
+        parallel_for(order.size(), [&] (size_t o) {
+            int i = order[o];
+            thread_local std::vector<SpatialIndexObject::Hit> hits;
+            index->radius(prim->verts[i], radius, hits);
+            counts[i] = hits.size();
+        });
+
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(QuerySpatialRadius, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"SpatialIndexObject", "index"},
+    {"float", "radius", "1"},
+    {"string", "countAttr", "nei_count"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+// ray from every vert along dirAttr against an index of tris
+struct QuerySpatialRaycast : INode {
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        auto index = get_input<SpatialIndexObject>("index");
+        if (index->elementType != SpatialIndexObject::Tris)
+            throw makeError("raycast needs a spatial index of tris");
+        auto maxDist = maxDistOrInf(get_input2<float>("maxDist"));
+        auto const &dirs = prim->verts.attr<vec3f>(get_input2<std::string>("dirAttr"));
+        auto &ids = prim->verts.add_attr<int>(get_input2<std::string>("idAttr"));
+        auto &dists = prim->verts.add_attr<float>(get_input2<std::string>("distAttr"));
+        auto &barys = prim->verts.add_attr<vec3f>(get_input2<std::string>("baryAttr"));
+
+        auto order = index->batchOrder(prim->verts.values);
+        parallel_for(order.size(), [&] (size_t o) {
+            int i = order[o];
+            auto hit = index->raycast(prim->verts[i], dirs[i], maxDist);
+            ids[i] = hit.id;
+            dists[i] = hit.id == -1 ? -1.f : hit.dist;
+            barys[i] = hit.bary;
+        });
+
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(QuerySpatialRaycast, {
+    {
+    {"PrimitiveObject", "prim"},
+    {"SpatialIndexObject", "index"},
+    {"string", "dirAttr", "nrm"},
+    {"float", "maxDist", "0"},
+    {"string", "idAttr", "hit_id"},
+    {"string", "distAttr", "hit_dist"},
+    {"string", "baryAttr", "hit_bary"},
+    },
+    {
+    {"PrimitiveObject", "prim"},
+    },
+    {
+    },
+    {"primitive"},
+});
+
+}
+}
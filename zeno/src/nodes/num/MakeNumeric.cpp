@@ -4,6 +4,10 @@
 namespace {
 
 struct NumericInt : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         obj->set(get_param<int>("value"));
@@ -20,6 +24,10 @@ ZENDEFNODE(NumericInt, {
 
 
 struct NumericIntVec2 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<int>("x");
@@ -38,6 +46,10 @@ ZENDEFNODE(NumericIntVec2, {
 
 
 struct PackNumericIntVec2 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_input2<int>("x");
@@ -56,6 +68,10 @@ ZENDEFNODE(PackNumericIntVec2, {
 
 
 struct NumericIntVec3 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<int>("x");
@@ -75,6 +91,10 @@ ZENDEFNODE(NumericIntVec3, {
 
 
 struct NumericIntVec4 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<int>("x");
@@ -96,6 +116,10 @@ ZENDEFNODE(NumericIntVec4, {
 
 
 struct NumericFloat : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         obj->set(get_param<float>("value"));
@@ -112,6 +136,10 @@ ZENDEFNODE(NumericFloat, {
 
 
 struct NumericVec2 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<float>("x");
@@ -130,6 +158,10 @@ ZENDEFNODE(NumericVec2, {
 
 
 struct NumericVec3 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<float>("x");
@@ -150,6 +182,10 @@ ZENDEFNODE(NumericVec3, {
 
 
 struct NumericVec4 : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto x = get_param<float>("x");
@@ -170,6 +206,10 @@ ZENDEFNODE(NumericVec4, {
 });
 
 struct PackNumericVecInt : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto _type = get_param<std::string>("type");
@@ -205,6 +245,10 @@ ZENDEFNODE(PackNumericVecInt, {
 });
 
 struct PackNumericVec : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override {
         auto obj = std::make_unique<zeno::NumericObject>();
         auto _type = get_param<std::string>("type");
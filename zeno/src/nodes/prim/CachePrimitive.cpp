@@ -10,6 +10,10 @@ namespace zeno {
 struct CachePrimitive : zeno::INode {
     int m_framecounter = 0;
 
+    virtual bool hasLazyInputs() const override {
+        return true;
+    }
+
     virtual void preApply() override {
         /*if (has_option("MUTE")) {
             requireInput("inPrim");
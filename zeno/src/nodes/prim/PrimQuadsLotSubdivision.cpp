@@ -11,6 +11,10 @@
 namespace {
 
 struct PrimQuadsLotSubdivision : zeno::INode {
+    virtual bool isPure() const override {
+        return false;
+    }
+
     virtual void apply() override {
         auto inprim = get_input<zeno::PrimitiveObject>("input_quads_model"); //输入的多边形物体
         size_t num = get_input2<int>("num");
@@ -107,6 +107,10 @@ static float perlin(float x, float y, float z) {
 
 
 struct PrimitivePerlinNoiseAttr : INode {
+    virtual bool isPure() const override {
+        return false;
+    }
+
   virtual void apply() override {
     auto prim = has_input("prim") ?
         get_input<PrimitiveObject>("prim") :
@@ -161,6 +165,10 @@ ZENDEFNODE(PrimitivePerlinNoiseAttr,
     }});
 
 struct GetPerlinNoise : INode{
+    virtual bool isPure() const override {
+        return false;
+    }
+
     virtual void apply() override {
         auto vec = get_input<zeno::NumericObject>("vec3")->get<zeno::vec3f>();
         auto offset = vec3f(frand(), frand(), frand());
@@ -68,6 +68,10 @@ ZENDEFNODE(PrimitiveReduction,
     }});
 
 struct PrimReduction : zeno::INode {
+    virtual bool isMemoizable() const override {
+        return true;
+    }
+
     virtual void apply() override{
         auto prim = get_input<PrimitiveObject>("prim");
         auto attrToReduce = get_input2<std::string>(("attrName"));
@@ -1308,6 +1308,10 @@ float noise_WorleyNoise3(float px, float py, float pz, int fType, int distType,
 }
 
 struct erode_noise_worley : INode {
+    virtual bool isPure() const override {
+        return false;
+    }
+
     void apply() override {
         auto terrain = get_input<PrimitiveObject>("prim_2DGrid");
         auto posLikeAttrName = get_input<StringObject>("posLikeAttrName")->get();
@@ -0,0 +1,277 @@
+#include <zeno/para/thread_pool.h>
+#include <zeno/extra/Profiler.h>
+#include <zeno/utils/envconfig.h>
+#include <zeno/utils/log.h>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace zeno {
+
+namespace {
+
+struct TaskDeque {
+    std::mutex mtx;
+    std::deque<thread_pool::task_type> tasks;
+
+    void push_back(thread_pool::task_type &&task) {
+        std::lock_guard lck(mtx);
+        tasks.push_back(std::move(task));
+    }
+
+    bool pop_back(thread_pool::task_type &task) {
+        std::lock_guard lck(mtx);
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.back());
+        tasks.pop_back();
+        return true;
+    }
+
+    bool pop_front(thread_pool::task_type &task) {
+        std::lock_guard lck(mtx);
+        if (tasks.empty())
+            return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+};
+
+}
+
+struct thread_pool::Impl {
+    std::vector<std::unique_ptr<TaskDeque>> local;
+    TaskDeque injected;
+    std::vector<std::thread> threads;
+
+    std::atomic<std::size_t> npending{0};
+    std::atomic<int> nwaiters{0};
+    std::atomic<bool> stopping{false};
+
+    std::mutex sleep_mtx;
+    std::condition_variable worker_cv;
+    std::condition_variable waiter_cv;
+
+    static constexpr std::size_t nowhere = std::size_t(-1);
+
+    // which pool (if any) the current thread is a worker of, and its deque index
+    static inline thread_local Impl *tls_owner = nullptr;
+    static inline thread_local std::size_t tls_index = nowhere;
+
+    std::size_t self_index() const {
+        return tls_owner == this ? tls_index : nowhere;
+    }
+
+    void push(task_type &&task) {
+        auto self = self_index();
+        if (self != nowhere)
+            local[self]->push_back(std::move(task));
+        else
+            injected.push_back(std::move(task));
+        npending.fetch_add(1);
+        { std::lock_guard lck(sleep_mtx); }
+        worker_cv.notify_one();
+        if (nwaiters.load())
+            waiter_cv.notify_all();
+    }
+
+    bool pop(task_type &task) {
+        if (!npending.load())
+            return false;
+        auto self = self_index();
+        bool got = false;
+        if (self != nowhere)
+            got = local[self]->pop_back(task);
+        if (!got)
+            got = injected.pop_front(task);
+        if (!got) {
+            std::size_t n = local.size();
+            std::size_t base = self != nowhere ? self : 0;
+            for (std::size_t k = 1; k <= n && !got; k++) {
+                got = local[(base + k) % n]->pop_front(task);
+            }
+        }
+        if (got)
+            npending.fetch_sub(1);
+        return got;
+    }
+
+    void execute(task_type &task) {
+        try {
+            task();
+        } catch (std::exception const &e) {
+            log_error("thread_pool: uncaught exception in task: {}", e.what());
+        } catch (...) {
+            log_error("thread_pool: uncaught exception in task: <unknown>");
+        }
+        task = nullptr;
+        if (nwaiters.load()) {
+            { std::lock_guard lck(sleep_mtx); }
+            waiter_cv.notify_all();
+        }
+    }
+
+    void worker_main(std::size_t index) {
+        tls_owner = this;
+        tls_index = index;
+        task_type task;
+        while (true) {
+            if (pop(task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock lck(sleep_mtx);
+            worker_cv.wait(lck, [&] {
+                return npending.load() || stopping.load();
+            });
+            if (stopping.load() && !npending.load())
+                break;
+        }
+        tls_owner = nullptr;
+        tls_index = nowhere;
+    }
+};
+
+ZENO_API thread_pool::thread_pool(std::size_t nworkers) : impl(std::make_unique<Impl>()) {
+    impl->local.reserve(nworkers);
+    for (std::size_t i = 0; i < nworkers; i++) {
+        impl->local.push_back(std::make_unique<TaskDeque>());
+    }
+    impl->threads.reserve(nworkers);
+    for (std::size_t i = 0; i < nworkers; i++) {
+        impl->threads.emplace_back([this, i] {
+            impl->worker_main(i);
+        });
+    }
+}
+
+ZENO_API thread_pool::~thread_pool() {
+    {
+        std::lock_guard lck(impl->sleep_mtx);
+        impl->stopping.store(true);
+    }
+    impl->worker_cv.notify_all();
+    for (auto &thr: impl->threads) {
+        thr.join();
+    }
+}
+
+ZENO_API std::size_t thread_pool::concurrency() const {
+    return impl->threads.size() + 1;
+}
+
+ZENO_API void thread_pool::submit(task_type task) {
+    impl->push(std::move(task));
+}
+
+ZENO_API bool thread_pool::try_run_one() {
+    task_type task;
+    if (!impl->pop(task))
+        return false;
+    impl->execute(task);
+    return true;
+}
+
+ZENO_API void thread_pool::wait_until(std::function<bool()> const &done) {
+    while (!done()) {
+        if (try_run_one())
+            continue;
+        impl->nwaiters.fetch_add(1);
+        {
+            std::unique_lock lck(impl->sleep_mtx);
+            // the timeout is only a safety net for conditions changed outside of the pool
+            impl->waiter_cv.wait_for(lck, std::chrono::milliseconds(1), [&] {
+                return impl->npending.load() || done();
+            });
+        }
+        impl->nwaiters.fetch_sub(1);
+    }
+}
+
+ZENO_API void thread_pool::notify_waiters() {
+    if (impl->nwaiters.load()) {
+        { std::lock_guard lck(impl->sleep_mtx); }
+        impl->waiter_cv.notify_all();
+    }
+}
+
+ZENO_API bool thread_pool::is_worker_thread() const {
+    return impl->self_index() != Impl::nowhere;
+}
+
+ZENO_API std::size_t thread_pool::chunk_count(std::size_t n, std::size_t grain) const {
+    if (!n)
+        return 0;
+    // a few chunks per thread so that uneven items still balance out
+    std::size_t maxchunks = concurrency() * 4;
+    std::size_t nchunks = grain ? (n + grain - 1) / grain : n;
+    return std::min(nchunks, maxchunks);
+}
+
+ZENO_API void thread_pool::for_each_chunk(std::size_t n, std::size_t nchunks, chunk_func_type const &body) {
+    if (!n || !nchunks)
+        return;
+    if (nchunks == 1 || concurrency() == 1) {
+        for (std::size_t c = 0; c < nchunks; c++) {
+            body(c, n * c / nchunks, n * (c + 1) / nchunks);
+        }
+        return;
+    }
+
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> ndone{0};
+        std::mutex mtx;
+        std::exception_ptr error;
+        std::string caller;  // profiler spans are named after the one that started the loop
+    };
+    // helpers that start late only touch the state, which must outlive this call
+    auto st = std::make_shared<State>();
+    if (Profiler::enabled())
+        st->caller = Profiler::currentSpan();
+    auto work = [st, &body, n, nchunks] {
+        std::size_t c = st->next.fetch_add(1);
+        if (c >= nchunks)
+            return;
+        Profiler::Span _prof("parallel_for", st->caller);
+        for (; c < nchunks; c = st->next.fetch_add(1)) {
+            try {
+                body(c, n * c / nchunks, n * (c + 1) / nchunks);
+            } catch (...) {
+                std::lock_guard lck(st->mtx);
+                if (!st->error)
+                    st->error = std::current_exception();
+            }
+            st->ndone.fetch_add(1);
+        }
+    };
+    std::size_t nhelpers = std::min(nchunks, concurrency()) - 1;
+    for (std::size_t h = 0; h < nhelpers; h++) {
+        submit(work);
+    }
+    work();
+    wait_until([&] {
+        return st->ndone.load() == nchunks;
+    });
+    if (st->error)
+        std::rethrow_exception(st->error);
+}
+
+ZENO_API thread_pool &thread_pool::global() {
+    static thread_pool pool([] {
+        std::size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+        if (int cap = envconfig::getInt("MAX_THREADS"); cap > 0)
+            nthreads = std::min(nthreads, static_cast<std::size_t>(cap));
+        return nthreads - 1;
+    }());
+    return pool;
+}
+
+}
@@ -6,10 +6,13 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cstdio>
+#include <mutex>
 #include <map>
 
 namespace zeno {
 
+static std::mutex g_records_mtx;
+
 Timer::Timer(std::string_view &&tag_, Timer::ClockType::time_point &&beg_)
     : parent(current), beg(beg_)
     , tag(current ? current->tag + " => " + (std::string)tag_ : tag_)
@@ -22,13 +25,15 @@ void Timer::_destroy(Timer::ClockType::time_point &&end) {
     auto diff = end - beg;
     int us = std::chrono::duration_cast
         <std::chrono::microseconds>(diff).count();
+    std::lock_guard lck(g_records_mtx);
     records.emplace_back(std::move(tag), us);
 }
 
-Timer *Timer::current = nullptr;
+thread_local Timer *Timer::current = nullptr;
 std::vector<Timer::Record> Timer::records;
 
 std::string Timer::getLog() {
+    std::lock_guard lck(g_records_mtx);
     if (records.size() == 0) {
         return "";
     }
@@ -2,12 +2,21 @@
 #include <cstring>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <zeno/utils/format.h>
 #include <zeno/utils/envconfig.h>
 //#include <zeno/utils/ansiclr.h>
 #include <zeno/utils/arrayindex.h>
+#include <condition_variable>
+#include <unordered_map>
 #include <iostream>
+#include <atomic>
+#include <thread>
 #include <chrono>
+#include <vector>
+#include <mutex>
+#include <string>
+#include <utility>
 
 namespace zeno {
 
@@ -22,26 +31,244 @@ ZENO_API bool __check_log_level(log_level_t level) {
     return level >= curr_level;
 }
 
+namespace {
+
+thread_local std::string_view tls_node;
+thread_local int tls_frame = -1;
+
+struct LogRecord {
+    LogRecord *next = nullptr;
+    bool *done = nullptr;  // set once written, for the callers that wait
+    bool marker = false;   // only waited for, not written
+    log_level_t level = log_level_t::info;
+    std::chrono::steady_clock::time_point time;
+    source_location loc;
+    std::string fields;
+    std::string msg;
+};
+
+void writeRecord(std::ostream &os, LogRecord const &rec) {
+    auto sod = std::chrono::floor<std::chrono::duration<int, std::ratio<24 * 60 * 60, 1>>>(rec.time);
+    auto mss = std::chrono::floor<std::chrono::milliseconds>(rec.time - sod).count();
+    int linlev = (int)rec.level - (int)log_level_t::trace;
+    //os << ansiclr::fg[make_array(ansiclr::white, ansiclr::cyan, ansiclr::green,
+                                  //ansiclr::cyan | ansiclr::light, ansiclr::yellow | ansiclr::light,
+                                  //ansiclr::red | ansiclr::light)[linlev]];
+    os << format("[{} {02d}:{02d}:{02d}.{03d}] ({}:{}) {}{}\n",
+                 "TDICWE"[linlev],
+                 mss / 1000 / 60 / 60 % 24, mss / 1000 / 60 % 60,
+                 mss / 1000 % 60, mss % 1000,
+                 rec.loc.file_name(), rec.loc.line(),
+                 rec.fields, rec.msg);
+    //os << ansiclr::reset;
+}
+
+/* Lines are pushed by any thread onto a lock-free list and written by one
+ * background thread, a whole batch at a time with a single flush, so nodes
+ * logging a lot don't wait for the pipe to the editor, and lines of concurrent
+ * threads never interleave. Errors are waited for, so they are out before a
+ * crash that may follow. Setting ZENO_LOG_RATE limits every call site to that
+ * many lines per second (errors excepted), the rest is counted and reported;
+ * there is no limit by default, as a site may log distinct lines in a loop.
+ * ZENO_LOG_SYNC=1 writes on the calling thread instead.
+ */
+struct LogWriter {
+    std::atomic<LogRecord *> m_head{nullptr};
+
+    std::mutex m_osMtx;  // held while writing to os
+    std::mutex m_mtx;    // for the conditions
+    std::condition_variable m_wake, m_done;
+    std::thread m_thread;
+    bool m_stop = false;
+    std::atomic<bool> m_async{!envconfig::getBool("LOG_SYNC")};
+    int m_rate = envconfig::getInt("LOG_RATE", 0);
+
+    struct Site {
+        std::chrono::steady_clock::time_point window;
+        int count = 0;
+        int suppressed = 0;
+        LogRecord last;  // the location and time for the note about the suppressed ones
+    };
+    std::unordered_map<std::string, Site> m_sites;  // by "file:line"
+
+    // at exit, what is logged later, e.g. by static destructors, is written right away
+    void stop() {
+        {
+            std::lock_guard lck(m_mtx);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        if (m_thread.joinable())
+            m_thread.join();
+        m_async = false;
+        drain();
+        std::lock_guard lck(m_osMtx);
+        for (auto &[key, site]: m_sites) {
+            if (site.suppressed) {
+                writeSuppressed(site.last, site);
+                site.suppressed = 0;
+            }
+        }
+        os->flush();
+    }
+
+    void push(LogRecord *rec) {
+        if (!m_async.load(std::memory_order_relaxed)) {
+            std::lock_guard lck(m_osMtx);
+            if (!rec->marker) {
+                writeRecord(*os, *rec);
+                os->flush();
+            }
+            delete rec;
+            return;
+        }
+        bool done = false;
+        bool urgent = rec->marker || rec->level >= log_level_t::error;
+        if (urgent)
+            rec->done = &done;
+        rec->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(rec->next, rec, std::memory_order_release, std::memory_order_relaxed));
+        // the writer sleeps until the list gets non-empty
+        if (!rec->next || urgent) {
+            std::unique_lock lck(m_mtx);
+            if (m_stop) {
+                lck.unlock();
+                drain();
+                lck.lock();
+            } else {
+                if (!m_thread.joinable())
+                    m_thread = std::thread([this] { run(); });
+                m_wake.notify_one();
+            }
+            if (urgent)
+                m_done.wait(lck, [&] { return done; });
+        }
+    }
+
+    void flush() {
+        auto rec = new LogRecord;
+        rec->marker = true;
+        push(rec);
+    }
+
+    void run() {
+        std::unique_lock lck(m_mtx);
+        while (true) {
+            m_wake.wait(lck, [&] { return m_stop || m_head.load(std::memory_order_relaxed); });
+            if (m_stop)
+                break;
+            lck.unlock();
+            drain();
+            lck.lock();
+        }
+    }
+
+    // writes what has been pushed so far with a single flush, oldest first
+    void drain() {
+        std::vector<bool *> dones;
+        {
+            std::lock_guard osLck(m_osMtx);
+            std::vector<LogRecord *> batch;
+            for (auto list = m_head.exchange(nullptr, std::memory_order_acquire); list; list = list->next)
+                batch.push_back(list);
+            if (batch.empty())
+                return;
+            for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+                auto *rec = *it;
+                if (!rec->marker && allowed(*rec))
+                    writeRecord(*os, *rec);
+                if (rec->done)
+                    dones.push_back(rec->done);
+                delete rec;
+            }
+            os->flush();
+        }
+        std::lock_guard lck(m_mtx);
+        for (auto *done: dones)
+            *done = true;
+        m_done.notify_all();
+    }
+
+    void writeSuppressed(LogRecord const &last, Site const &site) {
+        LogRecord note;
+        note.level = log_level_t::warn;
+        note.time = last.time;
+        note.loc = last.loc;
+        note.msg = format("suppressed {} more lines from here in the last second", site.suppressed);
+        writeRecord(*os, note);
+    }
+
+    bool allowed(LogRecord const &rec) {
+        if (m_rate <= 0 || rec.level >= log_level_t::error)
+            return true;
+        auto &site = m_sites[std::string(rec.loc.file_name()) + ':' + std::to_string(rec.loc.line())];
+        if (rec.time - site.window >= std::chrono::seconds(1)) {
+            if (site.suppressed)
+                writeSuppressed(rec, site);
+            site.window = rec.time;
+            site.count = 0;
+            site.suppressed = 0;
+        }
+        if (site.count++ < m_rate)
+            return true;
+        site.suppressed++;
+        site.last.loc = rec.loc;
+        site.last.time = rec.time;
+        return false;
+    }
+};
+
+LogWriter &writer() {
+    // never destroyed, nodes may still log from other threads or static destructors
+    static LogWriter *w = [] {
+        auto w = new LogWriter;
+        std::atexit([] {
+            writer().stop();
+        });
+        return w;
+    }();
+    return *w;
+}
+
+}
+
 ZENO_API void set_log_stream(std::ostream &osin) {
+    auto &w = writer();
+    w.flush();
+    std::lock_guard lck(w.m_osMtx);
     os = &osin;
 }
 
+ZENO_API std::unique_lock<std::mutex> lock_log_stream() {
+    return std::unique_lock(writer().m_osMtx);
+}
+
+ZENO_API void log_flush() {
+    writer().flush();
+}
+
+ZENO_API log_fields_scope::log_fields_scope(std::string_view node, int frame)
+    : m_node(std::exchange(tls_node, node)), m_frame(std::exchange(tls_frame, frame)) {
+}
+
+ZENO_API log_fields_scope::~log_fields_scope() {
+    tls_node = m_node;
+    tls_frame = m_frame;
+}
+
 ZENO_API void __impl_log_print(log_level_t level, source_location const &loc, std::string_view msg) {
-    auto now = std::chrono::steady_clock::now();
-    auto sod = std::chrono::floor<std::chrono::duration<int, std::ratio<24 * 60 * 60, 1>>>(now);
-    auto mss = std::chrono::floor<std::chrono::milliseconds>(now - sod).count();
-    int linlev = (int)level - (int)log_level_t::trace;
-    //*os << ansiclr::fg[make_array(ansiclr::white, ansiclr::cyan, ansiclr::green,
-                                  //ansiclr::cyan | ansiclr::light, ansiclr::yellow | ansiclr::light,
-                                  //ansiclr::red | ansiclr::light)[linlev]];
-    *os << format("[{} {02d}:{02d}:{02d}.{03d}] ({}:{}) {}\n",
-                  "TDICWE"[linlev],
-                  mss / 1000 / 60 / 60 % 24, mss / 1000 / 60 % 60,
-                  mss / 1000 % 60, mss % 1000,
-                  loc.file_name(), loc.line(),
-                  msg);
-    //*os << ansiclr::reset;
-    os->flush();
+    auto rec = new LogRecord;
+    rec->level = level;
+    rec->time = std::chrono::steady_clock::now();
+    rec->loc = loc;
+    if (!tls_node.empty()) {
+        rec->fields.append("{node=").append(tls_node);
+        if (tls_frame >= 0)
+            rec->fields.append(" frame=").append(std::to_string(tls_frame));
+        rec->fields.append("} ");
+    }
+    rec->msg = msg;
+    writer().push(rec);
 }
 
 namespace {
@@ -0,0 +1,68 @@
+#include <zeno/utils/mapped_file.h>
+#ifdef _WIN32
+#include <zeno/utils/fuck_win.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace zeno {
+
+#ifdef _WIN32
+
+ZENO_API mapped_file::mapped_file(std::filesystem::path const &path) {
+    HANDLE hFile = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return;
+    m_hFile = hFile;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+        return;
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping)
+        return;
+    m_hMapping = hMapping;
+    auto p = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!p)
+        return;
+    m_data = static_cast<const char *>(p);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+}
+
+ZENO_API mapped_file::~mapped_file() {
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_hMapping)
+        CloseHandle(m_hMapping);
+    if (m_hFile)
+        CloseHandle(m_hFile);
+}
+
+#else
+
+ZENO_API mapped_file::mapped_file(std::filesystem::path const &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            m_data = static_cast<const char *>(p);
+            m_size = static_cast<std::size_t>(st.st_size);
+        }
+    }
+    ::close(fd);  // the mapping keeps the file alive on its own
+}
+
+ZENO_API mapped_file::~mapped_file() {
+    if (m_data)
+        ::munmap(const_cast<char *>(m_data), m_size);
+}
+
+#endif
+
+}
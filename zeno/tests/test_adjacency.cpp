@@ -0,0 +1,121 @@
+#include <zeno/funcs/PrimitiveAdjacency.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <utility>
+#include <thread>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+// a quad split into two tris along 0-2, plus a dangling line 3-4
+std::shared_ptr<PrimitiveObject> makePrim() {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(5);
+    prim->tris.push_back(vec3i(0, 1, 2));
+    prim->tris.push_back(vec3i(0, 2, 3));
+    prim->lines.push_back(vec2i(3, 4));
+    return prim;
+}
+
+std::vector<int> vertVerts(PrimAdjacency const &adj, int v) {
+    std::vector<int> ret;
+    adj.foreach_vert_vert(v, [&] (int u) { ret.push_back(u); });
+    return ret;
+}
+
+std::vector<int> edgeFaces(PrimAdjacency const &adj, int e) {
+    std::vector<int> ret;
+    adj.foreach_edge_face(e, [&] (int f) { ret.push_back(f); });
+    return ret;
+}
+
+}
+
+TEST_CASE("adjacency of a split quad and a line", "[adjacency]") {
+    auto prim = makePrim();
+    auto adj = primAdjacency(prim.get());
+    REQUIRE(adj->numVerts() == 5);
+    REQUIRE(adj->numFaces() == 3);
+    // lines come first
+    CHECK(adj->faceBegin[PrimAdjacency::Lines] == 0);
+    CHECK(adj->faceBegin[PrimAdjacency::Tris] == 1);
+    CHECK(adj->faceBegin[PrimAdjacency::Quads] == 3);
+
+    REQUIRE(adj->edges.size() == 6);
+    std::vector<std::pair<int, int>> edges;
+    for (auto const &e: adj->edges)
+        edges.emplace_back(e[0], e[1]);
+    CHECK(edges == std::vector<std::pair<int, int>>{{0, 1}, {0, 2}, {0, 3}, {1, 2}, {2, 3}, {3, 4}});
+
+    int diag = adj->findEdge(2, 0);
+    CHECK(diag == 1);
+    CHECK(adj->findEdge(1, 3) == -1);
+    CHECK(edgeFaces(*adj, diag) == std::vector<int>{1, 2});
+    CHECK(edgeFaces(*adj, adj->findEdge(0, 1)) == std::vector<int>{1});
+
+    CHECK(vertVerts(*adj, 0) == std::vector<int>{1, 2, 3});
+    CHECK(vertVerts(*adj, 3) == std::vector<int>{0, 2, 4});
+    CHECK(vertVerts(*adj, 4) == std::vector<int>{3});
+
+    int opposed = 0, boundary = 0;
+    for (int c = 0; c < (int)adj->cornerOpposite.size(); c++) {
+        int o = adj->cornerOpposite[c];
+        if (o < 0) {
+            boundary++;
+            continue;
+        }
+        opposed++;
+        CHECK(adj->cornerOpposite[o] == c);
+        CHECK(adj->cornerEdge[o] == adj->cornerEdge[c]);
+        CHECK(adj->cornerVert[o] == adj->cornerVert[adj->nextCorner(c)]);
+    }
+    // the diagonal, and both half-edges of the line
+    CHECK(opposed == 4);
+    CHECK(boundary == 4);
+}
+
+TEST_CASE("adjacency is cached until the topology changes", "[adjacency]") {
+    auto prim = makePrim();
+    auto adj = primAdjacency(prim.get());
+    CHECK(primAdjacency(prim.get()) == adj);
+
+    prim->verts[0] = vec3f(1, 2, 3);  // moving verts keeps the topology
+    CHECK(primAdjacency(prim.get()) == adj);
+
+    prim->tris[1] = vec3i(0, 3, 2);
+    auto adj2 = primAdjacency(prim.get());
+    CHECK(adj2 != adj);
+    CHECK(adj2->cornerOpposite != adj->cornerOpposite);
+}
+
+TEST_CASE("concurrent adjacency queries agree", "[adjacency]") {
+    auto prim = std::make_shared<PrimitiveObject>();
+    int n = 64;
+    prim->resize(n * n);
+    for (int y = 0; y + 1 < n; y++) {
+        for (int x = 0; x + 1 < n; x++) {
+            int v = y * n + x;
+            prim->tris.push_back(vec3i(v, v + 1, v + n + 1));
+            prim->tris.push_back(vec3i(v, v + n + 1, v + n));
+        }
+    }
+    std::vector<std::shared_ptr<PrimAdjacency const>> got(8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            got[t] = primAdjacency(prim.get());
+        });
+    }
+    for (auto &th: threads)
+        th.join();
+    for (int t = 0; t < 8; t++) {
+        REQUIRE(got[t]);
+        CHECK(got[t]->edges.size() == got[0]->edges.size());
+        CHECK(got[t]->vertVerts == got[0]->vertVerts);
+        CHECK(got[t]->cornerOpposite == got[0]->cornerOpposite);
+    }
+    // (n - 1)^2 quads, each with a diagonal, plus the grid lines
+    CHECK(got[0]->edges.size() == std::size_t(2 * n * (n - 1) + (n - 1) * (n - 1)));
+    CHECK(primAdjacency(prim.get())->topologyHash == got[0]->topologyHash);
+}
@@ -0,0 +1,116 @@
+#include <zeno/funcs/ObjectCodec.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/UserData.h>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cmath>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+std::shared_ptr<PrimitiveObject> makePrim() {
+    auto prim = std::make_shared<PrimitiveObject>();
+    int n = 10000;
+    prim->resize(n);
+    auto &vel = prim->verts.add_attr<vec3f>("vel");
+    auto &clr = prim->verts.add_attr<vec3f>("clr");
+    auto &id = prim->verts.add_attr<int>("id");
+    auto &w = prim->verts.add_attr<float>("w");
+    for (int i = 0; i < n; i++) {
+        float t = i * 0.01f;
+        prim->verts[i] = vec3f(std::sin(t) * 10, t, std::cos(t) * -10);
+        vel[i] = vec3f(std::cos(t), 1, -std::sin(t));
+        clr[i] = vec3f(t / n, 0.5f, 1.f / (i + 1));
+        id[i] = i * 7 - 3;
+        w[i] = std::sqrt(t);
+    }
+    for (int i = 0; i + 2 < n; i++)
+        prim->tris.push_back(vec3i(i, i + 1, i + 2));
+    prim->tris.add_attr<vec2f>("uv0").assign(prim->tris.size(), vec2f(0.25f, 0.75f));
+    for (int i = 0; i < n; i++)
+        prim->loops.push_back(i);
+    prim->polys.push_back(vec2i(0, n / 2));
+    prim->polys.push_back(vec2i(n / 2, n - n / 2));
+    prim->userData().set2("frame", 42);
+    return prim;
+}
+
+std::shared_ptr<PrimitiveObject> roundTrip(PrimitiveObject const *prim, ObjectCodecOptions const &opts, size_t *size = nullptr) {
+    std::vector<char> buf;
+    REQUIRE(encodeObject(prim, buf, opts));
+    if (size)
+        *size = buf.size();
+    auto obj = std::dynamic_pointer_cast<PrimitiveObject>(decodeObject(buf.data(), buf.size()));
+    REQUIRE(obj);
+    return obj;
+}
+
+template <class T>
+bool sameBits(std::vector<T> const &a, std::vector<T> const &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [] (T const &x, T const &y) {
+        return std::memcmp(&x, &y, sizeof(T)) == 0;
+    });
+}
+
+template <class T>
+std::vector<T> const &attr(AttrVector<vec3f> const &arr, std::string const &name) {
+    return arr.attr<T>(name);
+}
+
+void checkExact(PrimitiveObject const &a, PrimitiveObject const &b, bool exactPosVel) {
+    if (exactPosVel) {
+        CHECK(sameBits(a.verts.values, b.verts.values));
+        CHECK(sameBits(attr<vec3f>(a.verts, "vel"), attr<vec3f>(b.verts, "vel")));
+    }
+    CHECK(sameBits(attr<vec3f>(a.verts, "clr"), attr<vec3f>(b.verts, "clr")));
+    CHECK(sameBits(attr<int>(a.verts, "id"), attr<int>(b.verts, "id")));
+    CHECK(sameBits(attr<float>(a.verts, "w"), attr<float>(b.verts, "w")));
+    CHECK(sameBits(a.tris.values, b.tris.values));
+    CHECK(sameBits(a.tris.attr<vec2f>("uv0"), b.tris.attr<vec2f>("uv0")));
+    CHECK(sameBits(a.loops.values, b.loops.values));
+    CHECK(sameBits(a.polys.values, b.polys.values));
+    CHECK(b.userData().get2<int>("frame", 0) == 42);
+}
+
+}
+
+TEST_CASE("primitives round trip through the codec", "[codec]") {
+    auto prim = makePrim();
+    auto const &cprim = *prim;
+    size_t rawSize = 0, compressedSize = 0;
+
+    ObjectCodecOptions opts;
+    auto raw = roundTrip(prim.get(), opts, &rawSize);
+    checkExact(cprim, std::as_const(*raw), true);
+
+    opts.compress = true;
+    auto compressed = roundTrip(prim.get(), opts, &compressedSize);
+    checkExact(cprim, std::as_const(*compressed), true);
+    CHECK(compressedSize < rawSize);
+}
+
+TEST_CASE("quantized primitives stay within the error bound", "[codec]") {
+    auto prim = makePrim();
+    auto const &cprim = *prim;
+    ObjectCodecOptions opts;
+    opts.compress = true;
+    opts.quantizeError = 1e-3f;
+    auto obj = roundTrip(prim.get(), opts);
+    auto const &cobj = *obj;
+    checkExact(cprim, cobj, false);
+
+    auto maxError = [] (std::vector<vec3f> const &a, std::vector<vec3f> const &b) {
+        REQUIRE(a.size() == b.size());
+        float err = 0;
+        for (size_t i = 0; i < a.size(); i++)
+            for (int c = 0; c < 3; c++)
+                err = std::max(err, std::abs(a[i][c] - b[i][c]));
+        return err;
+    };
+    CHECK(maxError(cprim.verts.values, cobj.verts.values) <= opts.quantizeError);
+    CHECK(maxError(attr<vec3f>(cprim.verts, "vel"), attr<vec3f>(cobj.verts, "vel")) <= opts.quantizeError);
+}
@@ -0,0 +1,74 @@
+#include <zeno/utils/cow_vector.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <variant>
+#include <utility>
+#include <thread>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+static float sum(std::vector<float> const &arr) {
+    float ret = 0;
+    for (auto x: arr)
+        ret += x;
+    return ret;
+}
+
+TEST_CASE("copies share their buffer until written", "[cow]") {
+    cow_vector<float> a{1, 2, 3};
+    auto b = a;
+    CHECK(a.shared());
+    CHECK(b.get().data() == a.get().data());
+
+    b.mut()[0] = 10;
+    CHECK(!a.shared());
+    CHECK(!b.shared());
+    CHECK(a.get()[0] == 1);
+    CHECK(b.get()[0] == 10);
+}
+
+// the conversion picked by such a call used to be the mutable one, which detached
+TEST_CASE("reads through std::vector const & do not detach", "[cow]") {
+    cow_vector<float> a{1, 2, 3};
+    auto b = a;
+    CHECK(sum(b) == 6);
+    std::variant<cow_vector<float>, cow_vector<int>> var = b;
+    std::visit([] (auto &arr) {
+        std::vector<std::decay_t<decltype(arr[0])>> const &vec = arr;
+        CHECK(vec.size() == 3);
+    }, var);
+    CHECK(b.shared());
+    CHECK(b.get().data() == a.get().data());
+}
+
+TEST_CASE("concurrent first writes end up on one private buffer", "[cow]") {
+    cow_vector<int> a(1000, 1);
+    auto b = a;
+    std::vector<int *> seen(8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&, t] {
+            seen[t] = b.mut().data();
+        });
+    }
+    for (auto &th: threads)
+        th.join();
+    for (int t = 1; t < 8; t++)
+        CHECK(seen[t] == seen[0]);
+    CHECK(seen[0] != a.get().data());
+    CHECK(!a.shared());
+}
+
+TEST_CASE("cloned primitives share attributes until written", "[cow]") {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(4);
+    prim->verts.add_attr<float>("w", 1.f);
+    auto copy = std::static_pointer_cast<PrimitiveObject>(prim->clone());
+
+    auto const &ccopy = *copy;
+    CHECK(ccopy.verts.attr<float>("w").data() == std::as_const(*prim).verts.attr<float>("w").data());
+
+    copy->verts.attr<float>("w")[0] = 2.f;
+    CHECK(std::as_const(*prim).verts.attr<float>("w")[0] == 1.f);
+    CHECK(std::as_const(*copy).verts.attr<float>("w")[0] == 2.f);
+}
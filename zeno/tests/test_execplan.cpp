@@ -0,0 +1,89 @@
+#include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/extra/ExecPlan.h>
+#include <zeno/types/NumericObject.h>
+#include <set>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+static const char *program = R"([
+    ["addNode", "NumericInt", "a"], ["setNodeParam", "a", "value", 2], ["completeNode", "a"],
+    ["addNode", "NumericInt", "b"], ["setNodeParam", "b", "value", 3], ["completeNode", "b"],
+    ["addNode", "NumericOperator", "mul"], ["setNodeParam", "mul", "op_type", "mul"],
+    ["bindNodeInput", "mul", "lhs", "a", "value"], ["bindNodeInput", "mul", "rhs", "b", "value"],
+    ["completeNode", "mul"]
+])";
+
+static int result(Graph *g, std::string const &id) {
+    g->applyNodes({id});
+    return safe_dynamic_cast<NumericObject>(g->getNodeOutput(id, "ret"))->get<int>();
+}
+
+TEST_CASE("plan slots and resolved inputs", "[execplan]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(program);
+    auto plan = g->getExecPlan();
+    REQUIRE(plan->slots.size() == 3);
+
+    std::set<int> indices;
+    for (auto const &[id, node]: g->nodes) {
+        REQUIRE(node->execIndex >= 0);
+        REQUIRE(node->execIndex < 3);
+        CHECK(plan->slots[node->execIndex].node == node.get());
+        indices.insert(node->execIndex);
+    }
+    CHECK(indices.size() == 3);
+
+    auto inputs = plan->inputsOf(g->nodes.at("mul").get());
+    REQUIRE(inputs);
+    REQUIRE(inputs->size() == 2);
+    for (auto const &in: *inputs) {
+        CHECK(in.src == g->nodes.at(*in.sn).get());
+        CHECK(*in.ss == "value");
+    }
+    CHECK(result(g.get(), "mul") == 6);
+}
+
+TEST_CASE("plan follows graph edits and keeps slots", "[execplan]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(program);
+    CHECK(result(g.get(), "mul") == 6);
+    auto mul = g->nodes.at("mul").get();
+    int mulIndex = mul->execIndex;
+    int bIndex = g->nodes.at("b")->execIndex;
+
+    // relinking rebuilds the plan, the new source must be pulled
+    g->addNode("NumericInt", "c");
+    g->setNodeParam("c", "value", 5);
+    g->completeNode("c");
+    g->bindNodeInput("mul", "rhs", "c", "value");
+    CHECK(result(g.get(), "mul") == 10);
+    CHECK(mul->execIndex == mulIndex);
+    CHECK(g->nodes.at("b")->execIndex == bIndex);
+
+    g->removeNode("b");
+    auto plan = g->getExecPlan();
+    CHECK(mul->execIndex == mulIndex);
+    CHECK(plan->slots.at(bIndex).node == nullptr);
+
+    // bound to a node that no longer exists
+    g->bindNodeInput("mul", "rhs", "b", "value");
+    auto inputs = g->getExecPlan()->inputsOf(mul);
+    REQUIRE(inputs);
+    bool dangling = false;
+    for (auto const &in: *inputs)
+        dangling = dangling || (*in.sn == "b" && !in.src);
+    CHECK(dangling);
+}
+
+TEST_CASE("nodes outside of the plan are not resolved by it", "[execplan]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(program);
+    auto plan = g->getExecPlan();
+    auto other = getSession().createGraph();
+    other->loadGraph(program);
+    other->getExecPlan();
+    // same slot numbers, other graph
+    CHECK(plan->inputsOf(other->nodes.at("mul").get()) == nullptr);
+}
@@ -0,0 +1,112 @@
+#include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/para/thread_pool.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/ListObject.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <algorithm>
+#include <utility>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+struct TestRangeList : INode {
+    virtual void apply() override {
+        auto lst = std::make_shared<ListObject>();
+        for (int i = 0; i < get_input2<int>("count"); i++)
+            lst->arr.push_back(std::make_shared<NumericObject>(i));
+        set_output("list", std::move(lst));
+    }
+};
+
+ZENDEFNODE(TestRangeList, {
+    {{"int", "count"}},
+    {"list"},
+    {},
+    {"test"},
+});
+
+struct TestMakePrim : INode {
+    virtual void apply() override {
+        auto prim = std::make_shared<PrimitiveObject>();
+        prim->resize(16);
+        prim->verts.add_attr<float>("tmp");
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(TestMakePrim, {
+    {},
+    {"prim"},
+    {},
+    {"test"},
+});
+
+std::atomic<int> stampInstances{0};
+
+// writes the element into a loop-invariant primitive in place, then reads it back
+struct TestStamp : INode {
+    TestStamp() {
+        stampInstances++;
+    }
+
+    virtual void apply() override {
+        auto prim = get_input<PrimitiveObject>("prim");
+        float value = get_input<NumericObject>("object")->get<int>();
+        auto &tmp = prim->verts.attr<float>("tmp");
+        for (auto &x: tmp)
+            x = value;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        float sum = 0;
+        for (auto x: tmp)
+            sum += x;
+        set_output("value", std::make_shared<NumericObject>(sum / tmp.size()));
+    }
+};
+
+ZENDEFNODE(TestStamp, {
+    {"prim", "object"},
+    {"value"},
+    {},
+    {"test"},
+});
+
+}
+
+TEST_CASE("parallel foreach gives each worker its own invariant objects", "[foreach]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(R"([
+        ["addNode", "TestRangeList", "l"], ["setNodeInput", "l", "count", 256], ["completeNode", "l"],
+        ["addNode", "TestMakePrim", "p"], ["completeNode", "p"],
+        ["addNode", "BeginForEach", "b"], ["bindNodeInput", "b", "list", "l", "list"], ["completeNode", "b"],
+        ["addNode", "TestStamp", "s"], ["bindNodeInput", "s", "prim", "p", "prim"],
+        ["bindNodeInput", "s", "object", "b", "object"], ["completeNode", "s"],
+        ["addNode", "EndForEach", "e"], ["bindNodeInput", "e", "object", "s", "value"],
+        ["bindNodeInput", "e", "FOR", "b", "FOR"], ["setNodeParam", "e", "parallel", true],
+        ["setNodeParam", "e", "doConcat", false], ["completeNode", "e"]
+    ])");
+    int before = stampInstances;
+    g->applyNodes({"e"});
+    // one body per worker graph, however many chunks the list is split into
+    CHECK(stampInstances - before >= 1);
+    CHECK(stampInstances - before <= (int)thread_pool::global().concurrency());
+
+    auto lst = safe_dynamic_cast<ListObject>(g->getNodeOutput("e", "list"));
+    REQUIRE(lst->arr.size() == 256);
+    int mismatches = 0;
+    for (int i = 0; i < 256; i++) {
+        if (safe_dynamic_cast<NumericObject>(lst->arr[i])->get<float>() != (float)i)
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    // workers modified their own clones
+    auto prim = safe_dynamic_cast<PrimitiveObject>(g->getNodeOutput("p", "prim"));
+    auto const &tmp = std::as_const(prim->verts).attr<float>("tmp");
+    CHECK(std::count(tmp.begin(), tmp.end(), 0.f) == tmp.size());
+}
@@ -0,0 +1,75 @@
+#include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/types/NumericObject.h>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+// resolves its ref() in apply(), the way ZenoFX wrangles do in preApplyRefs
+struct TestRefReader : INode {
+    virtual void apply() override {
+        auto code = get_input2<std::string>("code");
+        auto beg = code.find("ref(") + 4, slash = code.find('/', beg), end = code.find(')', slash);
+        auto ident = code.substr(beg, slash - beg);
+        auto param = code.substr(slash + 1, end - slash - 1);
+        for (auto const &[id, node]: graph->nodes) {
+            if (id.size() >= ident.size() && id.compare(id.size() - ident.size(), ident.size(), ident) == 0) {
+                set_output("ret", node->resolveInput(param));
+                return;
+            }
+        }
+    }
+};
+
+ZENDEFNODE(TestRefReader, {
+    {{"string", "code", ""}, {"dep"}},
+    {"ret"},
+    {},
+    {"test"},
+});
+
+}
+
+// outputs released after the last consumer pulled them must still be there next frame,
+// ExtractDict only sets the outputs the editor added with addNodeOutput
+TEST_CASE("dynamic outputs survive release", "[liveness]") {
+    auto g = getSession().createGraph();
+    g->releaseOutputs = true;
+    g->loadGraph(R"([
+        ["addNode", "NumericInt", "n"], ["setNodeParam", "n", "value", 3], ["completeNode", "n"],
+        ["addNode", "MakeSmallDict", "d"], ["setNodeInput", "d", "key0", "a"],
+        ["bindNodeInput", "d", "obj0", "n", "value"], ["completeNode", "d"],
+        ["addNode", "ExtractDict", "x"], ["bindNodeInput", "x", "dict", "d", "dict"],
+        ["addNodeOutput", "x", "a"], ["completeNode", "x"],
+        ["addNode", "NumericOperator", "sink"], ["setNodeParam", "sink", "op_type", "add"],
+        ["bindNodeInput", "sink", "lhs", "x", "a"], ["bindNodeInput", "sink", "rhs", "n", "value"],
+        ["completeNode", "sink"]
+    ])");
+    for (int frame = 0; frame < 2; frame++) {
+        g->applyNodes({"sink"});
+        auto ret = safe_dynamic_cast<NumericObject>(g->getNodeOutput("sink", "ret"));
+        CHECK(ret->get<int>() == 6);
+    }
+}
+
+// the producer of a referenced input outlives its counted consumers
+TEST_CASE("ref() in a plain string input pins its target", "[liveness]") {
+    auto g = getSession().createGraph();
+    g->releaseOutputs = true;
+    g->loadGraph(R"([
+        ["addNode", "NumericInt", "n"], ["setNodeParam", "n", "value", 3], ["completeNode", "n"],
+        ["addNode", "NumericOperator", "m"], ["setNodeParam", "m", "op_type", "add"],
+        ["bindNodeInput", "m", "lhs", "n", "value"], ["bindNodeInput", "m", "rhs", "n", "value"],
+        ["completeNode", "m"],
+        ["addNode", "TestRefReader", "r"], ["setNodeInput", "r", "code", "@a = ref(m/lhs) + 1"],
+        ["bindNodeInput", "r", "dep", "m", "ret"], ["completeNode", "r"]
+    ])");
+    for (int frame = 0; frame < 2; frame++) {
+        g->applyNodes({"r"});
+        auto ret = std::dynamic_pointer_cast<NumericObject>(g->getNodeOutput("r", "ret"));
+        REQUIRE(ret);
+        CHECK(ret->get<int>() == 3);
+    }
+}
@@ -0,0 +1,86 @@
+#include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/core/INode.h>
+#include <zeno/extra/MemoCache.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/InstancingObject.h>
+#include <zeno/types/ListObject.h>
+#include <zeno/funcs/ObjectCodec.h>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+// PrimRandomize with seed -1 isn't memoized and modifies the cube in place,
+// the reduction after it must not be served the result of the previous frame
+TEST_CASE("in-place modification by an unmemoized node misses", "[memocache]") {
+    getSession().memoCache->setEnabled(true);
+    auto g = getSession().createGraph();
+    g->loadGraph(R"([
+        ["addNode", "CreateCube", "c"], ["setNodeInput", "c", "position", [0, 0, 0]],
+        ["setNodeInput", "c", "scaleSize", [1, 1, 1]], ["setNodeInput", "c", "rotate", [0, 0, 0]],
+        ["setNodeInput", "c", "hasNormal", false], ["setNodeInput", "c", "hasVertUV", false],
+        ["setNodeInput", "c", "isFlipFace", false], ["setNodeInput", "c", "div_w", 2],
+        ["setNodeInput", "c", "div_h", 2], ["setNodeInput", "c", "div_d", 2],
+        ["setNodeInput", "c", "size", 1.0], ["setNodeInput", "c", "quads", false],
+        ["completeNode", "c"],
+        ["addNode", "PrimRandomize", "r"], ["bindNodeInput", "r", "prim", "c", "prim"],
+        ["setNodeInput", "r", "attr", "tmp"], ["setNodeInput", "r", "dirAttr", ""],
+        ["setNodeInput", "r", "seedAttr", ""], ["setNodeInput", "r", "base", 0.0],
+        ["setNodeInput", "r", "scale", 1.0], ["setNodeInput", "r", "seed", -1],
+        ["setNodeInput", "r", "randType", "scalar01"], ["completeNode", "r"],
+        ["addNode", "PrimReduction", "s"], ["bindNodeInput", "s", "prim", "r", "prim"],
+        ["setNodeInput", "s", "attrName", "tmp"], ["setNodeInput", "s", "op", "avg"],
+        ["completeNode", "s"]
+    ])");
+    float results[2];
+    for (int frame = 0; frame < 2; frame++) {
+        g->applyNodes({"s"});
+        results[frame] = safe_dynamic_cast<NumericObject>(g->getNodeOutput("s", "result"))->get<float>();
+    }
+    CHECK(results[0] != results[1]);
+    getSession().memoCache->setEnabled(false);
+}
+
+TEST_CASE("side-effecting nodes are not memoized", "[memocache]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(R"([
+        ["addNode", "PrintMessage", "p"], ["completeNode", "p"],
+        ["addNode", "NumericInt", "n"], ["completeNode", "n"]
+    ])");
+    CHECK(!g->nodes.at("p")->isPure());
+    CHECK(!g->nodes.at("p")->isMemoizable());
+    CHECK(g->nodes.at("n")->isMemoizable());
+}
+
+TEST_CASE("memoization is opt-in per node class", "[memocache]") {
+    auto g = getSession().createGraph();
+    g->loadGraph(R"([
+        ["addNode", "PrimitiveTransform", "t"], ["completeNode", "t"]
+    ])");
+    CHECK(g->nodes.at("t")->isPure());
+    CHECK(!g->nodes.at("t")->isMemoizable());
+}
+
+namespace {
+struct TestPrimitiveSubclass : PrimitiveObject {
+    int extra = 0;
+};
+}
+
+// the codec would give these back as a plain PrimitiveObject
+TEST_CASE("objects the codec can't restore as is are not cached", "[memocache]") {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(3);
+    CHECK(canEncodeObject(prim.get()));
+
+    auto sub = std::make_shared<TestPrimitiveSubclass>();
+    CHECK(!canEncodeObject(sub.get()));
+
+    prim->inst = std::make_shared<InstancingObject>();
+    CHECK(!canEncodeObject(prim.get()));
+
+    auto lst = std::make_shared<ListObject>();
+    lst->arr.push_back(sub);
+    CHECK(!canEncodeObject(lst.get()));
+}
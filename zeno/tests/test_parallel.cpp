@@ -0,0 +1,91 @@
+#include <zeno/zeno.h>
+#include <zeno/core/Graph.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/FunctionObject.h>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+// calls its function like NonlinearSolver does, without being a ContextManagedNode
+struct TestCallTwice : INode {
+    virtual void apply() override {
+        auto func = get_input<FunctionObject>("function");
+        int sum = 0;
+        for (int x: {1, 10}) {
+            auto rets = func->call({{"x", std::make_shared<NumericObject>(x)}});
+            sum += safe_dynamic_cast<NumericObject>(rets.at("y"))->get<int>();
+        }
+        set_output("ret", std::make_shared<NumericObject>(sum));
+    }
+};
+
+ZENDEFNODE(TestCallTwice, {
+    {"function"},
+    {"ret"},
+    {},
+    {"test"},
+});
+
+}
+
+// y = x + 1, called with x = 1 and x = 10
+TEST_CASE("function bodies are evaluated again on each call", "[parallel]") {
+    auto g = getSession().createGraph();
+    g->parallelExec = true;
+    g->loadGraph(R"([
+        ["addNode", "FuncBegin", "fb"], ["completeNode", "fb"],
+        ["addNode", "ExtractDict", "x"], ["bindNodeInput", "x", "dict", "fb", "args"],
+        ["addNodeOutput", "x", "x"], ["completeNode", "x"],
+        ["addNode", "NumericInt", "one"], ["setNodeParam", "one", "value", 1], ["completeNode", "one"],
+        ["addNode", "NumericOperator", "add"], ["setNodeParam", "add", "op_type", "add"],
+        ["bindNodeInput", "add", "lhs", "x", "x"], ["bindNodeInput", "add", "rhs", "one", "value"],
+        ["completeNode", "add"],
+        ["addNode", "MakeSmallDict", "rets"], ["setNodeInput", "rets", "key0", "y"],
+        ["bindNodeInput", "rets", "obj0", "add", "ret"], ["completeNode", "rets"],
+        ["addNode", "FuncEnd", "fe"], ["bindNodeInput", "fe", "rets", "rets", "dict"],
+        ["bindNodeInput", "fe", "FUNC", "fb", "FUNC"], ["completeNode", "fe"],
+        ["addNode", "TestCallTwice", "call"], ["bindNodeInput", "call", "function", "fe", "function"],
+        ["completeNode", "call"],
+        ["addNode", "NumericInt", "side"], ["setNodeParam", "side", "value", 5], ["completeNode", "side"],
+        ["addNode", "NumericOperator", "sum"], ["setNodeParam", "sum", "op_type", "add"],
+        ["bindNodeInput", "sum", "lhs", "call", "ret"], ["bindNodeInput", "sum", "rhs", "side", "value"],
+        ["completeNode", "sum"]
+    ])");
+    for (int frame = 0; frame < 2; frame++) {
+        g->applyNodes({"sum"});
+        auto ret = safe_dynamic_cast<NumericObject>(g->getNodeOutput("sum", "ret"));
+        CHECK(ret->get<int>() == 2 + 11 + 5);
+    }
+}
+
+// a wide graph gives the same result as the serial executor
+TEST_CASE("parallel and serial executors agree", "[parallel]") {
+    std::string json = R"([["addNode", "NumericInt", "n"], ["setNodeParam", "n", "value", 1], ["completeNode", "n"])";
+    auto addOp = [&] (std::string const &id, std::string const &lhs, std::string const &rhs) {
+        json += R"(, ["addNode", "NumericOperator", ")" + id + R"("], ["setNodeParam", ")" + id + R"(", "op_type", "add"])"
+            + R"(, ["bindNodeInput", ")" + id + R"(", "lhs", )" + lhs + "]"
+            + R"(, ["bindNodeInput", ")" + id + R"(", "rhs", )" + rhs + "]"
+            + R"(, ["completeNode", ")" + id + R"("])";
+    };
+    // b_i = n + n side by side, a_i = a_(i-1) + b_i
+    std::string prev = R"("n", "value")";
+    for (int i = 0; i < 64; i++) {
+        auto b = "b" + std::to_string(i), a = "a" + std::to_string(i);
+        addOp(b, R"("n", "value")", R"("n", "value")");
+        addOp(a, prev, "\"" + b + R"(", "ret")");
+        prev = "\"" + a + R"(", "ret")";
+    }
+    json += "]";
+    int results[2];
+    for (int parallel = 0; parallel < 2; parallel++) {
+        auto g = getSession().createGraph();
+        g->parallelExec = parallel;
+        g->loadGraph(json.c_str());
+        g->applyNodes({"a63"});
+        results[parallel] = safe_dynamic_cast<NumericObject>(g->getNodeOutput("a63", "ret"))->get<int>();
+    }
+    CHECK(results[0] == 1 + 64 * 2);
+    CHECK(results[1] == results[0]);
+}
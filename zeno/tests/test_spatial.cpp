@@ -0,0 +1,143 @@
+#include <zeno/types/SpatialIndexObject.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <thread>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+std::shared_ptr<PrimitiveObject> makeCloud(int n, unsigned seed) {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(n);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unif(-1.f, 1.f);
+    for (auto &p: prim->verts)
+        p = vec3f(unif(rng), unif(rng), unif(rng));
+    return prim;
+}
+
+// a wavy grid of tris over [-1, 1]^2 in the xz plane
+std::shared_ptr<PrimitiveObject> makeSurface(int n) {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(n * n);
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            float u = x * 2.f / (n - 1) - 1, v = y * 2.f / (n - 1) - 1;
+            prim->verts[y * n + x] = vec3f(u, 0.2f * std::sin(3 * u) * std::cos(2 * v), v);
+        }
+    }
+    for (int y = 0; y + 1 < n; y++) {
+        for (int x = 0; x + 1 < n; x++) {
+            int i = y * n + x;
+            prim->tris.push_back(vec3i(i, i + 1, i + n + 1));
+            prim->tris.push_back(vec3i(i, i + n + 1, i + n));
+        }
+    }
+    return prim;
+}
+
+std::vector<float> bruteDists(SpatialIndexObject const &index, vec3f const &pos) {
+    std::vector<float> dists;
+    for (int e = 0; e < (int)index.size(); e++) {
+        vec3f bary;
+        dists.push_back(length(index.closestOnElement(e, pos, bary) - pos));
+    }
+    std::sort(dists.begin(), dists.end());
+    return dists;
+}
+
+void checkPointQueries(SpatialIndexObject const &index) {
+    auto queries = makeCloud(50, 7);
+    std::vector<SpatialIndexObject::Hit> hits;
+    for (auto const &q: queries->verts) {
+        auto dists = bruteDists(index, q);
+        auto hit = index.closest(q);
+        REQUIRE(hit.id >= 0);
+        CHECK(hit.dist == Approx(dists[0]).margin(1e-6));
+
+        index.knn(q, 5, 10.f, hits);
+        REQUIRE(hits.size() == 5);
+        for (int k = 0; k < 5; k++)
+            CHECK(hits[k].dist == Approx(dists[k]).margin(1e-6));
+
+        index.radius(q, 0.3f, hits);
+        auto inside = std::count_if(dists.begin(), dists.end(), [] (float d) { return d <= 0.3f; });
+        CHECK(hits.size() == (std::size_t)inside);
+    }
+}
+
+}
+
+TEST_CASE("point queries match brute force", "[spatial]") {
+    auto prim = makeCloud(2000, 1);
+    SECTION("bvh") {
+        checkPointQueries(*SpatialIndexObject::build(prim.get(), SpatialIndexObject::Points));
+    }
+    SECTION("hash grid") {
+        checkPointQueries(*SpatialIndexObject::build(prim.get(), SpatialIndexObject::Points,
+                                                     SpatialIndexObject::HashGrid, 0.1f));
+    }
+}
+
+TEST_CASE("triangle queries match brute force", "[spatial]") {
+    auto prim = makeSurface(24);
+    auto index = SpatialIndexObject::build(prim.get(), SpatialIndexObject::Tris);
+    checkPointQueries(*index);
+
+    // straight down onto the surface, whose height is known at every x, z
+    for (float x: {-0.7f, 0.f, 0.33f}) {
+        for (float z: {-0.5f, 0.25f, 0.9f}) {
+            auto hit = index->raycast(vec3f(x, 1, z), vec3f(0, -2, 0));
+            REQUIRE(hit.id >= 0);
+            CHECK(hit.pos[0] == Approx(x));
+            CHECK(hit.pos[2] == Approx(z));
+            CHECK(hit.pos[1] == Approx(1 - hit.dist).margin(1e-5));
+            CHECK(hit.pos[1] == Approx(0.2f * std::sin(3 * x) * std::cos(2 * z)).margin(0.02));
+        }
+    }
+    CHECK(index->raycast(vec3f(0, 1, 0), vec3f(0, 1, 0)).id == -1);
+    CHECK(index->raycast(vec3f(0, 1, 0), vec3f(0, -1, 0), 0.5f).id == -1);
+}
+
+TEST_CASE("refit follows moved verts until the topology changes", "[spatial]") {
+    auto prim = makeSurface(16);
+    auto index = SpatialIndexObject::build(prim.get(), SpatialIndexObject::Tris);
+    for (auto &p: prim->verts)
+        p[1] += 5;
+    REQUIRE(index->refit(prim.get()));
+    auto hit = index->raycast(vec3f(0.1f, 10, 0.1f), vec3f(0, -1, 0));
+    REQUIRE(hit.id >= 0);
+    CHECK(hit.pos[1] > 4);
+    checkPointQueries(*index);
+
+    prim->tris.resize(prim->tris.size() - 1);
+    CHECK(!index->refit(prim.get()));
+}
+
+TEST_CASE("concurrent queries agree with serial ones", "[spatial]") {
+    auto prim = makeCloud(5000, 3);
+    auto index = SpatialIndexObject::build(prim.get(), SpatialIndexObject::Points);
+    auto queries = makeCloud(4000, 5);
+    std::vector<int> serial(queries->size()), parallel(queries->size());
+    for (std::size_t i = 0; i < queries->size(); i++)
+        serial[i] = index->closest(queries->verts[i]).id;
+
+    auto order = index->batchOrder(queries->verts.values);
+    REQUIRE(order.size() == queries->size());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (std::size_t k = t; k < order.size(); k += 4) {
+                auto i = order[k];
+                parallel[i] = index->closest(queries->verts[i]).id;
+            }
+        });
+    }
+    for (auto &th: threads)
+        th.join();
+    CHECK(parallel == serial);
+}
@@ -0,0 +1,101 @@
+#include <zeno/extra/GlobalComm.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/NumericObject.h>
+#include <zeno/types/StringObject.h>
+#include <filesystem>
+#include "Catch2.hpp"
+
+using namespace zeno;
+
+namespace {
+
+struct TempDir {
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "zeno_test_zencache";
+
+    TempDir() {
+        std::filesystem::remove_all(path);
+    }
+
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+};
+
+GlobalComm::ViewObjects makeFrame(float value) {
+    auto prim = std::make_shared<PrimitiveObject>();
+    prim->resize(100);
+    auto &clr = prim->verts.add_attr<vec3f>("clr");
+    for (int i = 0; i < 100; i++) {
+        prim->verts[i] = vec3f(i, value, -i);
+        clr[i] = vec3f(value);
+    }
+    prim->tris.push_back(vec3i(0, 1, 2));
+    GlobalComm::ViewObjects objs;
+    objs.try_emplace("0-TestPrim:prim", std::move(prim));
+    objs.try_emplace("0-TestNum:value", std::make_shared<NumericObject>(value));
+    objs.try_emplace("0-TestStr:value", std::make_shared<StringObject>("hello"));
+    return objs;
+}
+
+// loads back frame 0 written in dir, leaving the objects not needed undecoded
+std::map<std::string, std::shared_ptr<IObject>> loadFrame(GlobalComm &comm, std::function<bool(std::string const &)> const &isNeeded = {}) {
+    std::map<std::string, std::shared_ptr<IObject>> ret;
+    bool valid = false;
+    comm.load_objects(0, [&] (auto const &objs) {
+        ret = objs;
+        return true;
+    }, valid, isNeeded);
+    CHECK(valid);
+    return ret;
+}
+
+}
+
+TEST_CASE("zencache frames round trip", "[zencache]") {
+    TempDir dir;
+    auto objs = makeFrame(3.f);
+    GlobalComm::writeFrameCache(dir.path.string(), 0, objs, false, false);
+
+    GlobalComm comm;
+    comm.frameCache(dir.path.string(), 1);
+    comm.initFrameRange(0, 1);
+    comm.newFrame();
+    comm.finishFrame();
+    auto loaded = loadFrame(comm);
+    REQUIRE(loaded.size() == 3);
+
+    auto prim = std::dynamic_pointer_cast<PrimitiveObject>(loaded.at("0-TestPrim:prim"));
+    REQUIRE(prim);
+    REQUIRE(prim->verts.size() == 100);
+    CHECK(alltrue(prim->verts[42] == vec3f(42, 3, -42)));
+    CHECK(alltrue(std::as_const(prim->verts).attr<vec3f>("clr")[99] == vec3f(3)));
+    REQUIRE(prim->tris.size() == 1);
+    CHECK(alltrue(prim->tris[0] == vec3i(0, 1, 2)));
+    CHECK(std::dynamic_pointer_cast<NumericObject>(loaded.at("0-TestNum:value"))->get<float>() == 3.f);
+    CHECK(std::dynamic_pointer_cast<StringObject>(loaded.at("0-TestStr:value"))->get() == "hello");
+}
+
+// the lazy objects of a loaded frame still map the old file while the frame is cached again
+TEST_CASE("zencache rewrite keeps lazy objects of the old file", "[zencache]") {
+    TempDir dir;
+    auto objs = makeFrame(1.f);
+    GlobalComm::writeFrameCache(dir.path.string(), 0, objs, false, false);
+
+    GlobalComm comm;
+    comm.frameCache(dir.path.string(), 1);
+    comm.initFrameRange(0, 1);
+    comm.newFrame();
+    comm.finishFrame();
+    auto lazy = loadFrame(comm, [] (std::string const &) { return false; });
+    CHECK(lazy.at("0-TestNum:value") == nullptr);
+
+    auto objs2 = makeFrame(2.f);
+    GlobalComm::writeFrameCache(dir.path.string(), 0, objs2, false, false);
+
+    auto loaded = loadFrame(comm);
+    CHECK(std::dynamic_pointer_cast<NumericObject>(loaded.at("0-TestNum:value"))->get<float>() == 1.f);
+    auto prim = std::dynamic_pointer_cast<PrimitiveObject>(loaded.at("0-TestPrim:prim"));
+    REQUIRE(prim);
+    CHECK(alltrue(prim->verts[42] == vec3f(42, 1, -42)));
+}